@@ -0,0 +1,802 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "AppendedFileWriter.h"
+#include "TypeConverter.h"
+#include "Hash.h"
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <map>
+
+namespace xmlw {
+
+/*
+ * Order of sections in the piece. Data sets are written down into the appended
+ * section in the same order.
+ */
+static const char *section_order[] = { "PointData", "CellData", "Points", "Coordinates", "Cells" };
+static const size_t num_of_sections = sizeof(section_order) / sizeof(section_order[0]);
+
+/* Marks data sets which are written themselves (not replaced by an identical data set) */
+static const size_t no_duplicate = std::numeric_limits<size_t>::max();
+
+AppendedFileWriter::AppendedFileWriter(const std::string _grid_type) :
+        grid_type(_grid_type), has_extent(false), has_whole_extent(false), backend(BACKEND_STREAM),
+        direct_io(false), direct_io_threshold(1 << 22), float64_conversion(CONVERSION_NONE),
+        deduplicate(false), header_padding(0) {
+    for(size_t n = 0; n < 6; ++n) {
+        extent[n] = 0;
+        whole_extent[n] = 0;
+    }
+}
+
+AppendedFileWriter *AppendedFileWriter::Clone() const {
+    return new AppendedFileWriter(*this);
+}
+
+void AppendedFileWriter::SetPiece(const size_t num_points, const size_t num_cells) {
+    piece_attributes = " NumberOfPoints=\"" + std::to_string(num_points)
+            + "\" NumberOfCells=\"" + std::to_string(num_cells) + "\"";
+}
+
+void AppendedFileWriter::SetExtent(const size_t i0, const size_t i1, const size_t j0, const size_t j1,
+        const size_t k0, const size_t k1) {
+    extent[0] = i0; extent[1] = i1;
+    extent[2] = j0; extent[3] = j1;
+    extent[4] = k0; extent[5] = k1;
+    has_extent = true;
+}
+
+void AppendedFileWriter::SetWholeExtent(const size_t i0, const size_t i1, const size_t j0, const size_t j1,
+        const size_t k0, const size_t k1) {
+    whole_extent[0] = i0; whole_extent[1] = i1;
+    whole_extent[2] = j0; whole_extent[3] = j1;
+    whole_extent[4] = k0; whole_extent[5] = k1;
+    has_whole_extent = true;
+}
+
+std::string AppendedFileWriter::ExtentToString(const size_t *ext) {
+    return std::to_string(ext[0]) + " " + std::to_string(ext[1]) + " "
+            + std::to_string(ext[2]) + " " + std::to_string(ext[3]) + " "
+            + std::to_string(ext[4]) + " " + std::to_string(ext[5]);
+}
+
+void AppendedFileWriter::Register(const std::string section, const std::string name, const std::string type,
+        const char *data, const size_t num_bytes, const size_t num_of_comp, std::shared_ptr<void> owner,
+        const FillFunction &fill) {
+
+    size_t s = 0;
+    while (s < num_of_sections && section != section_order[s])
+        ++s;
+
+    if (s == num_of_sections) {
+        std::cerr << "Error! Unknown section : " << section << ". Data set " << name
+                << " is skipped. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return;
+    }
+
+    ArrayInfo arr;
+    arr.section = section;
+    arr.name = name;
+    arr.type = type;
+    arr.num_of_comp = num_of_comp;
+    arr.data = data;
+    arr.num_bytes = num_bytes;
+    arr.offset = 0;
+    arr.owner = owner;
+    arr.fill = fill;
+    arr.duplicate = no_duplicate;
+    arr.hash = 0;
+    arr.has_hash = false;
+    arrays.push_back(arr);
+}
+
+AppendedFileWriter::Conversion AppendedFileWriter::GetConversion(const ArrayInfo &arr) const {
+    if (arr.type != "Float64")
+        return CONVERSION_NONE;
+
+    /* VTK readers ignore 'Scale' and 'Shift', so quantized geometry would be distorted */
+    if (float64_conversion == CONVERSION_UINT16 && arr.section != "PointData" && arr.section != "CellData")
+        return CONVERSION_NONE;
+    return float64_conversion;
+}
+
+std::string AppendedFileWriter::ConvertedType(const ArrayInfo &arr) const {
+    switch (GetConversion(arr)) {
+    case CONVERSION_FLOAT32:
+        return "Float32";
+    case CONVERSION_UINT16:
+        return "UInt16";
+    default:
+        return arr.type;
+    }
+}
+
+void AppendedFileWriter::ConvertArrays() {
+    converted.clear();
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        const Conversion conversion = GetConversion(arrays[n]);
+        if (conversion == CONVERSION_NONE)
+            continue;
+        converted.push_back(std::make_pair(n, arrays[n]));
+        Convert(conversion, arrays[n]);
+    }
+}
+
+void AppendedFileWriter::RestoreArrays() {
+    for(size_t n = 0; n < converted.size(); ++n)
+        arrays[converted[n].first] = converted[n].second;
+    converted.clear();
+}
+
+void AppendedFileWriter::Convert(const Conversion conversion, ArrayInfo &arr) const {
+
+    const size_t num_values = arr.num_bytes / sizeof(double);
+    const char *data = arr.fill ? NULL : arr.data;
+
+    if (conversion == CONVERSION_FLOAT32) {
+        arr.type = "Float32";
+        arr.num_bytes = num_values * sizeof(float);
+        arr.fill = TypeConverter::Float32Fill(data, arr.fill);
+    }
+    else {
+        double min, max;
+        TypeConverter::FindRange(data, arr.fill, num_values, min, max);
+        const double shift = min;
+        const double scale = (max > min) ? (max - min) / 65535. : 1.;
+
+        char scale_str[64], shift_str[64];
+        char *scale_end = AsciiEncoder::Format(scale, scale_str);
+        char *shift_end = AsciiEncoder::Format(shift, shift_str);
+        arr.attributes = " Scale=\"" + std::string(scale_str, scale_end)
+                + "\" Shift=\"" + std::string(shift_str, shift_end) + "\"";
+
+        arr.type = "UInt16";
+        arr.num_bytes = num_values * sizeof(uint16_t);
+        arr.fill = TypeConverter::UInt16Fill(data, arr.fill, shift, scale);
+    }
+    arr.data = NULL;
+}
+
+void AppendedFileWriter::SortArrays() {
+    order.clear();
+    order.reserve(arrays.size());
+    for(size_t s = 0; s < num_of_sections; ++s)
+        for(size_t n = 0; n < arrays.size(); ++n)
+            if (arrays[n].section == section_order[s])
+                order.push_back(n);
+}
+
+void AppendedFileWriter::PrepareArrays() {
+
+    /* The range of quantized data sets is taken from their current contents */
+    ConvertArrays();
+    SortArrays();
+    for(size_t n = 0; n < arrays.size(); ++n)
+        arrays[n].duplicate = no_duplicate;
+    if (deduplicate)
+        FindDuplicates();
+
+    XMLW_STATS(
+        stats.arrays.clear();
+        for(size_t n = 0; n < arrays.size(); ++n)
+            stats.arrays.push_back(ArrayStats(arrays[n].name));
+    )
+}
+
+bool AppendedFileWriter::ComputeOffsets(size_t &total_size) {
+
+    size_t bofs = 0;
+    bool status = true;
+
+    PrepareArrays();
+
+    for(size_t n = 0; n < order.size(); ++n) {
+        ArrayInfo &arr = arrays[order[n]];
+
+        /* Duplicates refer to the data set written earlier */
+        if (arr.duplicate != no_duplicate) {
+            arr.offset = arrays[arr.duplicate].offset;
+            continue;
+        }
+
+        arr.offset = bofs;
+        XMLW_STATS(StatsTimer timer(stats.arrays[order[n]].encode_time); const size_t begin = bofs;)
+        if (GetCompressor() != NULL) {
+            const size_t size = arr.fill ?
+                    GetCompressor()->Compress(arr.fill, arr.num_bytes, GetHeaderTypeSize(), arr.encoded,
+                            GetThreadPool()) :
+                    GetCompressor()->Compress(arr.data, arr.num_bytes, GetHeaderTypeSize(), arr.encoded,
+                            GetThreadPool());
+            if (size == 0) {
+                std::cerr << "Error! Data set " << arr.name << " can't be compressed. See "
+                        << __FILE__ << ":" << __LINE__ << "\n";
+                status = false;
+            }
+            bofs += size;
+        }
+        else
+            bofs += arr.num_bytes + GetHeaderTypeSize();
+        XMLW_STATS(stats.arrays[order[n]].bytes = bofs - begin;)
+    }
+
+    XMLW_STATS(stats.payload_bytes = bofs;)
+    total_size = bofs;
+    return status;
+}
+
+bool AppendedFileWriter::RequiresUInt64Header() const {
+    for(size_t n = 0; n < arrays.size(); ++n)
+        if (arrays[n].num_bytes > std::numeric_limits<uint32_t>::max())
+            return true;
+    return false;
+}
+
+void AppendedFileWriter::ReleaseEncoded() {
+    RestoreArrays();
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        std::vector<char>().swap(arrays[n].encoded);
+        arrays[n].has_hash = false;
+    }
+}
+
+void AppendedFileWriter::CollectSegments(std::vector<Segment> &segments, std::vector<char> &prefixes) const {
+
+    const size_t header_size = GetHeaderTypeSize();
+    const bool compressed = GetCompressor() != NULL;
+
+    segments.clear();
+    segments.reserve(2 * order.size());
+
+    /* Pointers to headers are taken, so the storage should never reallocate */
+    prefixes.assign(compressed ? 0 : order.size() * header_size, 0);
+
+    for(size_t n = 0; n < order.size(); ++n) {
+        const ArrayInfo &arr = arrays[order[n]];
+
+        if (arr.duplicate != no_duplicate)
+            continue;
+
+        if (compressed) {
+            segments.push_back(Segment(arr.encoded.data(), arr.encoded.size(), NULL, order[n]));
+            continue;
+        }
+
+        char *prefix = &prefixes[n * header_size];
+        if (header_size == sizeof(uint64_t)) {
+            uint64_t size = arr.num_bytes;
+            std::memcpy(prefix, &size, sizeof(uint64_t));
+        }
+        else {
+            uint32_t size = arr.num_bytes;
+            std::memcpy(prefix, &size, sizeof(uint32_t));
+        }
+        segments.push_back(Segment(prefix, header_size, NULL, order[n]));
+
+        if (arr.fill)
+            segments.push_back(Segment(NULL, arr.num_bytes, &arr.fill, order[n]));
+        else
+            segments.push_back(Segment(arr.data, arr.num_bytes, NULL, order[n]));
+    }
+}
+
+bool AppendedFileWriter::WriteGenerated(const Segment &segment,
+        const std::function<bool(const char*, size_t)> &write) {
+
+    const size_t max_chunk = size_t(1) << 20;
+    const size_t chunk_size = segment.size < max_chunk ? segment.size : max_chunk;
+    std::unique_ptr<char[]> chunk(new char[chunk_size + 1]);
+
+    for(size_t pos = 0; pos < segment.size; pos += chunk_size) {
+        const size_t size = (segment.size - pos < chunk_size) ? segment.size - pos : chunk_size;
+        (*segment.fill)(pos, size, chunk.get());
+        if (!write(chunk.get(), size))
+            return false;
+    }
+    return true;
+}
+
+std::string AppendedFileWriter::GridSection() const {
+    std::string grid = grid_type;
+    if (has_extent)
+        grid += " WholeExtent=\"" + ExtentToString(has_whole_extent ? whole_extent : extent) + "\"";
+    return grid + grid_attributes;
+}
+
+std::string AppendedFileWriter::FieldSection(const std::string &section) const {
+
+    std::string scalars;
+    bool has_degrees = false;
+    for(size_t n = 0; n < order.size(); ++n) {
+        const ArrayInfo &arr = arrays[order[n]];
+        if (arr.section != section)
+            continue;
+        if (section == "CellData" && arr.name == "HigherOrderDegrees")
+            has_degrees = true;
+        else if (scalars.empty())
+            scalars = arr.name;
+    }
+
+    std::string str = section;
+    if (!scalars.empty())
+        str += " Scalars=\"" + scalars + "\"";
+    if (has_degrees)
+        str += " HigherOrderDegrees=\"HigherOrderDegrees\"";
+    return str;
+}
+
+bool AppendedFileWriter::Write(const std::string file_name) {
+
+    XMLW_STATS(stats.Reset(); stats.file_name = file_name; const double start = StatsTimer::Now();)
+
+    /* Data sets larger than 4 GiB require 8-byte headers */
+    const std::string requested_header_type = GetHeaderType();
+    if (RequiresUInt64Header())
+        SetHeaderType("UInt64");
+
+    bool status;
+    if (GetPipelining() && GetCompressor() != NULL) {
+        if (backend != BACKEND_STREAM)
+            std::cerr << "Warning! Pipelined compression writes through std::ofstream, the backend set by "
+                    << "SetBackend() is ignored. See " << __FILE__ << ":" << __LINE__ << "\n";
+        status = WritePipelined(file_name);
+    }
+    else {
+        size_t total_size;
+        {
+            XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_PREPARE]);)
+            status = ComputeOffsets(total_size);
+        }
+
+        /* Nothing is written if any data set failed to compress, the old file (if any) stays intact */
+        if (status) {
+            if (backend == BACKEND_VECTORED)
+                status = WriteVectored(file_name);
+            else if (backend == BACKEND_MAPPED)
+                status = WriteMapped(file_name);
+            else
+                status = WriteStream(file_name);
+        }
+    }
+
+    ReleaseEncoded();
+
+    SetHeaderType(requested_header_type);
+
+    XMLW_STATS(stats.total_time = StatsTimer::Now() - start; ReportStats();)
+
+    return status;
+}
+
+bool AppendedFileWriter::WriteStream(const std::string file_name) {
+
+    std::ofstream os;
+
+    os.open(file_name.c_str(), std::ios::out | std::ios::binary);
+    XMLW_STATS(++stats.num_syscalls;)
+    if (!os.is_open()) {
+        std::cerr << "Error! Can't open file " << file_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_HEADER]);)
+        body.clear();
+        WriteBody(body);
+    }
+    XMLW_STATS(stats.header_bytes = body.size();)
+
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_PAYLOAD]); ++stats.num_writes;)
+        os.write(body.data(), body.size());
+        WriteAppendedData(os);
+    }
+
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_CLOSE]); ++stats.num_syscalls;)
+        os.close();
+    }
+
+    return !os.fail();
+}
+
+/* Maximum size of compressed data sets waiting to be written (at least one data set is always compressed ahead) */
+static const size_t pipeline_window = size_t(1) << 28;
+
+bool AppendedFileWriter::WritePipelined(const std::string file_name) {
+
+    const DataCompressor *compressor = GetCompressor();
+    const size_t header_size = GetHeaderTypeSize();
+    const size_t bound = compressor->GetMaxBlockSize();
+    ThreadPool *pool = GetThreadPool();
+
+    /*
+     * The main body is assembled with the largest possible offsets, so it reserves enough space for the final
+     * one: real offsets are never larger and never have more digits
+     */
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_PREPARE]);)
+        PrepareArrays();
+        size_t bofs = 0;
+        for(size_t n = 0; n < order.size(); ++n) {
+            ArrayInfo &arr = arrays[order[n]];
+            if (arr.duplicate != no_duplicate) {
+                arr.offset = arrays[arr.duplicate].offset;
+                continue;
+            }
+            arr.offset = bofs;
+            bofs += compressor->GetMaxCompressedSize(arr.num_bytes, header_size);
+        }
+    }
+
+    HeaderBuilder tail(64);
+    size_t reserved_body;
+    size_t data_start;
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_HEADER]);)
+        body.clear();
+        WriteBody(body);
+        reserved_body = body.size();
+        OpenAppendedSection(body);
+        data_start = body.size();
+        CloseAppendedSection(tail);
+    }
+
+    /* The file is assembled under a temporary name, so a failure leaves the old file (if any) intact */
+    const std::string temp_name = file_name + ".part";
+    std::ofstream os;
+
+    os.open(temp_name.c_str(), std::ios::out | std::ios::binary);
+    XMLW_STATS(++stats.num_syscalls;)
+    if (!os.is_open()) {
+        std::cerr << "Error! Can't open file " << temp_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    os.seekp(data_start);
+
+    /* Blocks of every data set are compressed into their own slots of the scratch buffer of the data set */
+    std::vector<ThreadPool::Job> jobs(order.size());
+    std::vector<std::unique_ptr<char[]> > scratch(order.size());
+    std::vector<std::vector<size_t> > sizes(order.size());
+    size_t submitted = 0;
+    size_t in_flight = 0;
+
+    std::vector<char> header;
+    size_t bofs = 0;
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_PAYLOAD]);)
+        for(size_t n = 0; n < order.size(); ++n) {
+
+            /* Compression of following data sets runs while the current one is written */
+            for(; submitted < order.size(); ++submitted) {
+                const ArrayInfo &next = arrays[order[submitted]];
+                if (next.duplicate != no_duplicate)
+                    continue;
+
+                const size_t num_blocks = compressor->GetNumberOfBlocks(next.num_bytes);
+                if (submitted > n + 1 && in_flight + num_blocks * bound > pipeline_window)
+                    break;
+
+                scratch[submitted].reset(new char[num_blocks * bound]);
+                sizes[submitted].assign(num_blocks, 0);
+                in_flight += num_blocks * bound;
+
+                const char *data = next.data;
+                const FillFunction *fill = next.fill ? &next.fill : NULL;
+                const size_t num_bytes = next.num_bytes;
+                char *out = scratch[submitted].get();
+                size_t *out_sizes = sizes[submitted].data();
+                jobs[submitted] = pool->Submit(num_blocks, [=](size_t b) {
+                    out_sizes[b] = compressor->CompressSingleBlock(data, fill, num_bytes, b, &out[b * bound]);
+                });
+            }
+
+            ArrayInfo &arr = arrays[order[n]];
+            if (arr.duplicate != no_duplicate) {
+                arr.offset = arrays[arr.duplicate].offset;
+                continue;
+            }
+
+            XMLW_STATS(const double start = StatsTimer::Now();)
+            pool->Wait(jobs[n]);
+            jobs[n].reset();
+
+            /* Compressed blocks are never empty, a zero size marks a failure */
+            if (std::find(sizes[n].begin(), sizes[n].end(), 0) != sizes[n].end()) {
+                for(size_t k = n + 1; k < submitted; ++k)
+                    if (jobs[k])
+                        pool->Wait(jobs[k]);
+                std::cerr << "Error! Data set " << arr.name << " can't be compressed, file " << file_name
+                        << " isn't written. See " << __FILE__ << ":" << __LINE__ << "\n";
+                os.close();
+                std::remove(temp_name.c_str());
+                return false;
+            }
+
+            const size_t num_blocks = sizes[n].size();
+            header.resize((3 + num_blocks) * header_size);
+            compressor->WriteHeader(arr.num_bytes, header_size, sizes[n], header.data());
+            os.write(header.data(), header.size());
+            arr.offset = bofs;
+            bofs += header.size();
+            for(size_t b = 0; b < num_blocks; ++b) {
+                os.write(&scratch[n][b * bound], sizes[n][b]);
+                bofs += sizes[n][b];
+            }
+
+            scratch[n].reset();
+            in_flight -= num_blocks * bound;
+            XMLW_STATS(
+                stats.num_writes += num_blocks + 1;
+                stats.arrays[order[n]].bytes = bofs - arr.offset;
+                stats.arrays[order[n]].write_time += StatsTimer::Now() - start;
+            )
+        }
+        os.write(tail.data(), tail.size());
+        XMLW_STATS(++stats.num_writes;)
+    }
+    XMLW_STATS(stats.payload_bytes = bofs;)
+
+    /* Data sets are followed by the end of the file, the main body shorter than reserved is padded with blanks */
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_HEADER]);)
+        body.clear();
+        WriteBody(body);
+        OpenAppendedSection(header_padding + reserved_body - body.size(), body);
+        tail.clear();
+        CloseAppendedSection(tail);
+    }
+    XMLW_STATS(stats.header_bytes = body.size();)
+
+    if (body.size() != data_start) {
+        std::cerr << "Error! The main body of the file " << file_name << " doesn't fit into the reserved space. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        os.close();
+        std::remove(temp_name.c_str());
+        return false;
+    }
+
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_CLOSE]); stats.num_syscalls += 3;)
+        os.seekp(0);
+        os.write(body.data(), body.size());
+        XMLW_STATS(++stats.num_writes;)
+        os.close();
+    }
+
+    if (os.fail() || !ReplaceFile(temp_name, file_name)) {
+        std::remove(temp_name.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool AppendedFileWriter::ReplaceFile(const std::string &temp_name, const std::string &file_name) {
+
+    /* std::rename() replaces the existing file on POSIX systems only */
+    if (std::rename(temp_name.c_str(), file_name.c_str()) == 0)
+        return true;
+    std::remove(file_name.c_str());
+    if (std::rename(temp_name.c_str(), file_name.c_str()) == 0)
+        return true;
+
+    std::cerr << "Error! Can't rename file " << temp_name << " to " << file_name << ". See "
+            << __FILE__ << ":" << __LINE__ << "\n";
+    return false;
+}
+
+void AppendedFileWriter::SetBackend(const Backend _backend) {
+    backend = _backend;
+}
+
+void AppendedFileWriter::SetDirectIO(const bool _direct_io, const size_t _direct_io_threshold) {
+    direct_io = _direct_io;
+    direct_io_threshold = _direct_io_threshold;
+}
+
+void AppendedFileWriter::SetFloat64Conversion(const Conversion _conversion) {
+    float64_conversion = _conversion;
+}
+
+void AppendedFileWriter::Clear() {
+    converted.clear();
+    arrays.clear();
+    order.clear();
+}
+
+/*
+ * Copies are aligned, so they can be accessed as arrays of their own types
+ */
+static const size_t snapshot_alignment = 64;
+
+size_t AppendedFileWriter::GetSnapshotSize() const {
+    size_t size = 0;
+    for(size_t n = 0; n < arrays.size(); ++n)
+        if (!arrays[n].owner)
+            size += (arrays[n].num_bytes + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+    return size + snapshot_alignment;
+}
+
+void AppendedFileWriter::Snapshot(char *buffer) {
+    char *pos = buffer + (snapshot_alignment - (size_t)buffer % snapshot_alignment) % snapshot_alignment;
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        ArrayInfo &arr = arrays[n];
+        if (arr.owner)
+            continue;
+        if (arr.fill)
+            arr.fill(0, arr.num_bytes, pos);
+        else if (arr.num_bytes != 0)
+            std::memcpy(pos, arr.data, arr.num_bytes);
+        arr.data = pos;
+        arr.fill = FillFunction();
+        pos += (arr.num_bytes + snapshot_alignment - 1) / snapshot_alignment * snapshot_alignment;
+    }
+}
+
+/* Size of a chunk hashed by a single task */
+static const size_t hash_chunk_size = size_t(1) << 22;
+
+bool AppendedFileWriter::IsGeometry(const std::string &section) {
+    return section == "Points" || section == "Coordinates" || section == "Cells";
+}
+
+void AppendedFileWriter::HashArrays(const bool skip_geometry) {
+
+    /* Contents of data sets are hashed by chunks in parallel */
+    std::vector<size_t> first_chunk(arrays.size() + 1, 0);
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        const bool skip = arrays[n].has_hash || (skip_geometry && IsGeometry(arrays[n].section));
+        const size_t num_chunks = skip ? 0 : (arrays[n].num_bytes + hash_chunk_size - 1) / hash_chunk_size;
+        first_chunk[n + 1] = first_chunk[n] + num_chunks;
+    }
+
+    std::vector<uint64_t> digests(first_chunk.back());
+    GetThreadPool()->Run(digests.size(), [&](size_t c) {
+        const size_t n = std::upper_bound(first_chunk.begin(), first_chunk.end(), c) - first_chunk.begin() - 1;
+        const ArrayInfo &arr = arrays[n];
+        const size_t offset = (c - first_chunk[n]) * hash_chunk_size;
+        const size_t size = (arr.num_bytes - offset < hash_chunk_size) ? arr.num_bytes - offset : hash_chunk_size;
+
+        if (arr.fill) {
+            std::unique_ptr<char[]> chunk(new char[size + 1]);
+            arr.fill(offset, size, chunk.get());
+            digests[c] = Hash64::Compute(chunk.get(), size);
+        }
+        else
+            digests[c] = Hash64::Compute(arr.data + offset, size);
+    });
+
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        ArrayInfo &arr = arrays[n];
+        if (arr.has_hash || (skip_geometry && IsGeometry(arr.section)))
+            continue;
+        arr.hash = Hash64::Compute(&digests[first_chunk[n]], (first_chunk[n + 1] - first_chunk[n]) * sizeof(uint64_t));
+        arr.has_hash = true;
+    }
+}
+
+uint64_t AppendedFileWriter::Hash(const bool skip_geometry) {
+
+    /*
+     * Data may have changed in place since the last call (e.g. the previous file was skipped and never written),
+     * so hashes are kept only until the following Write()
+     */
+    for(size_t n = 0; n < arrays.size(); ++n)
+        arrays[n].has_hash = false;
+    HashArrays(skip_geometry);
+
+    /* Everything which affects the main body of the file */
+    Hash64 hash;
+    hash.Update(GridSection());
+    hash.Update(piece_attributes);
+    hash.Update(has_extent ? ExtentToString(extent) : std::string());
+    hash.Update(GetHeaderType());
+    hash.Update(GetCompressor() ? GetCompressor()->GetName() : std::string());
+    hash.Update((uint64_t)deduplicate);
+    hash.Update((uint64_t)float64_conversion);
+    hash.Update((uint64_t)header_padding);
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        const ArrayInfo &arr = arrays[n];
+        hash.Update(arr.section);
+        hash.Update(arr.name);
+        hash.Update(arr.type);
+        hash.Update((uint64_t)arr.num_of_comp);
+        hash.Update((uint64_t)arr.num_bytes);
+        hash.Update(arr.attributes);
+        hash.Update((skip_geometry && IsGeometry(arr.section)) ? 0 : arr.hash);
+    }
+    return hash.Digest();
+}
+
+bool AppendedFileWriter::SameContents(const ArrayInfo &first, const ArrayInfo &second) {
+
+    if (first.num_bytes != second.num_bytes)
+        return false;
+    if (!first.fill && !second.fill)
+        return first.data == second.data || std::memcmp(first.data, second.data, first.num_bytes) == 0;
+
+    /* Generated data sets are compared by chunks */
+    const size_t max_chunk = size_t(1) << 20;
+    const size_t chunk_size = first.num_bytes < max_chunk ? first.num_bytes : max_chunk;
+    std::unique_ptr<char[]> first_chunk(new char[chunk_size + 1]);
+    std::unique_ptr<char[]> second_chunk(new char[chunk_size + 1]);
+
+    for(size_t pos = 0; pos < first.num_bytes; pos += chunk_size) {
+        const size_t size = (first.num_bytes - pos < chunk_size) ? first.num_bytes - pos : chunk_size;
+        const char *a = first.data + pos;
+        const char *b = second.data + pos;
+        if (first.fill) {
+            first.fill(pos, size, first_chunk.get());
+            a = first_chunk.get();
+        }
+        if (second.fill) {
+            second.fill(pos, size, second_chunk.get());
+            b = second_chunk.get();
+        }
+        if (std::memcmp(a, b, size) != 0)
+            return false;
+    }
+    return true;
+}
+
+void AppendedFileWriter::FindDuplicates() {
+
+    HashArrays(false);
+
+    /* Each data set is compared only with earlier data sets of the same hash */
+    std::multimap<uint64_t, size_t> written;
+    for(size_t n = 0; n < order.size(); ++n) {
+        ArrayInfo &arr = arrays[order[n]];
+        const std::pair<std::multimap<uint64_t, size_t>::iterator, std::multimap<uint64_t, size_t>::iterator>
+            range = written.equal_range(arr.hash);
+
+        for(std::multimap<uint64_t, size_t>::iterator it = range.first; it != range.second; ++it)
+            if (SameContents(arrays[it->second], arr)) {
+                arr.duplicate = it->second;
+                break;
+            }
+
+        if (arr.duplicate == no_duplicate)
+            written.insert(std::make_pair(arr.hash, order[n]));
+    }
+}
+
+void AppendedFileWriter::SetDeduplication(const bool _deduplicate) {
+    deduplicate = _deduplicate;
+}
+
+void AppendedFileWriter::SetHeaderPadding(const size_t _header_padding) {
+    header_padding = _header_padding;
+}
+
+}
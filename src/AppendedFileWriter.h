@@ -0,0 +1,560 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef APPENDEDFILEWRITER_H_
+#define APPENDEDFILEWRITER_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <limits>
+
+#include "XMLWriter.h"
+#include "HeaderBuilder.h"
+
+namespace xmlw {
+
+/*!
+ * \class AppendedFileWriter
+ * \brief Writes a complete VTK XML file with all data sets placed into the appended section
+ * Using VTK_XML_Writer directly one has to assemble the main body of the file, keep track of offsets of every
+ * 'DataArray' (CountOffset() plus the size of the leading integer) and append data sets in exactly the same order
+ * as they were declared. This class takes care of all of it. Data sets are registered once with the name of the
+ * section they belong to ("PointData", "CellData", "Points", "Coordinates" or "Cells"), the writer sorts them by
+ * sections, computes all offsets, writes the main body and streams data sets directly into the file in the order
+ * of their declaration in the body.
+ * If any of the data sets is larger than 4 GiB the header type is switched to "UInt64" automatically for this file,
+ * otherwise the one set by SetHeaderType() is used. If a compressor is set (see SetCompressor()) all data sets are
+ * compressed before the main body is written, since their offsets depend on the compressed sizes.
+ * By default the file is written through std::ofstream, which copies every data set through the buffer of the
+ * stream. The vectored backend (see SetBackend()) gathers the main body, headers of all data sets and pointers to
+ * data sets into a list of iovec structures and passes them to pwritev(), so data goes from user memory directly to
+ * the kernel. Optionally, large data sets can be written with O_DIRECT, bypassing the page cache. O_DIRECT requires
+ * the address of data and the position in the file to be equally aligned (4096 Bytes), so only the aligned middle
+ * part of data sets with matching alignment is written this way, everything else goes through pwritev().
+ * The mapped backend uses the fact that the size of the file is known as soon as offsets are computed: the file is
+ * preallocated, mapped into memory and data sets are copied into their final places by the threads of the pool
+ * (see SetNumberOfThreads()). Large data sets are split into chunks, so a single data set is copied in parallel too.
+ * Data sets which are not stored contiguously (fields of arrays of structures, separate arrays of coordinates) can
+ * be registered through StridedView and SoAView, data sets derived from other fields through GeneratedView. Such data
+ * sets are interleaved or computed on the fly: through a bounded buffer by the stream and vectored backends, block by
+ * block by the compressor and directly into the file by the mapped backend.
+ * With SetPipelining() compressed data sets are written by the stream as soon as they are compressed, while the pool
+ * compresses the following ones, instead of compressing all of them before the main body is written.
+ * \note The writer doesn't copy data sets, it only keeps pointers to them. Thus, all registered data should stay
+ * alive and unchanged until Write() is called. Vectors passed as rvalues are moved into the writer and owned by it.
+ */
+class AppendedFileWriter : public VTK_XML_Writer {
+public:
+
+    /*!
+     * \brief Output backends
+     */
+    enum Backend {
+        BACKEND_STREAM,         //!< Buffered std::ofstream (default, portable)
+        BACKEND_VECTORED,       //!< POSIX pwritev() directly from data sets, without intermediate copies
+        BACKEND_MAPPED          //!< Preallocated memory-mapped file filled by several threads
+    };
+
+    /*!
+     * \brief Conversions of Float64 data sets
+     */
+    enum Conversion {
+        CONVERSION_NONE,        //!< Data sets are written as they are (default)
+        CONVERSION_FLOAT32,     //!< Values are rounded to Float32
+        CONVERSION_UINT16       //!< Values are quantized to UInt16, see TypeConverter
+    };
+
+    /*!
+     * \brief Constructor
+     * @param _grid_type Type of the data set (UnstructuredGrid, StructuredGrid, ...)
+     */
+    AppendedFileWriter(const std::string _grid_type);
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~AppendedFileWriter() { }
+
+    /*!
+     * \brief Returns copy of the writer of the same class, data sets are referenced, not copied
+     * Used by AsyncWriter to keep the writer until the file is written. Classes derived from AppendedFileWriter
+     * should override it, otherwise the copy is sliced and their Write() is lost.
+     */
+    virtual AppendedFileWriter *Clone() const;
+
+    /*!
+     * \brief Sets number of points and cells of the piece (unstructured data sets)
+     * @param num_points Number of points
+     * @param num_cells Number of cells
+     */
+    void SetPiece(const size_t num_points, const size_t num_cells);
+
+    /*!
+     * \brief Sets extent of the piece (structured data sets)
+     * Unless SetWholeExtent() is called the whole extent of the grid is the same as the extent of the piece.
+     * Virtual, since writers of grids with explicit coordinates keep track of the extent set by the user.
+     * \note Counting starts from 1 (not from 0!)
+     */
+    virtual void SetExtent(const size_t i0, const size_t i1, const size_t j0, const size_t j1,
+            const size_t k0, const size_t k1);
+
+    /*!
+     * \brief Sets whole extent of the grid if it differs from the extent of the piece (parallel output)
+     * \note Counting starts from 1 (not from 0!)
+     */
+    void SetWholeExtent(const size_t i0, const size_t i1, const size_t j0, const size_t j1,
+            const size_t k0, const size_t k1);
+
+    /*!
+     * \brief Registers data set, type of the data is determined automatically
+     * Elements can be of any type described by VTKTypeTraits, e.g. std::array<float, 3> for points.
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param data Reference to the data set, should be compatible with STL library
+     * @param num_of_comp Number of components in each element of data (0 - deduce from the type of elements)
+     */
+    template<typename Data>
+    inline void AddArray(const std::string section, const std::string name, Data &data,
+            const size_t num_of_comp = 0);
+
+    /*!
+     * \brief Registers data set of the given type
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param type Data type (Int32, Float32, ...)
+     * @param data Reference to the data set, should be compatible with STL library
+     * @param num_of_comp Number of components in each element of data
+     */
+    template<typename Data>
+    inline void AddArray(const std::string section, const std::string name, const std::string type,
+            Data &data, const size_t num_of_comp);
+
+    /*!
+     * \brief Registers data set and takes ownership of it
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param data Data set to be moved into the writer
+     * @param num_of_comp Number of components in each element of data (0 - deduce from the type of elements)
+     */
+    template<typename T>
+    inline void AddArray(const std::string section, const std::string name, std::vector<T> &&data,
+            const size_t num_of_comp = 0);
+
+    /*!
+     * \brief Registers data set stored in a contiguous chunk of memory
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param type Data type (Int32, Float32, ...)
+     * @param data Pointer to the first element
+     * @param size Number of elements
+     * @param num_of_comp Number of components in each element of data
+     */
+    template<typename T>
+    inline void AddArray(const std::string section, const std::string name, const std::string type,
+            const T *data, const size_t size, const size_t num_of_comp);
+
+    /*!
+     * \brief Registers data set stored with a constant stride (e.g. a field of an array of structures)
+     * Values are interleaved on the fly while the file is written, the view should stay valid until then.
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param view View of the data set
+     */
+    template<typename T>
+    inline void AddArray(const std::string section, const std::string name, const StridedView<T> view);
+
+    /*!
+     * \brief Registers data set stored as a structure of arrays (e.g. separate x, y and z coordinates)
+     * Components are interleaved on the fly while the file is written, the view should stay valid until then.
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param view View of the data set
+     */
+    template<typename T>
+    inline void AddArray(const std::string section, const std::string name, const SoAView<T> view);
+
+    /*!
+     * \brief Registers data set computed on the fly (e.g. a field derived from other fields)
+     * Values are computed by chunks while the file is written, the data set never exists in memory as a whole.
+     * The view (and everything its function refers to) should stay valid until then.
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set
+     * @param view View of the data set
+     */
+    template<typename T>
+    inline void AddArray(const std::string section, const std::string name, const GeneratedView<T> view);
+
+    /*!
+     * \brief Writes down the file
+     * @param file_name Name of the file
+     * @return True if the file was successfully written
+     */
+    virtual bool Write(const std::string file_name);
+
+    /*!
+     * \brief Removes all registered data sets
+     */
+    void Clear();
+
+    /*!
+     * \brief Sets output backend
+     * Pipelined compression (see SetPipelining()) always writes through std::ofstream, the backend is ignored then.
+     * @param _backend Backend to be used
+     */
+    void SetBackend(const Backend _backend);
+
+    /*!
+     * \brief Enables O_DIRECT output of large data sets (vectored backend only)
+     * @param _direct_io True to enable
+     * @param _direct_io_threshold Minimum size of data set written with O_DIRECT in Bytes
+     */
+    void SetDirectIO(const bool _direct_io, const size_t _direct_io_threshold = 1 << 22);
+
+    /*!
+     * \brief Sets conversion of Float64 data sets, applied to all data sets when a file is written
+     * Data sets are converted by chunks while the file is written, the type and the size of data sets in the file
+     * are changed accordingly. Quantized data sets get additional attributes 'Scale' and 'Shift' of the 'DataArray'
+     * section, the original value is q * Scale + Shift, the range is taken from the contents of the data set at the
+     * time of writing. Note that VTK readers ignore these attributes and show quantized values, so only 'PointData'
+     * and 'CellData' are quantized, the geometry is written as it is.
+     * @param _conversion Conversion to be applied
+     */
+    void SetFloat64Conversion(const Conversion _conversion);
+
+    /*!
+     * \brief Enables deduplication of data sets within the file
+     * Data sets with identical contents (e.g. the same mask registered for two fields or repeated connectivity)
+     * are written once and all their 'DataArray' sections refer to the same offset. Candidates are found by the
+     * hash of their contents (see Hash()) and confirmed by comparing the contents, so collisions of the hash never
+     * merge different data sets.
+     * @param _deduplicate True to enable
+     */
+    void SetDeduplication(const bool _deduplicate);
+
+    /*!
+     * \brief Reserves space in the main body of the file, so data sets can be added later in place
+     * The main body is followed by a line of blanks of the given size. FieldAppender consumes these blanks when it
+     * adds new 'DataArray' sections, so the appended data doesn't have to be moved.
+     * @param _header_padding Size of the reserved space in Bytes (0 - no padding, default)
+     */
+    void SetHeaderPadding(const size_t _header_padding);
+
+    /*!
+     * \brief Returns size of the buffer required by Snapshot() in Bytes
+     */
+    size_t GetSnapshotSize() const;
+
+    /*!
+     * \brief Copies all data sets which are not owned by the writer into the buffer
+     * Data sets registered through views are interleaved into the buffer. Afterwards the writer refers to the
+     * copies, so the original data can be changed or released.
+     * @param buffer Buffer of at least GetSnapshotSize() Bytes, should stay alive until the file is written
+     */
+    void Snapshot(char *buffer);
+
+    /*!
+     * \brief Returns hash of the file: of the main body and of the contents of all data sets
+     * Writers with equal hashes produce identical files (up to collisions of the 64-bit hash), so a file which
+     * would repeat the previous one doesn't have to be written again (see TimeSeriesWriter). Contents of data sets
+     * are hashed by chunks in parallel, data sets registered through views are generated by chunks. Every call hashes
+     * the current contents, the hashes are kept until the next file is written, so deduplication (see
+     * SetDeduplication()) doesn't hash them again. Data shouldn't change between Hash() and Write().
+     * @param skip_geometry True to hash only the description of data sets of the geometry ("Points",
+     * "Coordinates" and "Cells"), but not their contents
+     * @return 64-bit hash
+     */
+    uint64_t Hash(const bool skip_geometry = false);
+
+protected:
+    /*!
+     * \brief Description of a single data set
+     */
+    struct ArrayInfo {
+        std::string section;        //!< Name of the section
+        std::string name;           //!< Name of the data set
+        std::string type;           //!< Data type (Int32, Float32, ...)
+        size_t num_of_comp;         //!< Number of components
+        const char *data;           //!< Pointer to the data
+        size_t num_bytes;           //!< Size of the data in Bytes
+        size_t offset;              //!< Offset in the appended section
+        std::vector<char> encoded;  //!< Compressed data (only if compressor is set)
+        std::shared_ptr<void> owner; //!< Owner of the data (empty if the data is not owned by the writer)
+        FillFunction fill;          //!< Generates the data on the fly (empty if the data is stored in memory)
+        std::string attributes;     //!< Additional attributes of the 'DataArray' section
+        size_t duplicate;           //!< Index of the identical data set written instead of this one
+        uint64_t hash;              //!< Hash of the contents (valid if has_hash is set)
+        bool has_hash;              //!< True if the hash is computed for the current contents
+    };
+
+    /*!
+     * \brief Contiguous chunk of the appended section
+     */
+    struct Segment {
+        const char *data;           //!< Pointer to the chunk (NULL if the chunk is generated on the fly)
+        size_t size;                //!< Size of the chunk in Bytes
+        const FillFunction *fill;   //!< Generates the chunk (NULL if the chunk is stored in memory)
+        size_t array;               //!< Index of the data set the chunk belongs to (for statistics)
+
+        Segment(const char *_data = NULL, const size_t _size = 0, const FillFunction *_fill = NULL,
+                const size_t _array = std::numeric_limits<size_t>::max()) :
+            data(_data), size(_size), fill(_fill), array(_array) { }
+    };
+
+    /*!
+     * \brief Adds data set to the list
+     */
+    void Register(const std::string section, const std::string name, const std::string type,
+            const char *data, const size_t num_bytes, const size_t num_of_comp,
+            std::shared_ptr<void> owner = std::shared_ptr<void>(), const FillFunction &fill = FillFunction());
+
+    /*!
+     * \brief Returns conversion applied to the data set while the file is written (see SetFloat64Conversion())
+     */
+    Conversion GetConversion(const ArrayInfo &arr) const;
+
+    /*!
+     * \brief Returns type of the data set in the file (after the conversion, if any)
+     */
+    std::string ConvertedType(const ArrayInfo &arr) const;
+
+    /*!
+     * \brief Replaces Float64 data sets by their converted versions, the originals are kept in 'converted'
+     */
+    void ConvertArrays();
+
+    /*!
+     * \brief Restores data sets replaced by ConvertArrays()
+     */
+    void RestoreArrays();
+
+    /*!
+     * \brief Replaces Float64 data set by its converted version, the range of quantized values is found here
+     * @param conversion Conversion to be applied
+     * @param arr Data set
+     */
+    void Convert(const Conversion conversion, ArrayInfo &arr) const;
+
+    /*!
+     * \brief Sorts data sets by sections
+     */
+    void SortArrays();
+
+    /*!
+     * \brief Converts Float64 data sets (if required), sorts data sets by sections and finds duplicates (if required)
+     */
+    void PrepareArrays();
+
+    /*!
+     * \brief Sorts data sets by sections, compresses them (if required) and computes their offsets
+     * @param total_size Total size of all data sets in the appended section in Bytes
+     * @return True if all data sets were successfully compressed
+     */
+    bool ComputeOffsets(size_t &total_size);
+
+    /*!
+     * \brief Returns true if any of data sets doesn't fit into UInt32 header
+     */
+    bool RequiresUInt64Header() const;
+
+    /*!
+     * \brief Releases memory occupied by compressed data sets, restores converted ones and drops hashes of data sets
+     * Called once the file is written, since registered data can change before the next file.
+     */
+    void ReleaseEncoded();
+
+    /*!
+     * \brief Returns opening statement of the grid section (with all attributes)
+     */
+    std::string GridSection() const;
+
+    /*!
+     * \brief Returns opening statement of the 'PointData' or 'CellData' section (with all attributes)
+     * The first data set of the section is the active scalar field. Generated 'HigherOrderDegrees' of high-order
+     * cells is never the active one, it is referred to by the attribute of the same name instead.
+     * @param section Name of the section ("PointData" or "CellData")
+     */
+    std::string FieldSection(const std::string &section) const;
+
+    /*!
+     * \brief Writes down the main body of the file
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void WriteBody(Stream &stream);
+
+    /*!
+     * \brief Writes down the 'Piece' section
+     * @param stream Output stream
+     * @param base_offset Offset of the first data set of the piece in the appended section
+     */
+    template<typename Stream>
+    inline void WritePiece(Stream &stream, const size_t base_offset);
+
+    /*!
+     * \brief Writes down all data sets into the appended section
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void WriteAppendedData(Stream &stream);
+
+    /*!
+     * \brief Writes chunks of the appended section one by one
+     * @param segments Chunks of the appended section (see CollectSegments())
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void WriteSegments(const std::vector<Segment> &segments, Stream &stream);
+
+    /*!
+     * \brief Opens the appended section (including the leading underscore)
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void OpenAppendedSection(Stream &stream);
+
+    /*!
+     * \brief Opens the appended section preceded by the given number of blanks instead of the header padding
+     * @param padding Number of blanks (including the line break) in front of the appended section
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void OpenAppendedSection(const size_t padding, Stream &stream);
+
+    /*!
+     * \brief Closes the appended section and the 'VTKFile' section
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void CloseAppendedSection(Stream &stream);
+
+    /*!
+     * \brief Writes down a chunk generated on the fly through a bounded buffer
+     * @param segment Chunk to be written
+     * @param write Function writing a piece of the chunk, returns false in case of failure
+     * @return True if all pieces were successfully written
+     */
+    static bool WriteGenerated(const Segment &segment, const std::function<bool(const char*, size_t)> &write);
+
+    /*!
+     * \brief Lists all chunks of the appended section in the order they should be written
+     * Offsets should be computed first (see ComputeOffsets()).
+     * @param segments Chunks of the appended section (headers and data sets)
+     * @param prefixes Storage for headers of uncompressed data sets, should stay alive while segments are used
+     */
+    void CollectSegments(std::vector<Segment> &segments, std::vector<char> &prefixes) const;
+
+    /*!
+     * \brief Writes down the file through std::ofstream, offsets should be computed first
+     * @param file_name Name of the file
+     * @return True if the file was successfully written
+     */
+    bool WriteStream(const std::string file_name);
+
+    /*!
+     * \brief Writes down compressed data sets through std::ofstream while following ones are compressed
+     * Data sets are written right after the space reserved for the main body, which is written last, once the
+     * offsets are known (see SetPipelining()). The file is written under a temporary name (with ".part" appended)
+     * and renamed once it is complete, so a failure leaves the old file intact as in other modes.
+     * @param file_name Name of the file
+     * @return True if the file was successfully written
+     */
+    bool WritePipelined(const std::string file_name);
+
+    /*!
+     * \brief Replaces the file by the temporary one
+     * @param temp_name Name of the temporary file
+     * @param file_name Name of the file
+     * @return True if the file was replaced
+     */
+    static bool ReplaceFile(const std::string &temp_name, const std::string &file_name);
+
+    /*!
+     * \brief Writes down the file with pwritev(), offsets should be computed first
+     * @param file_name Name of the file
+     * @return True if the file was successfully written
+     */
+    bool WriteVectored(const std::string file_name);
+
+    /*!
+     * \brief Writes down the file through a memory mapping, offsets should be computed first
+     * @param file_name Name of the file
+     * @return True if the file was successfully written
+     */
+    bool WriteMapped(const std::string file_name);
+
+    /*!
+     * \brief Computes hashes of data sets which are not hashed yet (see Hash())
+     * @param skip_geometry True to skip data sets of the geometry
+     */
+    void HashArrays(const bool skip_geometry);
+
+    /*!
+     * \brief Returns true if both data sets have the same contents
+     */
+    static bool SameContents(const ArrayInfo &first, const ArrayInfo &second);
+
+    /*!
+     * \brief Marks data sets which repeat contents of data sets written earlier, order should be computed first
+     */
+    void FindDuplicates();
+
+    /*!
+     * \brief Returns true if the section describes the geometry ("Points", "Coordinates" or "Cells")
+     */
+    static bool IsGeometry(const std::string &section);
+
+    /*!
+     * \brief Returns extent as a string of six numbers
+     */
+    static std::string ExtentToString(const size_t *ext);
+
+protected:
+    std::string grid_type;              //!< Type of the data set
+    std::string grid_attributes;        //!< Attributes of the grid section (except of the whole extent)
+    std::string piece_attributes;       //!< Attributes of the piece section (except of the extent)
+    size_t extent[6];                   //!< Extent of the piece
+    size_t whole_extent[6];             //!< Whole extent of the grid
+    bool has_extent;                    //!< True if the extent was set
+    bool has_whole_extent;              //!< True if the whole extent was set
+    std::vector<ArrayInfo> arrays;      //!< Registered data sets
+    std::vector<size_t> order;          //!< Order of data sets in the file
+    Backend backend;                    //!< Output backend
+    bool direct_io;                     //!< True if O_DIRECT is used for large data sets
+    size_t direct_io_threshold;         //!< Minimum size of data set written with O_DIRECT
+    Conversion float64_conversion;      //!< Conversion of Float64 data sets
+    std::vector<std::pair<size_t, ArrayInfo> > converted; //!< Originals of data sets converted for the current file
+    bool deduplicate;                   //!< True if identical data sets are written once
+    size_t header_padding;              //!< Space reserved in the main body in Bytes
+    HeaderBuilder body;                 //!< Buffer of the main body, reused for all files
+};
+
+} /* namespace xmlw */
+
+#include "AppendedFileWriter.inl"
+
+#endif /* APPENDEDFILEWRITER_H_ */
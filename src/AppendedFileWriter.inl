@@ -0,0 +1,183 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef APPENDEDFILEWRITER_INL_
+#define APPENDEDFILEWRITER_INL_
+
+namespace xmlw {
+
+template<typename Data>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name, Data &data,
+        const size_t num_of_comp) {
+    typedef typename Data::value_type value_type;
+    AddArray(section, name, VTKTypeName<value_type>(), data,
+            num_of_comp != 0 ? num_of_comp : VTKNumberOfComponents<value_type>());
+}
+
+template<typename Data>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name,
+        const std::string type, Data &data, const size_t num_of_comp) {
+    Register(section, name, type, (const char*)data.data(), sizeof(data[0]) * data.size(), num_of_comp);
+}
+
+template<typename T>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name, std::vector<T> &&data,
+        const size_t num_of_comp) {
+    std::shared_ptr<std::vector<T> > owner = std::make_shared<std::vector<T> >(std::move(data));
+    Register(section, name, VTKTypeName<T>(), (const char*)owner->data(), sizeof(T) * owner->size(),
+            num_of_comp != 0 ? num_of_comp : VTKNumberOfComponents<T>(), owner);
+}
+
+template<typename T>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name,
+        const std::string type, const T *data, const size_t size, const size_t num_of_comp) {
+    Register(section, name, type, (const char*)data, sizeof(T) * size, num_of_comp);
+}
+
+template<typename T>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name,
+        const StridedView<T> view) {
+    Register(section, name, VTKTypeName<T>(), NULL, sizeof(T) * view.size(), view.GetNumberOfComponents(),
+            std::shared_ptr<void>(), [view](size_t offset, size_t size, char *out) { view.Fill(offset, size, out); });
+}
+
+template<typename T>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name,
+        const SoAView<T> view) {
+    Register(section, name, VTKTypeName<T>(), NULL, sizeof(T) * view.size(), view.GetNumberOfComponents(),
+            std::shared_ptr<void>(), [view](size_t offset, size_t size, char *out) { view.Fill(offset, size, out); });
+}
+
+template<typename T>
+inline void AppendedFileWriter::AddArray(const std::string section, const std::string name,
+        const GeneratedView<T> view) {
+    Register(section, name, VTKTypeName<T>(), NULL, sizeof(T) * view.size(), view.GetNumberOfComponents(),
+            std::shared_ptr<void>(), [view](size_t offset, size_t size, char *out) { view.Fill(offset, size, out); });
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::WriteBody(Stream &stream) {
+
+    Header(stream);
+    OpenVTKSection(grid_type, stream);
+        OpenSection(GridSection(), stream);
+            WritePiece(stream, 0);
+        CloseSection(grid_type, stream);
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::WritePiece(Stream &stream, const size_t base_offset) {
+
+    const std::string format = "appended";
+    std::string section;
+    std::string piece = "Piece";
+
+    if (has_extent)
+        piece += " Extent=\"" + ExtentToString(extent) + "\"";
+
+    OpenSection(piece + piece_attributes, stream);
+
+    for(size_t n = 0; n < order.size(); ++n) {
+        const ArrayInfo &arr = arrays[order[n]];
+
+        if (arr.section != section) {
+            if (!section.empty())
+                CloseSection(section, stream);
+            section = arr.section;
+            if (section == "PointData" || section == "CellData")
+                OpenSection(FieldSection(section), stream);
+            else
+                OpenSection(section, stream);
+        }
+
+        OpenDataArrSection(arr.type, arr.name, arr.num_of_comp, format, base_offset + arr.offset, arr.attributes,
+                stream);
+        CloseDataArrSection(stream);
+    }
+    if (!section.empty())
+        CloseSection(section, stream);
+
+    ClosePieceSection(stream);
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::WriteAppendedData(Stream &stream) {
+
+    std::vector<Segment> segments;
+    std::vector<char> prefixes;
+
+    OpenAppendedSection(stream);
+    CollectSegments(segments, prefixes);
+    WriteSegments(segments, stream);
+    CloseAppendedSection(stream);
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::WriteSegments(const std::vector<Segment> &segments, Stream &stream) {
+
+    for(size_t n = 0; n < segments.size(); ++n) {
+        XMLW_STATS(const double start = StatsTimer::Now();)
+        if (segments[n].fill != NULL)
+            WriteGenerated(segments[n], [&](const char *data, size_t size) {
+                stream.write(data, size);
+                XMLW_STATS(++stats.num_writes;)
+                return true;
+            });
+        else
+            stream.write(segments[n].data, segments[n].size);
+        XMLW_STATS(
+            if (segments[n].fill == NULL)
+                ++stats.num_writes;
+            if (segments[n].array < stats.arrays.size())
+                stats.arrays[segments[n].array].write_time += StatsTimer::Now() - start;
+        )
+    }
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::OpenAppendedSection(Stream &stream) {
+    /* Blanks reserved for the main body to grow in place (see SetHeaderPadding()) */
+    OpenAppendedSection(header_padding, stream);
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::OpenAppendedSection(const size_t padding, Stream &stream) {
+    if (padding != 0)
+        stream << std::string(padding - 1, ' ') << "\n";
+    OpenSection("AppendedData encoding=\"raw\"", stream);
+    stream << "_";
+}
+
+template<typename Stream>
+inline void AppendedFileWriter::CloseAppendedSection(Stream &stream) {
+    stream << "\n";
+    CloseSection("AppendedData", stream);
+    CloseVTKSection(stream);
+}
+
+}
+
+#endif /* APPENDEDFILEWRITER_INL_ */
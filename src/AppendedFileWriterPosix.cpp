@@ -0,0 +1,385 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+/*
+ * POSIX output backends of AppendedFileWriter
+ */
+
+#include "AppendedFileWriter.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XMLW_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#endif
+
+namespace xmlw {
+
+#ifdef XMLW_POSIX
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* Alignment of memory, file positions and sizes required by O_DIRECT */
+static const size_t direct_io_alignment = 4096;
+
+/* Maximum size of a chunk copied by a single task of the mapped backend */
+static const size_t mapped_chunk_size = size_t(1) << 22;
+
+/*
+ * Writes down all chunks starting from the given position in the file. Chunks are submitted
+ * by groups of IOV_MAX, partially written groups are resumed from the first unwritten byte.
+ */
+static bool WriteChunks(const int fd, std::vector<iovec> &iov, off_t position, WriterStats &stats) {
+
+    size_t first = 0;
+
+    while (true) {
+        /* Empty chunks (empty data sets) are skipped, so every call has something to write */
+        while (first < iov.size() && iov[first].iov_len == 0)
+            ++first;
+        if (first == iov.size())
+            break;
+
+        const size_t count = (iov.size() - first < (size_t)IOV_MAX) ? iov.size() - first : IOV_MAX;
+        const ssize_t written = pwritev(fd, &iov[first], count, position);
+        XMLW_STATS(++stats.num_syscalls; ++stats.num_writes;)
+
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Error! pwritev() failed: " << strerror(errno) << ". See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+
+        /* No progress while data is left (e.g. the device is full) would loop forever */
+        if (written == 0) {
+            std::cerr << "Error! pwritev() wrote nothing, " << iov.size() - first << " chunks are left. See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+
+        position += written;
+
+        size_t left = written;
+        while (first < iov.size() && left >= iov[first].iov_len) {
+            left -= iov[first].iov_len;
+            ++first;
+        }
+        if (left != 0) {
+            iov[first].iov_base = (char*)iov[first].iov_base + left;
+            iov[first].iov_len -= left;
+        }
+    }
+
+    iov.clear();
+    return true;
+}
+
+/*
+ * Writes down aligned chunk with O_DIRECT, the rest which couldn't be written this way
+ * (if any) is written through the regular descriptor
+ */
+static bool WriteDirect(const int fd, const int direct_fd, const char *data, size_t size, off_t position,
+        WriterStats &stats) {
+
+    const size_t max_chunk = size_t(1) << 30;
+
+    while (size != 0 && direct_fd >= 0) {
+        const size_t chunk = size < max_chunk ? size : max_chunk;
+        const ssize_t written = pwrite(direct_fd, data, chunk, position);
+        XMLW_STATS(++stats.num_syscalls; ++stats.num_writes;)
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0 || (size_t)written % direct_io_alignment != 0) {
+            if (written > 0) {
+                data += written;
+                size -= written;
+                position += written;
+            }
+            break;
+        }
+        data += written;
+        size -= written;
+        position += written;
+    }
+
+    std::vector<iovec> iov;
+    if (size != 0) {
+        iovec chunk;
+        chunk.iov_base = (void*)data;
+        chunk.iov_len = size;
+        iov.push_back(chunk);
+    }
+    return WriteChunks(fd, iov, position, stats);
+}
+
+bool AppendedFileWriter::WriteVectored(const std::string file_name) {
+
+    HeaderBuilder tail(64);
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_HEADER]);)
+        body.clear();
+        WriteBody(body);
+        OpenAppendedSection(body);
+        CloseAppendedSection(tail);
+    }
+    XMLW_STATS(stats.header_bytes = body.size() + tail.size();)
+
+    std::vector<Segment> segments;
+    std::vector<char> prefixes;
+    CollectSegments(segments, prefixes);
+
+    segments.insert(segments.begin(), Segment(body.data(), body.size()));
+    segments.push_back(Segment(tail.data(), tail.size()));
+
+    XMLW_STATS(const double payload_start = StatsTimer::Now(); ++stats.num_syscalls;)
+    const int fd = open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error! Can't open file " << file_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    int direct_fd = -1;
+#ifdef O_DIRECT
+    if (direct_io) {
+        direct_fd = open(file_name.c_str(), O_WRONLY | O_DIRECT);
+        XMLW_STATS(++stats.num_syscalls;)
+    }
+#endif
+
+    bool status = true;
+    std::vector<iovec> iov;
+    off_t pending = 0;          // position of the first pending chunk
+    off_t position = 0;         // position of the next chunk
+
+    for(size_t n = 0; n < segments.size() && status; ++n) {
+        const char *data = segments[n].data;
+        size_t size = segments[n].size;
+
+        if (size == 0)
+            continue;
+
+        /* Generated data sets are written by chunks right after all pending chunks */
+        if (segments[n].fill != NULL) {
+            status = WriteChunks(fd, iov, pending, stats)
+                    && WriteGenerated(segments[n], [&](const char *chunk, size_t chunk_size) {
+                iovec vec;
+                vec.iov_base = (void*)chunk;
+                vec.iov_len = chunk_size;
+                iov.push_back(vec);
+                const bool written = WriteChunks(fd, iov, position, stats);
+                position += chunk_size;
+                return written;
+            });
+            pending = position;
+            continue;
+        }
+
+        /* The aligned middle part of large data sets with matching alignment goes through O_DIRECT */
+        if (direct_fd >= 0 && size >= direct_io_threshold
+                && ((size_t)data - (size_t)position) % direct_io_alignment == 0) {
+            const size_t skip = (direct_io_alignment - position % direct_io_alignment) % direct_io_alignment;
+            const size_t length = (size - skip) / direct_io_alignment * direct_io_alignment;
+
+            if (length != 0) {
+                if (skip != 0) {
+                    iovec chunk;
+                    chunk.iov_base = (void*)data;
+                    chunk.iov_len = skip;
+                    iov.push_back(chunk);
+                }
+                status = WriteChunks(fd, iov, pending, stats)
+                        && WriteDirect(fd, direct_fd, data + skip, length, position + skip, stats);
+
+                data += skip + length;
+                size -= skip + length;
+                position += skip + length;
+                pending = position;
+                if (size == 0)
+                    continue;
+            }
+        }
+
+        iovec chunk;
+        chunk.iov_base = (void*)data;
+        chunk.iov_len = size;
+        iov.push_back(chunk);
+        position += size;
+    }
+
+    if (status)
+        status = WriteChunks(fd, iov, pending, stats);
+    XMLW_STATS(stats.phase_time[WriterStats::PHASE_PAYLOAD] += StatsTimer::Now() - payload_start;)
+
+    XMLW_STATS(StatsTimer close_timer(stats.phase_time[WriterStats::PHASE_CLOSE]);)
+    if (direct_fd >= 0) {
+        close(direct_fd);
+        XMLW_STATS(++stats.num_syscalls;)
+    }
+    if (close(fd) != 0)
+        status = false;
+    XMLW_STATS(++stats.num_syscalls;)
+
+    return status;
+}
+
+/*
+ * Copy of a contiguous chunk of data into the mapped file
+ */
+struct MappedChunk {
+    const char *data;
+    const FillFunction *fill;
+    size_t offset;
+    size_t size;
+    size_t position;
+};
+
+bool AppendedFileWriter::WriteMapped(const std::string file_name) {
+
+    HeaderBuilder tail(64);
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_HEADER]);)
+        body.clear();
+        WriteBody(body);
+        OpenAppendedSection(body);
+        CloseAppendedSection(tail);
+    }
+    XMLW_STATS(stats.header_bytes = body.size() + tail.size();)
+
+    std::vector<Segment> segments;
+    std::vector<char> prefixes;
+    CollectSegments(segments, prefixes);
+
+    segments.insert(segments.begin(), Segment(body.data(), body.size()));
+    segments.push_back(Segment(tail.data(), tail.size()));
+
+    /* Large data sets are split, so they are copied by several threads */
+    std::vector<MappedChunk> chunks;
+    size_t file_size = 0;
+    for(size_t n = 0; n < segments.size(); ++n) {
+        for(size_t pos = 0; pos < segments[n].size; pos += mapped_chunk_size) {
+            MappedChunk chunk;
+            chunk.data = segments[n].data;
+            chunk.fill = segments[n].fill;
+            chunk.offset = pos;
+            chunk.size = segments[n].size - pos < mapped_chunk_size ? segments[n].size - pos : mapped_chunk_size;
+            chunk.position = file_size + pos;
+            chunks.push_back(chunk);
+        }
+        file_size += segments[n].size;
+    }
+
+    XMLW_STATS(const double payload_start = StatsTimer::Now(); ++stats.num_syscalls;)
+    const int fd = open(file_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Error! Can't open file " << file_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    /*
+     * Blocks are allocated in advance, otherwise running out of space while writing
+     * into the mapping is reported by SIGBUS instead of an error code
+     */
+#ifdef __linux__
+    const int err = posix_fallocate(fd, 0, file_size);
+    XMLW_STATS(++stats.num_syscalls;)
+    if (err != 0 && err != EINVAL && err != EOPNOTSUPP) {
+        std::cerr << "Error! Can't allocate " << file_size << " Bytes for file " << file_name << ": "
+                << strerror(err) << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+        close(fd);
+        return false;
+    }
+#endif
+    XMLW_STATS(++stats.num_syscalls;)
+    if (ftruncate(fd, file_size) != 0) {
+        std::cerr << "Error! Can't resize file " << file_name << ": " << strerror(errno) << ". See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, file_size, PROT_WRITE, MAP_SHARED, fd, 0);
+    XMLW_STATS(++stats.num_syscalls;)
+    if (map == MAP_FAILED) {
+        std::cerr << "Error! Can't map file " << file_name << ": " << strerror(errno) << ". See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        close(fd);
+        return false;
+    }
+
+    char *dest = (char*)map;
+    /* Generated data sets are written directly into the mapping */
+    GetThreadPool()->Run(chunks.size(), [&](size_t n) {
+        const MappedChunk &chunk = chunks[n];
+        if (chunk.fill != NULL)
+            (*chunk.fill)(chunk.offset, chunk.size, dest + chunk.position);
+        else
+            std::memcpy(dest + chunk.position, chunk.data + chunk.offset, chunk.size);
+    });
+    XMLW_STATS(
+        stats.num_writes += chunks.size();
+        stats.phase_time[WriterStats::PHASE_PAYLOAD] += StatsTimer::Now() - payload_start;
+    )
+
+    XMLW_STATS(StatsTimer close_timer(stats.phase_time[WriterStats::PHASE_CLOSE]); stats.num_syscalls += 2;)
+    bool status = munmap(map, file_size) == 0;
+    if (close(fd) != 0)
+        status = false;
+
+    return status;
+}
+
+#else
+
+bool AppendedFileWriter::WriteVectored(const std::string file_name) {
+    std::cerr << "Error! Vectored output is not supported on this platform, std::ofstream is used. See "
+            << __FILE__ << ":" << __LINE__ << "\n";
+    return WriteStream(file_name);
+}
+
+bool AppendedFileWriter::WriteMapped(const std::string file_name) {
+    std::cerr << "Error! Memory-mapped output is not supported on this platform, std::ofstream is used. See "
+            << __FILE__ << ":" << __LINE__ << "\n";
+    return WriteStream(file_name);
+}
+
+#endif /* XMLW_POSIX */
+
+}
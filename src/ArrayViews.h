@@ -0,0 +1,234 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef ARRAYVIEWS_H_
+#define ARRAYVIEWS_H_
+
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+namespace xmlw {
+
+/*!
+ * \brief Generates Bytes [offset, offset + size) of a data set into the output buffer
+ * Functions of this type may be called concurrently for different ranges, so they should not modify shared state.
+ */
+typedef std::function<void(size_t offset, size_t size, char *out)> FillFunction;
+
+/*!
+ * \class StridedView
+ * \brief Data set stored with a constant stride between tuples, e.g. a field of an array of structures
+ * Components of a tuple should be stored one after another, tuples are 'stride' Bytes apart:
+ * \code
+ * struct Cell { double volume; float velocity[3]; int flag; };
+ * std::vector<Cell> cells;
+ * writer.AddArray("CellData", "velocity", MakeStridedView(&cells[0].velocity[0], cells.size(), sizeof(Cell), 3));
+ * \endcode
+ * Values are interleaved into the output on the fly, no temporary copy of the whole data set is made.
+ */
+template<typename T>
+class StridedView {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _first Pointer to the first component of the first tuple
+     * @param _num_tuples Number of tuples
+     * @param _stride Distance between consecutive tuples in Bytes
+     * @param _num_of_comp Number of components in each tuple
+     */
+    StridedView(const T *_first, const size_t _num_tuples, const size_t _stride, const size_t _num_of_comp = 1);
+
+    /*!
+     * \brief Returns number of values (tuples times components)
+     */
+    inline size_t size() const;
+
+    /*!
+     * \brief Returns number of components in each tuple
+     */
+    inline size_t GetNumberOfComponents() const;
+
+    /*!
+     * \brief Copies values [first, first + count) into the output buffer one after another
+     */
+    inline void Gather(const size_t first, const size_t count, char *out) const;
+
+    /*!
+     * \brief Copies Bytes [offset, offset + size) of the interleaved data set into the output buffer
+     */
+    inline void Fill(const size_t offset, const size_t size, char *out) const;
+
+private:
+    const char *first;          //!< Pointer to the first tuple
+    size_t num_tuples;          //!< Number of tuples
+    size_t stride;              //!< Distance between tuples in Bytes
+    size_t num_of_comp;         //!< Number of components
+};
+
+/*!
+ * \class SoAView
+ * \brief Data set stored as a structure of arrays, one array per component
+ * \code
+ * std::vector<float> x, y, z;
+ * writer.AddArray("Points", "points", MakeSoAView(x.data(), y.data(), z.data(), x.size()));
+ * \endcode
+ * Components are interleaved into the output on the fly (with SSE shuffles for three Float32 components), no
+ * temporary copy of the whole data set is made.
+ */
+template<typename T>
+class SoAView {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _components Pointers to arrays of components
+     * @param _num_tuples Number of tuples (size of each array)
+     */
+    SoAView(const std::vector<const T*> &_components, const size_t _num_tuples);
+
+    /*!
+     * \brief Returns number of values (tuples times components)
+     */
+    inline size_t size() const;
+
+    /*!
+     * \brief Returns number of components in each tuple
+     */
+    inline size_t GetNumberOfComponents() const;
+
+    /*!
+     * \brief Copies values [first, first + count) into the output buffer one after another
+     */
+    inline void Gather(const size_t first, const size_t count, char *out) const;
+
+    /*!
+     * \brief Copies Bytes [offset, offset + size) of the interleaved data set into the output buffer
+     */
+    inline void Fill(const size_t offset, const size_t size, char *out) const;
+
+private:
+    /*!
+     * \brief Interleaves complete tuples [first, first + count)
+     */
+    inline void Interleave(const size_t first, const size_t count, char *out) const;
+
+private:
+    std::vector<const T*> components;   //!< Arrays of components
+    size_t num_tuples;                  //!< Number of tuples
+};
+
+/*!
+ * \class GeneratedView
+ * \brief Data set which never exists in memory, values are computed by a function while the file is written
+ * The function computes values [first, first + count) (tuples times components) into the output buffer, e.g. a field
+ * derived from other fields cell by cell:
+ * \code
+ * writer.AddArray("CellData", "vorticity", MakeGeneratedView<float>(num_cells, 1,
+ *         [&](size_t first, size_t count, float *out) {
+ *     for(size_t n = 0; n < count; ++n)
+ *         out[n] = VorticityMagnitude(first + n);
+ * }));
+ * \endcode
+ * Only chunks of a bounded size are allocated. The function may be called several times for the same range (hashing,
+ * quantization) and concurrently for different ranges, so it should not modify shared state.
+ */
+template<typename T>
+class GeneratedView {
+public:
+
+    /*!
+     * \brief Computes values [first, first + count) of the data set into the output buffer
+     */
+    typedef std::function<void(size_t first, size_t count, T *out)> Generator;
+
+    /*!
+     * \brief Constructor
+     * @param _num_tuples Number of tuples
+     * @param _num_of_comp Number of components in each tuple
+     * @param _generator Function computing the values
+     */
+    GeneratedView(const size_t _num_tuples, const size_t _num_of_comp, const Generator &_generator);
+
+    /*!
+     * \brief Returns number of values (tuples times components)
+     */
+    inline size_t size() const;
+
+    /*!
+     * \brief Returns number of components in each tuple
+     */
+    inline size_t GetNumberOfComponents() const;
+
+    /*!
+     * \brief Computes values [first, first + count) into the output buffer one after another
+     */
+    inline void Gather(const size_t first, const size_t count, char *out) const;
+
+    /*!
+     * \brief Computes Bytes [offset, offset + size) of the data set into the output buffer
+     */
+    inline void Fill(const size_t offset, const size_t size, char *out) const;
+
+private:
+    Generator generator;        //!< Function computing the values
+    size_t num_tuples;          //!< Number of tuples
+    size_t num_of_comp;         //!< Number of components
+};
+
+/*!
+ * \brief Creates view of the data set stored with a constant stride
+ */
+template<typename T>
+inline StridedView<T> MakeStridedView(const T *first, const size_t num_tuples, const size_t stride,
+        const size_t num_of_comp = 1);
+
+/*!
+ * \brief Creates view of the data set stored as three separate arrays of components
+ */
+template<typename T>
+inline SoAView<T> MakeSoAView(const T *x, const T *y, const T *z, const size_t num_tuples);
+
+/*!
+ * \brief Creates view of the data set computed on the fly
+ */
+template<typename T>
+inline GeneratedView<T> MakeGeneratedView(const size_t num_tuples, const size_t num_of_comp,
+        const typename GeneratedView<T>::Generator &generator);
+
+/*!
+ * \brief Copies Bytes [offset, offset + size) of the view into the output buffer, values which are cut
+ * by the borders of the range are copied partially
+ */
+template<typename T, typename View>
+inline void FillValues(const View &view, const size_t offset, const size_t size, char *out);
+
+} /* namespace xmlw */
+
+#include "ArrayViews.inl"
+
+#endif /* ARRAYVIEWS_H_ */
@@ -0,0 +1,281 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef ARRAYVIEWS_INL_
+#define ARRAYVIEWS_INL_
+
+#include <cstring>
+#include <type_traits>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+namespace xmlw {
+
+/*
+ * Interleaves complete tuples [first, first + count) of separate arrays of components
+ */
+template<typename T>
+inline void InterleaveTuples(const T *const *components, const size_t num_of_comp, const size_t first,
+        const size_t count, char *out) {
+
+    if (num_of_comp == 1) {
+        if (count != 0)
+            std::memcpy(out, components[0] + first, count * sizeof(T));
+        return;
+    }
+
+    for(size_t t = first; t < first + count; ++t)
+        for(size_t c = 0; c < num_of_comp; ++c) {
+            std::memcpy(out, components[c] + t, sizeof(T));
+            out += sizeof(T);
+        }
+}
+
+inline void InterleaveTuples(const float *const *components, const size_t num_of_comp, const size_t first,
+        const size_t count, char *out) {
+
+    size_t done = 0;
+
+#if defined(__SSE__)
+    /*
+     * Four tuples (x0..x3, y0..y3, z0..z3) are turned into three registers:
+     * (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3)
+     */
+    if (num_of_comp == 3) {
+        const float *x = components[0] + first;
+        const float *y = components[1] + first;
+        const float *z = components[2] + first;
+        float *dest = (float*)out;
+
+        for(; done + 4 <= count; done += 4) {
+            const __m128 vx = _mm_loadu_ps(x + done);
+            const __m128 vy = _mm_loadu_ps(y + done);
+            const __m128 vz = _mm_loadu_ps(z + done);
+            const __m128 xy_lo = _mm_unpacklo_ps(vx, vy);                               // x0 y0 x1 y1
+            const __m128 xy_hi = _mm_unpackhi_ps(vx, vy);                               // x2 y2 x3 y3
+            const __m128 zx = _mm_shuffle_ps(vz, xy_lo, _MM_SHUFFLE(2, 2, 0, 0));       // z0 z0 x1 x1
+            const __m128 yz = _mm_shuffle_ps(xy_lo, vz, _MM_SHUFFLE(1, 1, 3, 3));       // y1 y1 z1 z1
+            const __m128 zxy = _mm_shuffle_ps(vz, xy_hi, _MM_SHUFFLE(3, 2, 3, 2));      // z2 z3 x3 y3
+
+            _mm_storeu_ps(dest + 3 * done, _mm_shuffle_ps(xy_lo, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+            _mm_storeu_ps(dest + 3 * done + 4, _mm_shuffle_ps(yz, xy_hi, _MM_SHUFFLE(1, 0, 2, 0)));
+            _mm_storeu_ps(dest + 3 * done + 8, _mm_shuffle_ps(zxy, zxy, _MM_SHUFFLE(1, 3, 2, 0)));
+        }
+    }
+#endif
+
+    InterleaveTuples<float>(components, num_of_comp, first + done, count - done,
+            out + done * num_of_comp * sizeof(float));
+}
+
+template<typename T, typename View>
+inline void FillValues(const View &view, const size_t offset, const size_t size, char *out) {
+
+    size_t value = offset / sizeof(T);
+    size_t left = size;
+    char tmp[sizeof(T)];
+
+    /* Value cut by the beginning of the range */
+    const size_t skip = offset % sizeof(T);
+    if (skip != 0 && left != 0) {
+        const size_t n = (sizeof(T) - skip < left) ? sizeof(T) - skip : left;
+        view.Gather(value, 1, tmp);
+        std::memcpy(out, tmp + skip, n);
+        out += n;
+        left -= n;
+        ++value;
+    }
+
+    const size_t count = left / sizeof(T);
+    view.Gather(value, count, out);
+    out += count * sizeof(T);
+    left -= count * sizeof(T);
+    value += count;
+
+    /* Value cut by the end of the range */
+    if (left != 0) {
+        view.Gather(value, 1, tmp);
+        std::memcpy(out, tmp, left);
+    }
+}
+
+template<typename T>
+StridedView<T>::StridedView(const T *_first, const size_t _num_tuples, const size_t _stride,
+        const size_t _num_of_comp) :
+        first((const char*)_first), num_tuples(_num_tuples), stride(_stride), num_of_comp(_num_of_comp) {
+}
+
+template<typename T>
+inline size_t StridedView<T>::size() const {
+    return num_tuples * num_of_comp;
+}
+
+template<typename T>
+inline size_t StridedView<T>::GetNumberOfComponents() const {
+    return num_of_comp;
+}
+
+template<typename T>
+inline void StridedView<T>::Gather(const size_t first_value, const size_t count, char *out) const {
+
+    size_t value = first_value;
+    const size_t last = first_value + count;
+
+    /* Components of a tuple are contiguous, so complete tuples are copied at once */
+    while (value < last) {
+        const size_t t = value / num_of_comp;
+        const size_t c = value % num_of_comp;
+        const size_t n = (num_of_comp - c < last - value) ? num_of_comp - c : last - value;
+        const char *src = first + t * stride + c * sizeof(T);
+
+        std::memcpy(out, src, n * sizeof(T));
+        out += n * sizeof(T);
+        value += n;
+    }
+}
+
+template<typename T>
+inline void StridedView<T>::Fill(const size_t offset, const size_t size, char *out) const {
+    FillValues<T>(*this, offset, size, out);
+}
+
+template<typename T>
+SoAView<T>::SoAView(const std::vector<const T*> &_components, const size_t _num_tuples) :
+        components(_components), num_tuples(_num_tuples) {
+}
+
+template<typename T>
+inline size_t SoAView<T>::size() const {
+    return num_tuples * components.size();
+}
+
+template<typename T>
+inline size_t SoAView<T>::GetNumberOfComponents() const {
+    return components.size();
+}
+
+template<typename T>
+inline void SoAView<T>::Interleave(const size_t first, const size_t count, char *out) const {
+    InterleaveTuples(components.data(), components.size(), first, count, out);
+}
+
+template<typename T>
+inline void SoAView<T>::Gather(const size_t first_value, const size_t count, char *out) const {
+
+    const size_t num_of_comp = components.size();
+    size_t value = first_value;
+    const size_t last = first_value + count;
+
+    /* Leading part of an incomplete tuple, short ranges (e.g. values cut by borders of chunks) are copied entirely */
+    while (value < last && (value % num_of_comp != 0 || count < 16)) {
+        std::memcpy(out, components[value % num_of_comp] + value / num_of_comp, sizeof(T));
+        out += sizeof(T);
+        ++value;
+    }
+
+    const size_t num_full = (last - value) / num_of_comp;
+    Interleave(value / num_of_comp, num_full, out);
+    out += num_full * num_of_comp * sizeof(T);
+    value += num_full * num_of_comp;
+
+    /* Trailing part of an incomplete tuple */
+    while (value < last) {
+        std::memcpy(out, components[value % num_of_comp] + value / num_of_comp, sizeof(T));
+        out += sizeof(T);
+        ++value;
+    }
+}
+
+template<typename T>
+inline void SoAView<T>::Fill(const size_t offset, const size_t size, char *out) const {
+    FillValues<T>(*this, offset, size, out);
+}
+
+template<typename T>
+GeneratedView<T>::GeneratedView(const size_t _num_tuples, const size_t _num_of_comp, const Generator &_generator) :
+        generator(_generator), num_tuples(_num_tuples), num_of_comp(_num_of_comp) {
+}
+
+template<typename T>
+inline size_t GeneratedView<T>::size() const {
+    return num_tuples * num_of_comp;
+}
+
+template<typename T>
+inline size_t GeneratedView<T>::GetNumberOfComponents() const {
+    return num_of_comp;
+}
+
+template<typename T>
+inline void GeneratedView<T>::Gather(const size_t first, const size_t count, char *out) const {
+
+    if ((size_t)out % std::alignment_of<T>::value == 0) {
+        if (count != 0)
+            generator(first, count, (T*)out);
+        return;
+    }
+
+    /* Values can't be stored at a misaligned position directly */
+    const size_t max_chunk = 1024;
+    T chunk[max_chunk];
+    for(size_t done = 0; done < count; done += max_chunk) {
+        const size_t n = (count - done < max_chunk) ? count - done : max_chunk;
+        generator(first + done, n, chunk);
+        std::memcpy(out + done * sizeof(T), chunk, n * sizeof(T));
+    }
+}
+
+template<typename T>
+inline void GeneratedView<T>::Fill(const size_t offset, const size_t size, char *out) const {
+    FillValues<T>(*this, offset, size, out);
+}
+
+template<typename T>
+inline StridedView<T> MakeStridedView(const T *first, const size_t num_tuples, const size_t stride,
+        const size_t num_of_comp) {
+    return StridedView<T>(first, num_tuples, stride, num_of_comp);
+}
+
+template<typename T>
+inline SoAView<T> MakeSoAView(const T *x, const T *y, const T *z, const size_t num_tuples) {
+    std::vector<const T*> components(3);
+    components[0] = x;
+    components[1] = y;
+    components[2] = z;
+    return SoAView<T>(components, num_tuples);
+}
+
+template<typename T>
+inline GeneratedView<T> MakeGeneratedView(const size_t num_tuples, const size_t num_of_comp,
+        const typename GeneratedView<T>::Generator &generator) {
+    return GeneratedView<T>(num_tuples, num_of_comp, generator);
+}
+
+}
+
+#endif /* ARRAYVIEWS_INL_ */
@@ -0,0 +1,134 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef ASCIIENCODER_H_
+#define ASCIIENCODER_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace xmlw {
+
+class ThreadPool;
+
+/*!
+ * \brief True for types formatted by AsciiEncoder: integers (except of bool), float and double
+ * Other types (bool, long double, ...) are written through the stream operator.
+ */
+template<typename T>
+struct IsAsciiEncodable : std::integral_constant<bool, (std::is_integral<T>::value && !std::is_same<T, bool>::value)
+        || std::is_same<T, float>::value || std::is_same<T, double>::value> { };
+
+/*!
+ * \class AsciiEncoder
+ * \brief Formats arrays of numbers into text for the ASCII mode
+ * Writing values one by one through the stream operator goes through locale-aware formatting for every element and
+ * loses precision of floating point numbers (6 digits by default). This class formats the whole array into a large
+ * reusable buffer and flushes it into the stream in big chunks. Integers are formatted directly, floating point
+ * numbers are formatted with std::to_chars (the shortest representation which can be read back exactly) when the
+ * standard library provides it, otherwise with 9 (float) or 17 (double) significant digits, which also guarantees
+ * that values are read back exactly.
+ */
+class AsciiEncoder {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _buffer_size Size of the internal buffer in Bytes
+     */
+    explicit AsciiEncoder(const size_t _buffer_size = 1 << 20);
+
+    /*!
+     * \brief Sets number of values written in one line (0 - all values in one line)
+     * @param _values_per_line Number of values
+     */
+    inline void SetValuesPerLine(const size_t _values_per_line);
+
+    /*!
+     * \brief Formats array and writes it into the stream
+     * \note The output is terminated by the end of line
+     * @param data Pointer to the first element
+     * @param size Number of elements
+     * @param stream Output stream
+     */
+    template<typename T, typename Stream>
+    inline void Encode(const T *data, const size_t size, Stream &stream);
+
+    /*!
+     * \brief Formats array by several threads and writes it into the stream
+     * Chunks of whole lines are formatted by the pool ahead of the calling thread, which writes formatted chunks
+     * in order. The output is the same as the one of Encode() without the pool.
+     * @param data Pointer to the first element
+     * @param size Number of elements
+     * @param stream Output stream
+     * @param pool Threads used to format chunks (NULL - format serially)
+     */
+    template<typename T, typename Stream>
+    inline void Encode(const T *data, const size_t size, Stream &stream, ThreadPool *pool);
+
+    /*!
+     * \brief Formats a single value
+     * @param value Value to be formatted
+     * @param pos Position in the buffer, at least 32 Bytes should be available
+     * @return Position right after the formatted value
+     */
+    template<typename T>
+    static inline char *Format(const T value, char *pos);
+    static inline char *Format(const float value, char *pos);
+    static inline char *Format(const double value, char *pos);
+
+private:
+    /*!
+     * \brief Formats values starting at the beginning of a line, each one followed by a space or the end of line
+     * @return Position right after the last formatted value
+     */
+    template<typename T>
+    inline char *FormatValues(const T *data, const size_t size, char *pos) const;
+
+    /*!
+     * \brief Formats integer value
+     */
+    template<typename T>
+    static inline char *FormatInteger(const T value, char *pos);
+
+    /*!
+     * \brief Replaces decimal point of the current locale by '.'
+     */
+    static inline void FixDecimalPoint(char *begin, char *end);
+
+private:
+    std::vector<char> buffer;       //!< Buffer for formatted values
+    size_t buffer_size;             //!< Size of the buffer
+    size_t values_per_line;         //!< Number of values in one line
+};
+
+} /* namespace xmlw */
+
+#include "AsciiEncoder.inl"
+
+#endif /* ASCIIENCODER_H_ */
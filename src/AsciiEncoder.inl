@@ -0,0 +1,234 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef ASCIIENCODER_INL_
+#define ASCIIENCODER_INL_
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <clocale>
+#include <type_traits>
+#include <memory>
+
+#include "ThreadPool.h"
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+namespace xmlw {
+
+/* Maximum length of a single formatted value */
+static const size_t ascii_max_value_length = 32;
+
+inline AsciiEncoder::AsciiEncoder(const size_t _buffer_size) :
+        buffer_size(_buffer_size < 4 * ascii_max_value_length ? 4 * ascii_max_value_length : _buffer_size),
+        values_per_line(0) {
+}
+
+inline void AsciiEncoder::SetValuesPerLine(const size_t _values_per_line) {
+    values_per_line = _values_per_line;
+}
+
+template<typename T, typename Stream>
+inline void AsciiEncoder::Encode(const T *data, const size_t size, Stream &stream) {
+
+    /* The buffer is allocated once and reused by all following calls */
+    if (buffer.size() != buffer_size)
+        buffer.resize(buffer_size);
+
+    char *begin = &buffer[0];
+    char *end = begin + buffer_size - ascii_max_value_length - 1;
+    char *pos = begin;
+    size_t in_line = 0;
+
+    for(size_t n = 0; n < size; ++n) {
+        pos = Format(data[n], pos);
+        if (++in_line == values_per_line) {
+            *pos++ = '\n';
+            in_line = 0;
+        }
+        else {
+            *pos++ = ' ';
+        }
+
+        if (pos >= end) {
+            stream.write(begin, pos - begin);
+            pos = begin;
+        }
+    }
+
+    if (in_line != 0 || size == 0)
+        *pos++ = '\n';
+    stream.write(begin, pos - begin);
+}
+
+template<typename T, typename Stream>
+inline void AsciiEncoder::Encode(const T *data, const size_t size, Stream &stream, ThreadPool *pool) {
+
+    /* Chunks consist of whole lines, so every chunk is formatted independently of the previous ones */
+    const size_t line = values_per_line != 0 ? values_per_line : 1;
+    const size_t chunk_values = std::max<size_t>(1, (size_t(1) << 18) / (ascii_max_value_length + 1) / line) * line;
+    const size_t num_chunks = (size + chunk_values - 1) / chunk_values;
+
+    if (pool == NULL || pool->GetNumberOfThreads() == 1 || num_chunks < 2) {
+        Encode(data, size, stream);
+        return;
+    }
+
+    /*
+     * Chunks are formatted by rounds, each round into its own half of the buffers: while the calling thread
+     * writes one round the pool formats the next one
+     */
+    const size_t round = 2 * pool->GetNumberOfThreads();
+    const size_t chunk_size = chunk_values * (ascii_max_value_length + 1) + 1;
+    std::vector<std::unique_ptr<char[]> > chunks(2 * round);
+    std::vector<size_t> lengths(2 * round);
+    for(size_t n = 0; n < chunks.size(); ++n)
+        chunks[n].reset(new char[chunk_size]);
+
+    const size_t num_rounds = (num_chunks + round - 1) / round;
+    std::vector<ThreadPool::Job> jobs(num_rounds);
+    std::function<ThreadPool::Job(size_t)> submit = [&](size_t r) {
+        const size_t first = r * round;
+        const size_t count = std::min(round, num_chunks - first);
+        return pool->Submit(count, [&, first, r](size_t n) {
+            const size_t chunk = first + n;
+            const size_t begin = chunk * chunk_values;
+            const size_t values = std::min(chunk_values, size - begin);
+            char *out = chunks[(r % 2) * round + n].get();
+            char *pos = FormatValues(data + begin, values, out);
+            if (chunk == num_chunks - 1 && (values_per_line == 0 || size % values_per_line != 0))
+                *pos++ = '\n';
+            lengths[(r % 2) * round + n] = pos - out;
+        });
+    };
+
+    jobs[0] = submit(0);
+    for(size_t r = 0; r < num_rounds; ++r) {
+        if (r + 1 < num_rounds)
+            jobs[r + 1] = submit(r + 1);
+        pool->Wait(jobs[r]);
+        const size_t count = std::min(round, num_chunks - r * round);
+        for(size_t n = 0; n < count; ++n)
+            stream.write(chunks[(r % 2) * round + n].get(), lengths[(r % 2) * round + n]);
+    }
+}
+
+template<typename T>
+inline char *AsciiEncoder::FormatValues(const T *data, const size_t size, char *pos) const {
+    size_t in_line = 0;
+    for(size_t n = 0; n < size; ++n) {
+        pos = Format(data[n], pos);
+        if (++in_line == values_per_line) {
+            *pos++ = '\n';
+            in_line = 0;
+        }
+        else {
+            *pos++ = ' ';
+        }
+    }
+    return pos;
+}
+
+template<typename T>
+inline char *AsciiEncoder::Format(const T value, char *pos) {
+    static_assert(IsAsciiEncodable<T>::value, "AsciiEncoder formats only integers (except of bool), float and double");
+    return FormatInteger(value, pos);
+}
+
+inline char *AsciiEncoder::Format(const float value, char *pos) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    return std::to_chars(pos, pos + ascii_max_value_length, value).ptr;
+#else
+    char *end = pos + std::snprintf(pos, ascii_max_value_length, "%.9g", value);
+    FixDecimalPoint(pos, end);
+    return end;
+#endif
+}
+
+inline char *AsciiEncoder::Format(const double value, char *pos) {
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    return std::to_chars(pos, pos + ascii_max_value_length, value).ptr;
+#else
+    char *end = pos + std::snprintf(pos, ascii_max_value_length, "%.17g", value);
+    FixDecimalPoint(pos, end);
+    return end;
+#endif
+}
+
+template<typename T>
+inline char *AsciiEncoder::FormatInteger(const T value, char *pos) {
+    typedef typename std::make_unsigned<T>::type U;
+
+    static const char pairs[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+    /* Digits are written backwards into the temporary buffer, two digits per division */
+    char digits[24];
+    char *first = digits + sizeof(digits);
+    U number = static_cast<U>(value);
+
+    if (std::is_signed<T>::value && value < T(0)) {
+        *pos++ = '-';
+        number = U(0) - number;
+    }
+
+    while (number >= 100) {
+        const size_t pair = 2 * (number % 100);
+        number /= 100;
+        *--first = pairs[pair + 1];
+        *--first = pairs[pair];
+    }
+    if (number >= 10) {
+        *--first = pairs[2 * number + 1];
+        *--first = pairs[2 * number];
+    }
+    else
+        *--first = static_cast<char>('0' + number);
+
+    const size_t length = digits + sizeof(digits) - first;
+    std::memcpy(pos, first, length);
+    return pos + length;
+}
+
+inline void AsciiEncoder::FixDecimalPoint(char *begin, char *end) {
+    const char point = *std::localeconv()->decimal_point;
+    if (point == '.')
+        return;
+    for(; begin != end; ++begin)
+        if (*begin == point)
+            *begin = '.';
+}
+
+}
+
+#endif /* ASCIIENCODER_INL_ */
@@ -0,0 +1,152 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "AsyncWriter.h"
+
+#include <iostream>
+
+namespace xmlw {
+
+AsyncWriter::AsyncWriter(const size_t _max_queue_depth) :
+        max_queue_depth(_max_queue_depth == 0 ? 1 : _max_queue_depth), num_staging(0), num_busy(0),
+        stop(false) {
+    worker = std::thread(&AsyncWriter::Worker, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    queued.notify_all();
+    worker.join();
+}
+
+std::future<bool> AsyncWriter::Write(const AppendedFileWriter &writer, const std::string file_name) {
+    return Write(std::unique_ptr<AppendedFileWriter>(writer.Clone()), file_name);
+}
+
+std::future<bool> AsyncWriter::Write(std::unique_ptr<AppendedFileWriter> writer, const std::string file_name) {
+
+    std::unique_ptr<Task> task(new Task);
+    std::future<bool> result = task->done.get_future();
+
+    /* Back-pressure: the caller waits while the queue is full */
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        written.wait(lock, [this] { return queue.size() + num_staging < max_queue_depth; });
+        ++num_staging;
+    }
+
+    try {
+        task->buffer = TakeBuffer(writer->GetSnapshotSize());
+        writer->Snapshot(task->buffer->data());
+    }
+    catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --num_staging;
+        }
+        written.notify_all();
+        throw;
+    }
+    task->writer = std::move(writer);
+    task->file_name = file_name;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(std::move(task));
+        --num_staging;
+    }
+    queued.notify_one();
+
+    return result;
+}
+
+void AsyncWriter::Wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    written.wait(lock, [this] { return queue.empty() && num_staging == 0 && num_busy == 0; });
+}
+
+void AsyncWriter::Worker() {
+
+    while (true) {
+        std::unique_ptr<Task> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this] { return stop || !queue.empty(); });
+            if (queue.empty())
+                return;
+            task = std::move(queue.front());
+            queue.pop_front();
+            ++num_busy;
+        }
+        /* The queue has a free slot now */
+        written.notify_all();
+
+        try {
+            task->done.set_value(task->writer->Write(task->file_name));
+        }
+        catch (...) {
+            task->done.set_exception(std::current_exception());
+        }
+
+        /* Data sets owned by the writer are released here, the staging buffer goes back to the pool */
+        task->writer.reset();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pool.push_back(std::move(task->buffer));
+            --num_busy;
+        }
+        written.notify_all();
+    }
+}
+
+std::unique_ptr<std::vector<char> > AsyncWriter::TakeBuffer(const size_t size) {
+
+    std::unique_ptr<std::vector<char> > buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        /* The largest free buffer is the best candidate to avoid reallocation */
+        size_t best = pool.size();
+        for(size_t n = 0; n < pool.size(); ++n)
+            if (best == pool.size() || pool[n]->size() > pool[best]->size())
+                best = n;
+        if (best != pool.size()) {
+            buffer = std::move(pool[best]);
+            pool.erase(pool.begin() + best);
+        }
+    }
+
+    if (!buffer)
+        buffer.reset(new std::vector<char>);
+    if (buffer->size() < size)
+        buffer->resize(size);
+    return buffer;
+}
+
+}
@@ -0,0 +1,139 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef ASYNCWRITER_H_
+#define ASYNCWRITER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+
+#include "AppendedFileWriter.h"
+
+namespace xmlw {
+
+/*!
+ * \class AsyncWriter
+ * \brief Writes files in the background thread
+ * Write() makes a snapshot of the data set and returns immediately, while the dedicated I/O thread assembles the
+ * main body and writes down the appended data. Data sets owned by the writer (moved into it) are taken as they are,
+ * all other data sets are copied into a staging buffer. Staging buffers are taken from a pool and returned into it
+ * once the file is written, so with the queue depth of 1 two buffers are used in turn (one is being written, the
+ * other one is being filled). If the queue is full Write() blocks until the oldest file is written.
+ * Writers of derived classes (UnstructuredGridWriter, FieldAppender, ...) are copied by AppendedFileWriter::Clone(),
+ * so the file is written by their own Write(). ParallelWriter::Write() is collective: all ranks should queue their
+ * files in the same order and MPI should be initialized with MPI_THREAD_MULTIPLE.
+ * Typical usage:
+ *   xmlw::AsyncWriter async;
+ *   for(each step) {
+ *       compute();
+ *       xmlw::AppendedFileWriter writer("UnstructuredGrid");
+ *       ... register data sets ...
+ *       std::future<bool> done = async.Write(writer, "step_" + std::to_string(step) + ".vtu");
+ *   }
+ *   async.Wait();
+ */
+class AsyncWriter {
+public:
+
+    /*!
+     * \brief Constructor, starts the I/O thread
+     * @param _max_queue_depth Maximum number of files waiting to be written
+     */
+    explicit AsyncWriter(const size_t _max_queue_depth = 1);
+
+    /*!
+     * \brief Destructor, writes down all queued files and stops the I/O thread
+     */
+    ~AsyncWriter();
+
+    /*!
+     * \brief Queues the file, data sets not owned by the writer are copied
+     * The writer is copied by AppendedFileWriter::Clone(), so it keeps its class.
+     * @param writer Writer with all data sets registered
+     * @param file_name Name of the file
+     * @return Future which becomes ready when the file is written (true on success)
+     */
+    std::future<bool> Write(const AppendedFileWriter &writer, const std::string file_name);
+
+    /*!
+     * \brief Queues the file taking ownership of the writer, data sets not owned by the writer are copied
+     * @param writer Writer with all data sets registered
+     * @param file_name Name of the file
+     * @return Future which becomes ready when the file is written (true on success)
+     */
+    std::future<bool> Write(std::unique_ptr<AppendedFileWriter> writer, const std::string file_name);
+
+    /*!
+     * \brief Waits until all queued files are written
+     */
+    void Wait();
+
+private:
+    AsyncWriter(const AsyncWriter&);
+    AsyncWriter &operator=(const AsyncWriter&);
+
+    /*!
+     * \brief File waiting to be written
+     */
+    struct Task {
+        std::unique_ptr<AppendedFileWriter> writer;     //!< Snapshot of the writer
+        std::string file_name;                          //!< Name of the file
+        std::unique_ptr<std::vector<char> > buffer;     //!< Staging buffer with copies of data sets
+        std::promise<bool> done;                        //!< Result of writing
+    };
+
+    /*!
+     * \brief Main loop of the I/O thread
+     */
+    void Worker();
+
+    /*!
+     * \brief Returns staging buffer of at least the given size
+     */
+    std::unique_ptr<std::vector<char> > TakeBuffer(const size_t size);
+
+private:
+    size_t max_queue_depth;                                 //!< Maximum number of queued files
+    std::deque<std::unique_ptr<Task> > queue;               //!< Queued files
+    std::vector<std::unique_ptr<std::vector<char> > > pool; //!< Free staging buffers
+    size_t num_staging;                                     //!< Number of files being copied into the queue
+    size_t num_busy;                                        //!< Number of files being written
+    std::mutex mutex;                                       //!< Protects the queue and the pool
+    std::condition_variable queued;                         //!< Signals the I/O thread about a new file
+    std::condition_variable written;                        //!< Signals about a written file
+    bool stop;                                              //!< Signals the I/O thread to quit
+    std::thread worker;                                     //!< I/O thread
+};
+
+} /* namespace xmlw */
+
+#endif /* ASYNCWRITER_H_ */
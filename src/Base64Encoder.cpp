@@ -0,0 +1,256 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "Base64Encoder.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define XMLW_BASE64_X86
+#include <immintrin.h>
+#endif
+
+namespace xmlw {
+
+static const char base64_table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*
+ * Encodes the tail of the data (or the whole data), which is not handled by vector kernels
+ */
+static size_t EncodeScalar(const unsigned char *in, const size_t size, char *out) {
+
+    char *pos = out;
+    size_t n = 0;
+
+    for(; n + 3 <= size; n += 3) {
+        const unsigned int word = (in[n] << 16) | (in[n + 1] << 8) | in[n + 2];
+        pos[0] = base64_table[(word >> 18) & 0x3f];
+        pos[1] = base64_table[(word >> 12) & 0x3f];
+        pos[2] = base64_table[(word >> 6) & 0x3f];
+        pos[3] = base64_table[word & 0x3f];
+        pos += 4;
+    }
+
+    if (n + 1 == size) {
+        const unsigned int word = in[n] << 16;
+        pos[0] = base64_table[(word >> 18) & 0x3f];
+        pos[1] = base64_table[(word >> 12) & 0x3f];
+        pos[2] = '=';
+        pos[3] = '=';
+        pos += 4;
+    }
+    else if (n + 2 == size) {
+        const unsigned int word = (in[n] << 16) | (in[n + 1] << 8);
+        pos[0] = base64_table[(word >> 18) & 0x3f];
+        pos[1] = base64_table[(word >> 12) & 0x3f];
+        pos[2] = base64_table[(word >> 6) & 0x3f];
+        pos[3] = '=';
+        pos += 4;
+    }
+
+    return pos - out;
+}
+
+#ifdef XMLW_BASE64_X86
+
+/*
+ * Vector kernels follow the approach of W. Mula and D. Lemire ("Faster Base64 Encoding and Decoding
+ * Using AVX2 Instructions"): 12 input bytes are spread over 16 lanes so that every 32-bit lane holds
+ * 3 bytes, four 6-bit indices are extracted with multiplications and translated into ASCII by adding
+ * an offset which depends on the range of the index.
+ */
+
+__attribute__((target("ssse3")))
+static inline __m128i Base64Split128(__m128i in) {
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3")))
+static inline __m128i Base64Translate128(const __m128i indices) {
+    const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    const __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+    result = _mm_shuffle_epi8(shift_lut, result);
+    return _mm_add_epi8(result, indices);
+}
+
+__attribute__((target("ssse3")))
+static size_t EncodeSSSE3(const unsigned char *in, const size_t size, char *out) {
+
+    size_t n = 0;
+    char *pos = out;
+
+    /* Each step reads 16 bytes but consumes only 12 of them */
+    for(; n + 16 <= size; n += 12) {
+        const __m128i data = _mm_loadu_si128((const __m128i*)(in + n));
+        _mm_storeu_si128((__m128i*)pos, Base64Translate128(Base64Split128(data)));
+        pos += 16;
+    }
+
+    return (pos - out) + EncodeScalar(in + n, size - n, pos);
+}
+
+__attribute__((target("avx2")))
+static size_t EncodeAVX2(const unsigned char *in, const size_t size, char *out) {
+
+    size_t n = 0;
+    char *pos = out;
+
+    const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+    const __m256i shift_lut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+
+    /* Each lane gets its own 12 bytes, the step reads 28 bytes but consumes only 24 of them */
+    for(; n + 28 <= size; n += 24) {
+        const __m128i lo = _mm_loadu_si128((const __m128i*)(in + n));
+        const __m128i hi = _mm_loadu_si128((const __m128i*)(in + n + 12));
+        __m256i data = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+
+        data = _mm256_shuffle_epi8(data, shuffle);
+        const __m256i t0 = _mm256_and_si256(data, _mm256_set1_epi32(0x0fc0fc00));
+        const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+        const __m256i t2 = _mm256_and_si256(data, _mm256_set1_epi32(0x003f03f0));
+        const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(t1, t3);
+
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        const __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        result = _mm256_shuffle_epi8(shift_lut, result);
+        result = _mm256_add_epi8(result, indices);
+
+        _mm256_storeu_si256((__m256i*)pos, result);
+        pos += 32;
+    }
+
+    return (pos - out) + EncodeSSSE3(in + n, size - n, pos);
+}
+
+#endif /* XMLW_BASE64_X86 */
+
+typedef size_t (*Base64Kernel)(const unsigned char*, const size_t, char*);
+
+/*!
+ * \brief Kernel selected for the processor
+ */
+struct Base64KernelInfo {
+    Base64Kernel kernel;
+    const char *name;
+};
+
+/*
+ * Selects the fastest kernel supported by the processor
+ */
+static Base64KernelInfo SelectKernel() {
+    Base64KernelInfo info;
+    info.kernel = EncodeScalar;
+    info.name = "scalar";
+#ifdef XMLW_BASE64_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        info.kernel = EncodeAVX2;
+        info.name = "avx2";
+    }
+    else if (__builtin_cpu_supports("ssse3")) {
+        info.kernel = EncodeSSSE3;
+        info.name = "ssse3";
+    }
+#endif
+    return info;
+}
+
+/*
+ * The selection is done once, on the first use
+ */
+static const Base64KernelInfo &Kernel() {
+    static const Base64KernelInfo info = SelectKernel();
+    return info;
+}
+
+Base64Encoder::Base64Encoder(const size_t _chunk_size) :
+        chunk_size(_chunk_size < 3 ? 3 : _chunk_size / 3 * 3) {
+}
+
+size_t Base64Encoder::Encode(const char *in, const size_t size, char *out) {
+    return Kernel().kernel((const unsigned char*)in, size, out);
+}
+
+const char *Base64Encoder::GetKernelName() {
+    return Kernel().name;
+}
+
+size_t Base64Encoder::DecodedSize(const char *in, const size_t size) {
+    if (size % 4 != 0 || size == 0)
+        return 0;
+    return size / 4 * 3 - (in[size - 1] == '=' ? 1 : 0) - (in[size - 2] == '=' ? 1 : 0);
+}
+
+bool Base64Encoder::Decode(const char *in, const size_t size, char *out) {
+
+    if (size % 4 != 0)
+        return false;
+
+    /* Inverse of the encoding table, 0xff marks characters which don't belong to the alphabet */
+    static unsigned char inverse[256];
+    static const bool initialized = [] {
+        std::memset(inverse, 0xff, sizeof(inverse));
+        for(unsigned char n = 0; n < 64; ++n)
+            inverse[(unsigned char)base64_table[n]] = n;
+        return true;
+    }();
+    (void)initialized;
+
+    const unsigned char *pos = (const unsigned char*)in;
+    const size_t decoded = DecodedSize(in, size);
+    for(size_t n = 0; n < decoded; n += 3, pos += 4) {
+        const unsigned int a = inverse[pos[0]], b = inverse[pos[1]];
+        const unsigned int c = n + 1 < decoded ? inverse[pos[2]] : 0;
+        const unsigned int d = n + 2 < decoded ? inverse[pos[3]] : 0;
+        if ((a | b | c | d) > 0x3f)
+            return false;
+
+        const unsigned int word = (a << 18) | (b << 12) | (c << 6) | d;
+        out[n] = (char)(word >> 16);
+        if (n + 1 < decoded)
+            out[n + 1] = (char)(word >> 8);
+        if (n + 2 < decoded)
+            out[n + 2] = (char)word;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,124 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef BASE64ENCODER_H_
+#define BASE64ENCODER_H_
+
+#include <string>
+#include <vector>
+
+namespace xmlw {
+
+/*!
+ * \class Base64Encoder
+ * \brief Base64 encoder for the binary mode of VTK XML files
+ * In the binary mode data is written inside the 'DataArray' section encoded in base64. The header (the length of
+ * the data set or the compression header) and the data itself are encoded separately, i.e. each of them has its own
+ * padding. Large inputs are encoded in chunks through a reusable buffer. Every chunk except the last one has a
+ * length divisible by 3, so chunks concatenate into a valid base64 string.
+ * The kernel is selected at runtime: AVX2 or SSSE3 if the processor supports them, scalar one otherwise.
+ */
+class Base64Encoder {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _chunk_size Size of input chunks in Bytes (rounded down to a multiple of 3)
+     */
+    explicit Base64Encoder(const size_t _chunk_size = 3 << 18);
+
+    /*!
+     * \brief Returns length of encoded data
+     * @param size Size of input data in Bytes
+     */
+    static inline size_t EncodedSize(const size_t size) {
+        return (size + 2) / 3 * 4;
+    }
+
+    /*!
+     * \brief Encodes data
+     * @param in Pointer to input data
+     * @param size Size of input data in Bytes
+     * @param out Output buffer of at least EncodedSize(size) Bytes
+     * @return Number of written characters
+     */
+    static size_t Encode(const char *in, const size_t size, char *out);
+
+    /*!
+     * \brief Returns size of decoded data (the padding is taken into account)
+     * @param in Pointer to encoded data
+     * @param size Number of characters, should be divisible by 4
+     */
+    static size_t DecodedSize(const char *in, const size_t size);
+
+    /*!
+     * \brief Decodes data (reading of files in the binary mode, see VTK_XML_Reader)
+     * @param in Pointer to encoded data
+     * @param size Number of characters, should be divisible by 4
+     * @param out Output buffer of at least DecodedSize(in, size) Bytes
+     * @return True if the input is a valid base64 string
+     */
+    static bool Decode(const char *in, const size_t size, char *out);
+
+    /*!
+     * \brief Returns name of the kernel selected for this processor ("avx2", "ssse3" or "scalar")
+     */
+    static const char *GetKernelName();
+
+    /*!
+     * \brief Encodes data and writes it into the stream
+     * @param in Pointer to input data
+     * @param size Size of input data in Bytes
+     * @param stream Output stream
+     * @return Number of written characters
+     */
+    template<typename Stream>
+    inline size_t Write(const char *in, const size_t size, Stream &stream);
+
+private:
+    std::vector<char> buffer;       //!< Buffer for encoded chunks
+    size_t chunk_size;              //!< Size of input chunks
+};
+
+template<typename Stream>
+inline size_t Base64Encoder::Write(const char *in, const size_t size, Stream &stream) {
+
+    if (buffer.size() != EncodedSize(chunk_size))
+        buffer.resize(EncodedSize(chunk_size));
+
+    size_t written = 0;
+    for(size_t pos = 0; pos < size; pos += chunk_size) {
+        const size_t length = (size - pos < chunk_size) ? size - pos : chunk_size;
+        const size_t encoded = Encode(in + pos, length, &buffer[0]);
+        stream.write(&buffer[0], encoded);
+        written += encoded;
+    }
+    return written;
+}
+
+} /* namespace xmlw */
+
+#endif /* BASE64ENCODER_H_ */
@@ -0,0 +1,607 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+/*
+ * Throughput benchmark of the writer (build with "make benchmark").
+ *
+ * Synthetic structured (.vts) and unstructured (.vtu, hexahedra) meshes with one scalar and one vector field are
+ * written with every available output path: ascii, binary (base64) and raw appended data assembled by hand with
+ * VTK_XML_Writer, and AppendedFileWriter with all backends, Float64 conversion and compressors. Every write runs
+ * in a separate process, so the peak resident set size of the write is reported as well. Results are printed as a
+ * table and can be saved as JSON and/or CSV:
+ *
+ *   ./xmlwriter_benchmark --max-points 1e8 --dir /dev/shm --dir /scratch --json results.json --csv results.csv
+ */
+
+#include "UnstructuredGridWriter.h"
+#include "DataCompressor.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/vfs.h>
+#endif
+
+namespace {
+
+/*!
+ * \brief Options of the benchmark
+ */
+struct Options {
+    double min_points;                  //!< Smallest mesh (number of points)
+    double max_points;                  //!< Largest mesh (number of points)
+    double max_ascii_points;            //!< Largest mesh written in ascii format
+    size_t repeat;                      //!< Number of runs of every case
+    size_t num_threads;                 //!< Number of threads of the writer (0 - all hardware threads)
+    std::vector<std::string> dirs;      //!< Output directories
+    std::vector<std::string> meshes;    //!< Types of meshes
+    std::vector<std::string> cases;     //!< Cases to run (empty - all)
+    std::string json;                   //!< Name of the JSON file with results
+    std::string csv;                    //!< Name of the CSV file with results
+    bool keep;                          //!< True if written files are kept
+};
+
+/*!
+ * \brief Synthetic mesh: n x n x n points, (n-1)^3 hexahedra for the unstructured mesh
+ */
+struct Mesh {
+    bool structured;
+    size_t n;
+    size_t num_points;
+    size_t num_cells;
+    std::vector<float> points;
+    std::vector<double> pressure;
+    std::vector<float> velocity;
+    std::vector<int32_t> connectivity;
+    std::vector<int64_t> offsets;
+    std::vector<uint8_t> types;
+
+    size_t Bytes() const {
+        return sizeof(float) * (points.size() + velocity.size()) + sizeof(double) * pressure.size()
+                + sizeof(int32_t) * connectivity.size() + sizeof(int64_t) * offsets.size()
+                + sizeof(uint8_t) * types.size();
+    }
+};
+
+/*!
+ * \brief Result of a single run
+ */
+struct Result {
+    std::string mesh;
+    std::string name;
+    size_t num_points;
+    size_t num_cells;
+    size_t mesh_bytes;
+    std::string dir;
+    std::string fs;
+    size_t run;
+    bool ok;
+    size_t file_bytes;
+    double write_time;                  //!< Time of writing in seconds
+    double sync_time;                   //!< Time of fsync() in seconds
+    long peak_rss;                      //!< Peak resident set size of the writing process in KiB
+};
+
+/*!
+ * \brief Timing reported by the child process
+ */
+struct Timing {
+    int ok;
+    double write_time;
+    double sync_time;
+};
+
+const char *all_cases[] = { "ascii", "binary", "appended", "writer_stream", "writer_vectored", "writer_mapped",
+        "writer_float32", "writer_uint16", "writer_zlib", "writer_lz4" };
+
+double Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void BuildMesh(Mesh &mesh, const bool structured, const double num_points) {
+    const size_t n = std::max<size_t>(2, (size_t)std::llround(std::cbrt(num_points)));
+    const double h = 1. / (n - 1);
+
+    mesh.structured = structured;
+    mesh.n = n;
+    mesh.num_points = n * n * n;
+    mesh.num_cells = (n - 1) * (n - 1) * (n - 1);
+    mesh.points.resize(3 * mesh.num_points);
+    mesh.pressure.resize(mesh.num_points);
+    mesh.velocity.resize(3 * mesh.num_points);
+    mesh.connectivity.clear();
+    mesh.offsets.clear();
+    mesh.types.clear();
+
+    size_t p = 0;
+    for(size_t k = 0; k < n; ++k)
+        for(size_t j = 0; j < n; ++j)
+            for(size_t i = 0; i < n; ++i, ++p) {
+                const double x = i * h, y = j * h, z = k * h;
+                mesh.points[3 * p] = x;
+                mesh.points[3 * p + 1] = y;
+                mesh.points[3 * p + 2] = z;
+                mesh.pressure[p] = std::sin(6. * x) * std::cos(4. * y) + z;
+                mesh.velocity[3 * p] = -y;
+                mesh.velocity[3 * p + 1] = x;
+                mesh.velocity[3 * p + 2] = 0.1 * z;
+            }
+
+    if (structured)
+        return;
+
+    mesh.connectivity.resize(8 * mesh.num_cells);
+    mesh.offsets.resize(mesh.num_cells);
+    mesh.types.assign(mesh.num_cells, xmlw::VTK_HEXAHEDRON);
+    size_t c = 0;
+    for(size_t k = 0; k + 1 < n; ++k)
+        for(size_t j = 0; j + 1 < n; ++j)
+            for(size_t i = 0; i + 1 < n; ++i, ++c) {
+                const int32_t v = i + n * (j + n * k);
+                const int32_t nodes[8] = { v, v + 1, int32_t(v + 1 + n), int32_t(v + n),
+                        int32_t(v + n * n), int32_t(v + 1 + n * n), int32_t(v + 1 + n + n * n),
+                        int32_t(v + n + n * n) };
+                std::copy(nodes, nodes + 8, &mesh.connectivity[8 * c]);
+                mesh.offsets[c] = 8 * (c + 1);
+            }
+}
+
+template<typename T>
+void WriteArray(xmlw::VTK_XML_Writer &wxml, const std::string &type, const std::string &name,
+        const size_t num_of_comp, const std::vector<T> &data, const std::string &format, size_t &offset,
+        std::ostream &os) {
+    if (format == "appended") {
+        wxml.OpenDataArrSection(type, name, num_of_comp, format, offset, os);
+        offset += wxml.CountOffset(data) + wxml.GetHeaderTypeSize();
+    }
+    else {
+        wxml.OpenDataArrSection(type, name, num_of_comp, format, os);
+        if (format == "ascii")
+            wxml.WriteData(data, os);
+        else
+            wxml.WriteBinaryData(data, os);
+    }
+    wxml.CloseDataArrSection(os);
+}
+
+/*!
+ * \brief Writes the mesh with VTK_XML_Writer, assembling the file section by section
+ */
+bool WriteSections(const Mesh &mesh, const std::string &format, const std::string &file_name,
+        const size_t num_threads) {
+    xmlw::VTK_XML_Writer wxml;
+    std::ofstream os(file_name.c_str(), std::ios::out | std::ios::binary);
+    const std::string grid_type = mesh.structured ? "StructuredGrid" : "UnstructuredGrid";
+    const std::string extent = "\"1 " + std::to_string(mesh.n) + " 1 " + std::to_string(mesh.n) + " 1 "
+            + std::to_string(mesh.n) + "\"";
+    size_t offset = 0;
+
+    if (!os.is_open())
+        return false;
+    if (mesh.Bytes() > std::numeric_limits<uint32_t>::max())
+        wxml.SetHeaderType("UInt64");
+    wxml.SetNumberOfThreads(num_threads);
+
+    wxml.Header(os);
+    wxml.OpenVTKSection(grid_type, os);
+    if (mesh.structured) {
+        wxml.OpenSection("StructuredGrid WholeExtent=" + extent, os);
+        wxml.OpenSection("Piece Extent=" + extent, os);
+    }
+    else {
+        wxml.OpenSection(grid_type, os);
+        wxml.OpenPieceSection(mesh.num_points, mesh.num_cells, os);
+    }
+
+    wxml.OpenPointDataSection("pressure", os);
+    WriteArray(wxml, "Float64", "pressure", 1, mesh.pressure, format, offset, os);
+    WriteArray(wxml, "Float32", "velocity", 3, mesh.velocity, format, offset, os);
+    wxml.ClosePointDataSection(os);
+
+    wxml.OpenSection("Points", os);
+    WriteArray(wxml, "Float32", "Points", 3, mesh.points, format, offset, os);
+    wxml.CloseSection("Points", os);
+
+    if (!mesh.structured) {
+        wxml.OpenSection("Cells", os);
+        WriteArray(wxml, "Int32", "connectivity", 1, mesh.connectivity, format, offset, os);
+        WriteArray(wxml, "Int64", "offsets", 1, mesh.offsets, format, offset, os);
+        WriteArray(wxml, "UInt8", "types", 1, mesh.types, format, offset, os);
+        wxml.CloseSection("Cells", os);
+        wxml.ClosePieceSection(os);
+    }
+    else
+        wxml.CloseSection("Piece", os);
+    wxml.CloseSection(grid_type, os);
+
+    if (format == "appended") {
+        wxml.OpenSection("AppendedData encoding=\"raw\"", os);
+        os << "_";
+        wxml.AppendData(mesh.pressure, os);
+        wxml.AppendData(mesh.velocity, os);
+        wxml.AppendData(mesh.points, os);
+        if (!mesh.structured) {
+            wxml.AppendData(mesh.connectivity, os);
+            wxml.AppendData(mesh.offsets, os);
+            wxml.AppendData(mesh.types, os);
+        }
+        os << "\n";
+        wxml.CloseSection("AppendedData", os);
+    }
+    wxml.CloseVTKSection(os);
+    os.close();
+
+    return !os.fail();
+}
+
+/*!
+ * \brief Writes the mesh with AppendedFileWriter configured according to the name of the case
+ */
+bool WriteAppended(Mesh &mesh, const std::string &name, const std::string &file_name, const size_t num_threads) {
+    xmlw::AppendedFileWriter writer(mesh.structured ? "StructuredGrid" : "UnstructuredGrid");
+
+    writer.SetNumberOfThreads(num_threads);
+    if (name == "writer_vectored")
+        writer.SetBackend(xmlw::AppendedFileWriter::BACKEND_VECTORED);
+    else if (name == "writer_mapped")
+        writer.SetBackend(xmlw::AppendedFileWriter::BACKEND_MAPPED);
+    else if (name == "writer_float32")
+        writer.SetFloat64Conversion(xmlw::AppendedFileWriter::CONVERSION_FLOAT32);
+    else if (name == "writer_uint16")
+        writer.SetFloat64Conversion(xmlw::AppendedFileWriter::CONVERSION_UINT16);
+    else if (name == "writer_zlib")
+        writer.SetCompressor("vtkZLibDataCompressor");
+    else if (name == "writer_lz4")
+        writer.SetCompressor("vtkLZ4DataCompressor");
+
+    if (mesh.structured)
+        writer.SetExtent(1, mesh.n, 1, mesh.n, 1, mesh.n);
+    else
+        writer.SetPiece(mesh.num_points, mesh.num_cells);
+    writer.AddArray("PointData", "pressure", mesh.pressure);
+    writer.AddArray("PointData", "velocity", mesh.velocity, 3);
+    writer.AddArray("Points", "Points", mesh.points, 3);
+    if (!mesh.structured) {
+        writer.AddArray("Cells", "connectivity", mesh.connectivity);
+        writer.AddArray("Cells", "offsets", mesh.offsets);
+        writer.AddArray("Cells", "types", mesh.types);
+    }
+
+    return writer.Write(file_name);
+}
+
+bool IsAvailable(const std::string &name) {
+    if (name == "writer_zlib")
+        return xmlw::DataCompressor::IsSupported("vtkZLibDataCompressor");
+    if (name == "writer_lz4")
+        return xmlw::DataCompressor::IsSupported("vtkLZ4DataCompressor");
+    return true;
+}
+
+/*!
+ * \brief Returns the type of the file system the directory is located on
+ */
+std::string FileSystemType(const std::string &dir) {
+#ifdef __linux__
+    struct statfs st;
+    if (statfs(dir.c_str(), &st) == 0) {
+        if (st.f_type == 0x01021994)
+            return "tmpfs";
+        if (st.f_type == 0x858458f6)
+            return "ramfs";
+    }
+#endif
+    return "disk";
+}
+
+/*!
+ * \brief Runs a single case in a child process and measures its time and peak memory consumption
+ */
+void RunCase(Mesh &mesh, const std::string &name, const std::string &dir, const Options &options, Result &result) {
+    const std::string extension = mesh.structured ? ".vts" : ".vtu";
+    const std::string file_name = dir + "/xmlwriter_benchmark_" + name + extension;
+    int fds[2];
+
+    result.ok = false;
+    result.file_bytes = 0;
+    result.write_time = result.sync_time = 0.;
+    result.peak_rss = 0;
+
+    if (pipe(fds) != 0) {
+        std::cerr << "Error! Can't create a pipe. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return;
+    }
+
+    std::cout.flush();
+    const pid_t pid = fork();
+    if (pid < 0) {
+        std::cerr << "Error! Can't start a process. See " << __FILE__ << ":" << __LINE__ << "\n";
+        close(fds[0]);
+        close(fds[1]);
+        return;
+    }
+
+    if (pid == 0) {
+        Timing timing;
+        close(fds[0]);
+        const double start = Now();
+        if (name == "ascii" || name == "binary" || name == "appended")
+            timing.ok = WriteSections(mesh, name, file_name, options.num_threads);
+        else
+            timing.ok = WriteAppended(mesh, name, file_name, options.num_threads);
+        const double written = Now();
+        const int fd = open(file_name.c_str(), O_RDONLY);
+        if (fd < 0 || fsync(fd) != 0)
+            timing.ok = false;
+        if (fd >= 0)
+            close(fd);
+        timing.write_time = written - start;
+        timing.sync_time = Now() - written;
+        const bool sent = write(fds[1], &timing, sizeof(Timing)) == (ssize_t)sizeof(Timing);
+        close(fds[1]);
+        _exit(sent ? 0 : 1);
+    }
+
+    Timing timing;
+    struct rusage usage;
+    int status = 0;
+    close(fds[1]);
+    const bool received = read(fds[0], &timing, sizeof(Timing)) == (ssize_t)sizeof(Timing);
+    close(fds[0]);
+    if (wait4(pid, &status, 0, &usage) < 0 || !received || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        std::cerr << "Error! Case " << name << " failed in " << dir << ". See " << __FILE__ << ":" << __LINE__
+                << "\n";
+        return;
+    }
+
+    struct stat st;
+    if (stat(file_name.c_str(), &st) == 0)
+        result.file_bytes = st.st_size;
+    if (!options.keep)
+        std::remove(file_name.c_str());
+
+    result.ok = timing.ok;
+    result.write_time = timing.write_time;
+    result.sync_time = timing.sync_time;
+    result.peak_rss = usage.ru_maxrss;
+}
+
+double Bandwidth(const Result &result, const bool with_sync) {
+    const double time = result.write_time + (with_sync ? result.sync_time : 0.);
+    return time > 0. ? result.file_bytes / time * 1.e-9 : 0.;
+}
+
+std::string Escape(const std::string &str) {
+    std::string out;
+    for(size_t n = 0; n < str.size(); ++n) {
+        if (str[n] == '"' || str[n] == '\\')
+            out += '\\';
+        out += str[n];
+    }
+    return out;
+}
+
+void SaveJSON(const std::string &file_name, const Options &options, const std::vector<Result> &results) {
+    std::ofstream os(file_name.c_str());
+    char host[256] = "";
+    gethostname(host, sizeof(host) - 1);
+
+    os << std::setprecision(9);
+    os << "{\n";
+    os << "  \"benchmark\": \"xmlwriter\",\n";
+    os << "  \"host\": \"" << Escape(host) << "\",\n";
+    os << "  \"compiler\": \"" << Escape(__VERSION__) << "\",\n";
+    os << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n";
+    os << "  \"writer_threads\": " << options.num_threads << ",\n";
+    os << "  \"repeat\": " << options.repeat << ",\n";
+    os << "  \"results\": [\n";
+    for(size_t n = 0; n < results.size(); ++n) {
+        const Result &r = results[n];
+        os << "    {\"mesh\": \"" << r.mesh << "\", \"case\": \"" << r.name << "\", \"points\": " << r.num_points
+                << ", \"cells\": " << r.num_cells << ", \"mesh_bytes\": " << r.mesh_bytes << ", \"dir\": \""
+                << Escape(r.dir) << "\", \"fs\": \"" << r.fs << "\", \"run\": " << r.run << ", \"ok\": "
+                << (r.ok ? "true" : "false") << ", \"file_bytes\": " << r.file_bytes << ", \"write_s\": "
+                << r.write_time << ", \"sync_s\": " << r.sync_time << ", \"write_gbps\": " << Bandwidth(r, false)
+                << ", \"synced_gbps\": " << Bandwidth(r, true) << ", \"peak_rss_kib\": " << r.peak_rss << "}"
+                << (n + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n";
+    os << "}\n";
+}
+
+void SaveCSV(const std::string &file_name, const std::vector<Result> &results) {
+    std::ofstream os(file_name.c_str());
+
+    os << std::setprecision(9);
+    os << "mesh,case,points,cells,mesh_bytes,dir,fs,run,ok,file_bytes,write_s,sync_s,write_gbps,synced_gbps,"
+            "peak_rss_kib\n";
+    for(size_t n = 0; n < results.size(); ++n) {
+        const Result &r = results[n];
+        os << r.mesh << "," << r.name << "," << r.num_points << "," << r.num_cells << "," << r.mesh_bytes << ","
+                << "\"" << r.dir << "\"," << r.fs << "," << r.run << "," << r.ok << "," << r.file_bytes << ","
+                << r.write_time << "," << r.sync_time << "," << Bandwidth(r, false) << "," << Bandwidth(r, true)
+                << "," << r.peak_rss << "\n";
+    }
+}
+
+void PrintUsage(const char *name) {
+    std::cout << "Usage: " << name << " [options]\n"
+            << "  --min-points N        smallest mesh, number of points (default 1e3)\n"
+            << "  --max-points N        largest mesh, number of points (default 1e7, up to 1e9)\n"
+            << "  --max-ascii-points N  largest mesh written in ascii format (default 1e7)\n"
+            << "  --mesh TYPE           structured or unstructured, may be repeated (default both)\n"
+            << "  --case NAME           case to run, may be repeated (default all):\n"
+            << "                       ";
+    for(size_t n = 0; n < sizeof(all_cases) / sizeof(all_cases[0]); ++n)
+        std::cout << " " << all_cases[n];
+    std::cout << "\n"
+            << "  --dir DIR             output directory, may be repeated (default /dev/shm and .)\n"
+            << "  --repeat N            number of runs of every case (default 3)\n"
+            << "  --threads N           number of threads of the writer (default all hardware threads)\n"
+            << "  --json FILE           save results in JSON format\n"
+            << "  --csv FILE            save results in CSV format\n"
+            << "  --keep                keep written files\n";
+}
+
+bool ParseOptions(int argc, char **argv, Options &options) {
+    options.min_points = 1.e3;
+    options.max_points = 1.e7;
+    options.max_ascii_points = 1.e7;
+    options.repeat = 3;
+    options.num_threads = 0;
+    options.keep = false;
+
+    for(int n = 1; n < argc; ++n) {
+        const std::string arg = argv[n];
+        const bool has_value = n + 1 < argc;
+        if (arg == "--keep")
+            options.keep = true;
+        else if (arg == "--help" || arg == "-h")
+            return false;
+        else if (!has_value) {
+            std::cerr << "Error! Missing value of " << arg << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+        else if (arg == "--min-points")
+            options.min_points = std::atof(argv[++n]);
+        else if (arg == "--max-points")
+            options.max_points = std::atof(argv[++n]);
+        else if (arg == "--max-ascii-points")
+            options.max_ascii_points = std::atof(argv[++n]);
+        else if (arg == "--mesh")
+            options.meshes.push_back(argv[++n]);
+        else if (arg == "--case")
+            options.cases.push_back(argv[++n]);
+        else if (arg == "--dir")
+            options.dirs.push_back(argv[++n]);
+        else if (arg == "--repeat")
+            options.repeat = std::max(1, std::atoi(argv[++n]));
+        else if (arg == "--threads")
+            options.num_threads = std::max(0, std::atoi(argv[++n]));
+        else if (arg == "--json")
+            options.json = argv[++n];
+        else if (arg == "--csv")
+            options.csv = argv[++n];
+        else {
+            std::cerr << "Error! Unknown option " << arg << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+    }
+
+    if (options.dirs.empty()) {
+        struct stat st;
+        if (stat("/dev/shm", &st) == 0 && S_ISDIR(st.st_mode))
+            options.dirs.push_back("/dev/shm");
+        options.dirs.push_back(".");
+    }
+    if (options.meshes.empty()) {
+        options.meshes.push_back("structured");
+        options.meshes.push_back("unstructured");
+    }
+    if (options.cases.empty())
+        options.cases.assign(all_cases, all_cases + sizeof(all_cases) / sizeof(all_cases[0]));
+
+    return true;
+}
+
+}
+
+int main(int argc, char **argv) {
+
+    Options options;
+    std::vector<Result> results;
+    Mesh mesh;
+
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(13) << "mesh" << std::setw(17) << "case" << std::right << std::setw(12)
+            << "points" << std::setw(8) << "fs" << std::setw(12) << "MiB" << std::setw(10) << "write s"
+            << std::setw(10) << "GB/s" << std::setw(10) << "+sync s" << std::setw(10) << "GB/s" << std::setw(12)
+            << "RSS MiB" << "\n";
+
+    for(size_t m = 0; m < options.meshes.size(); ++m) {
+        const bool structured = options.meshes[m] == "structured";
+        for(double size = options.min_points; size <= options.max_points * (1. + 1.e-9); size *= 10.) {
+            BuildMesh(mesh, structured, size);
+            for(size_t c = 0; c < options.cases.size(); ++c) {
+                const std::string &name = options.cases[c];
+                if (!IsAvailable(name) || (name == "ascii" && size > options.max_ascii_points * (1. + 1.e-9)))
+                    continue;
+                for(size_t d = 0; d < options.dirs.size(); ++d) {
+                    for(size_t run = 0; run < options.repeat; ++run) {
+                        Result result;
+                        result.mesh = options.meshes[m];
+                        result.name = name;
+                        result.num_points = mesh.num_points;
+                        result.num_cells = mesh.num_cells;
+                        result.mesh_bytes = mesh.Bytes();
+                        result.dir = options.dirs[d];
+                        result.fs = FileSystemType(options.dirs[d]);
+                        result.run = run;
+                        RunCase(mesh, name, options.dirs[d], options, result);
+                        results.push_back(result);
+
+                        std::cout << std::left << std::setw(13) << result.mesh << std::setw(17) << name
+                                << std::right << std::setw(12) << result.num_points << std::setw(8) << result.fs
+                                << std::fixed << std::setprecision(2) << std::setw(12)
+                                << result.file_bytes / 1048576. << std::setprecision(4) << std::setw(10)
+                                << result.write_time << std::setw(10) << Bandwidth(result, false)
+                                << std::setw(10) << result.sync_time << std::setw(10) << Bandwidth(result, true)
+                                << std::setprecision(1) << std::setw(12) << result.peak_rss / 1024.
+                                << (result.ok ? "" : "  FAILED") << "\n";
+                        std::cout.unsetf(std::ios::floatfield);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!options.json.empty())
+        SaveJSON(options.json, options, results);
+    if (!options.csv.empty())
+        SaveCSV(options.csv, results);
+
+    return 0;
+}
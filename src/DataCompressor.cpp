@@ -0,0 +1,246 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "DataCompressor.h"
+#include "ThreadPool.h"
+
+#include <iostream>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+#ifdef XMLW_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef XMLW_WITH_LZ4
+#include <lz4.h>
+#endif
+
+namespace xmlw {
+
+DataCompressor::DataCompressor(const std::string _name, const int _level) :
+        name(_name), level(_level), block_size(32768) {
+
+    if (!IsSupported(name))
+        std::cerr << "Error! Compressor " << name << " is not supported by this build. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+}
+
+bool DataCompressor::IsSupported(const std::string name) {
+#ifdef XMLW_WITH_ZLIB
+    if (name == "vtkZLibDataCompressor")
+        return true;
+#endif
+#ifdef XMLW_WITH_LZ4
+    if (name == "vtkLZ4DataCompressor")
+        return true;
+#endif
+    (void)name;
+    return false;
+}
+
+const std::string &DataCompressor::GetName() const {
+    return name;
+}
+
+void DataCompressor::SetBlockSize(const size_t _block_size) {
+    if (_block_size == 0) {
+        std::cerr << "Error! Size of blocks should be positive. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return;
+    }
+    block_size = _block_size;
+}
+
+size_t DataCompressor::GetBlockSize() const {
+    return block_size;
+}
+
+size_t DataCompressor::Compress(const char *data, const size_t num_bytes, const size_t header_type_size,
+        std::vector<char> &output, ThreadPool *pool) const {
+    return CompressBlocks(data, NULL, num_bytes, header_type_size, output, pool);
+}
+
+size_t DataCompressor::Compress(const FillFunction &fill, const size_t num_bytes, const size_t header_type_size,
+        std::vector<char> &output, ThreadPool *pool) const {
+    return CompressBlocks(NULL, &fill, num_bytes, header_type_size, output, pool);
+}
+
+size_t DataCompressor::CompressBlocks(const char *data, const FillFunction *fill, const size_t num_bytes,
+        const size_t header_type_size, std::vector<char> &output, ThreadPool *pool) const {
+
+    const size_t num_blocks = GetNumberOfBlocks(num_bytes);
+    const size_t header_size = (3 + num_blocks) * header_type_size;
+    const size_t bound = GetMaxBlockSize();
+
+    /*
+     * Each block is compressed into its own slot of the scratch buffer, afterwards
+     * blocks are packed one after another right behind the header
+     */
+    std::unique_ptr<char[]> scratch(new char[num_blocks * bound]);
+    std::vector<size_t> sizes(num_blocks);
+
+    std::function<void(size_t)> compress = [&](size_t n) {
+        sizes[n] = CompressSingleBlock(data, fill, num_bytes, n, &scratch[n * bound]);
+    };
+
+    if (pool != NULL)
+        pool->Run(num_blocks, compress);
+    else
+        for(size_t n = 0; n < num_blocks; ++n)
+            compress(n);
+
+    /* Compressed blocks are never empty, a zero size marks a failure */
+    if (std::find(sizes.begin(), sizes.end(), 0) != sizes.end()) {
+        std::cerr << "Error! Failed to compress data set of " << num_bytes << " Bytes. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        output.clear();
+        return 0;
+    }
+
+    size_t total = header_size;
+    for(size_t n = 0; n < num_blocks; ++n)
+        total += sizes[n];
+
+    output.resize(total);
+    WriteHeader(num_bytes, header_type_size, sizes, &output[0]);
+
+    size_t pos = header_size;
+    for(size_t n = 0; n < num_blocks; ++n) {
+        if (sizes[n] != 0)
+            std::memcpy(&output[pos], &scratch[n * bound], sizes[n]);
+        pos += sizes[n];
+    }
+
+    return total;
+}
+
+size_t DataCompressor::GetNumberOfBlocks(const size_t num_bytes) const {
+    return (num_bytes + block_size - 1) / block_size;
+}
+
+size_t DataCompressor::GetMaxBlockSize() const {
+    return CompressBound(block_size);
+}
+
+size_t DataCompressor::GetMaxCompressedSize(const size_t num_bytes, const size_t header_type_size) const {
+    const size_t num_blocks = GetNumberOfBlocks(num_bytes);
+    return (3 + num_blocks) * header_type_size + num_blocks * GetMaxBlockSize();
+}
+
+size_t DataCompressor::CompressSingleBlock(const char *data, const FillFunction *fill, const size_t num_bytes,
+        const size_t block, char *out) const {
+
+    const size_t last_block_size = num_bytes % block_size;
+    const size_t size = (block == GetNumberOfBlocks(num_bytes) - 1 && last_block_size != 0) ?
+            last_block_size : block_size;
+
+    if (fill != NULL) {
+        std::unique_ptr<char[]> chunk(new char[size]);
+        (*fill)(block * block_size, size, chunk.get());
+        return CompressBlock(chunk.get(), size, out, GetMaxBlockSize());
+    }
+    return CompressBlock(data + block * block_size, size, out, GetMaxBlockSize());
+}
+
+void DataCompressor::WriteHeader(const size_t num_bytes, const size_t header_type_size,
+        const std::vector<size_t> &sizes, char *out) const {
+    WriteHeaderInt(sizes.size(), header_type_size, out);
+    WriteHeaderInt(block_size, header_type_size, out + header_type_size);
+    WriteHeaderInt(num_bytes % block_size, header_type_size, out + 2 * header_type_size);
+    for(size_t n = 0; n < sizes.size(); ++n)
+        WriteHeaderInt(sizes[n], header_type_size, out + (3 + n) * header_type_size);
+}
+
+bool DataCompressor::DecompressBlock(const char *in, const size_t in_size, char *out,
+        const size_t out_size) const {
+#ifdef XMLW_WITH_ZLIB
+    if (name == "vtkZLibDataCompressor") {
+        uLongf size = out_size;
+        return uncompress((Bytef*)out, &size, (const Bytef*)in, in_size) == Z_OK && size == out_size;
+    }
+#endif
+#ifdef XMLW_WITH_LZ4
+    if (name == "vtkLZ4DataCompressor")
+        return LZ4_decompress_safe(in, out, in_size, out_size) == (int)out_size;
+#endif
+    (void)in; (void)in_size; (void)out; (void)out_size;
+    return false;
+}
+
+size_t DataCompressor::CompressBound(const size_t size) const {
+#ifdef XMLW_WITH_ZLIB
+    if (name == "vtkZLibDataCompressor")
+        return compressBound(size);
+#endif
+#ifdef XMLW_WITH_LZ4
+    if (name == "vtkLZ4DataCompressor")
+        return LZ4_compressBound(size);
+#endif
+    return size;
+}
+
+size_t DataCompressor::CompressBlock(const char *in, const size_t in_size, char *out,
+        const size_t out_size) const {
+#ifdef XMLW_WITH_ZLIB
+    if (name == "vtkZLibDataCompressor") {
+        uLongf size = out_size;
+        const int zlevel = level < 0 ? Z_DEFAULT_COMPRESSION : level;
+        if (compress2((Bytef*)out, &size, (const Bytef*)in, in_size, zlevel) != Z_OK) {
+            std::cerr << "Error! ZLib failed to compress block. See " << __FILE__ << ":" << __LINE__ << "\n";
+            return 0;
+        }
+        return size;
+    }
+#endif
+#ifdef XMLW_WITH_LZ4
+    if (name == "vtkLZ4DataCompressor") {
+        /* Higher level means better compression, i.e. lower acceleration of LZ4 */
+        const int acceleration = level < 0 ? 1 : (level > 9 ? 1 : 10 - level);
+        const int size = LZ4_compress_fast(in, out, in_size, out_size, acceleration);
+        if (size <= 0) {
+            std::cerr << "Error! LZ4 failed to compress block. See " << __FILE__ << ":" << __LINE__ << "\n";
+            return 0;
+        }
+        return size;
+    }
+#endif
+    (void)in; (void)in_size; (void)out; (void)out_size;
+    return 0;
+}
+
+void DataCompressor::WriteHeaderInt(const size_t value, const size_t header_type_size, char *buffer) {
+    if (header_type_size == sizeof(uint64_t)) {
+        uint64_t header = value;
+        std::memcpy(buffer, &header, sizeof(uint64_t));
+    }
+    else {
+        uint32_t header = value;
+        std::memcpy(buffer, &header, sizeof(uint32_t));
+    }
+}
+
+}
@@ -0,0 +1,191 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef DATACOMPRESSOR_H_
+#define DATACOMPRESSOR_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "ArrayViews.h"
+
+namespace xmlw {
+
+class ThreadPool;
+
+/*!
+ * \class DataCompressor
+ * \brief Block compressor for VTK XML files
+ * VTK splits each compressed data set into blocks of equal size (except of the last one) and compresses every
+ * block independently. The compressed data set starts with a header of integers of the header type:
+ *   [number of blocks][size of block][size of the last block][compressed size of block 1]...[compressed size of block N]
+ * which is followed by compressed blocks written one after another. The size of the last block is 0 when it is
+ * a full one. The name of the compressor is written into the 'VTKFile' section, e.g.:
+ *   <VTKFile type="UnstructuredGrid" ... compressor="vtkZLibDataCompressor">
+ * Since blocks are independent they are compressed concurrently.
+ * Supported compressors are "vtkZLibDataCompressor" (requires XMLW_WITH_ZLIB and -lz) and "vtkLZ4DataCompressor"
+ * (requires XMLW_WITH_LZ4 and -llz4).
+ */
+class DataCompressor {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _name VTK name of the compressor
+     * @param _level Compression level (-1 - default level of the library)
+     */
+    DataCompressor(const std::string _name, const int _level = -1);
+
+    /*!
+     * \brief Returns true if the compressor with the given name is available in this build
+     * @param name VTK name of the compressor
+     */
+    static bool IsSupported(const std::string name);
+
+    /*!
+     * \brief Returns VTK name of the compressor
+     */
+    const std::string &GetName() const;
+
+    /*!
+     * \brief Sets size of uncompressed blocks in Bytes (32768 by default, as in VTK)
+     * @param _block_size Size of blocks
+     */
+    void SetBlockSize(const size_t _block_size);
+
+    /*!
+     * \brief Returns size of uncompressed blocks in Bytes
+     */
+    size_t GetBlockSize() const;
+
+    /*!
+     * \brief Compresses data set
+     * @param data Pointer to the data
+     * @param num_bytes Size of the data in Bytes
+     * @param header_type_size Size of integers in the header (4 or 8 Bytes)
+     * @param output Header of compressed data followed by compressed blocks
+     * @param pool Threads used to compress blocks (may be NULL)
+     * @return Size of the output in Bytes, 0 if any block failed to compress (the output is then empty)
+     */
+    size_t Compress(const char *data, const size_t num_bytes, const size_t header_type_size,
+            std::vector<char> &output, ThreadPool *pool) const;
+
+    /*!
+     * \brief Compresses data set generated on the fly, each block is generated right before its compression
+     * @param fill Function generating ranges of the data set
+     * @param num_bytes Size of the data in Bytes
+     * @param header_type_size Size of integers in the header (4 or 8 Bytes)
+     * @param output Header of compressed data followed by compressed blocks
+     * @param pool Threads used to compress blocks (may be NULL)
+     * @return Size of the output in Bytes, 0 if any block failed to compress (the output is then empty)
+     */
+    size_t Compress(const FillFunction &fill, const size_t num_bytes, const size_t header_type_size,
+            std::vector<char> &output, ThreadPool *pool) const;
+
+    /*!
+     * \brief Returns number of blocks the data set is split into
+     * @param num_bytes Size of the data in Bytes
+     */
+    size_t GetNumberOfBlocks(const size_t num_bytes) const;
+
+    /*!
+     * \brief Returns the maximum size of a compressed block in Bytes
+     */
+    size_t GetMaxBlockSize() const;
+
+    /*!
+     * \brief Returns the maximum size of the compressed data set including the header
+     * @param num_bytes Size of the data in Bytes
+     * @param header_type_size Size of integers in the header (4 or 8 Bytes)
+     */
+    size_t GetMaxCompressedSize(const size_t num_bytes, const size_t header_type_size) const;
+
+    /*!
+     * \brief Compresses one block of the data set, blocks may be compressed concurrently
+     * @param data Pointer to the data (NULL if the data set is generated on the fly)
+     * @param fill Function generating ranges of the data set (NULL if the data is stored in memory)
+     * @param num_bytes Size of the data in Bytes
+     * @param block Index of the block
+     * @param out Output buffer of GetMaxBlockSize() Bytes
+     * @return Size of the compressed block, 0 in case of failure
+     */
+    size_t CompressSingleBlock(const char *data, const FillFunction *fill, const size_t num_bytes,
+            const size_t block, char *out) const;
+
+    /*!
+     * \brief Writes the header of compressed data (number and sizes of blocks)
+     * @param num_bytes Size of the data in Bytes
+     * @param header_type_size Size of integers in the header (4 or 8 Bytes)
+     * @param sizes Sizes of compressed blocks
+     * @param out Output buffer of (3 + number of blocks) * header_type_size Bytes
+     */
+    void WriteHeader(const size_t num_bytes, const size_t header_type_size, const std::vector<size_t> &sizes,
+            char *out) const;
+
+    /*!
+     * \brief Decompresses a single block
+     * @param in Pointer to the compressed block
+     * @param in_size Size of the compressed block in Bytes
+     * @param out Pointer to the output buffer
+     * @param out_size Size of the uncompressed block in Bytes
+     * @return True if the block was successfully decompressed
+     */
+    bool DecompressBlock(const char *in, const size_t in_size, char *out, const size_t out_size) const;
+
+private:
+    /*!
+     * \brief Compresses data set stored in memory (fill is NULL) or generated on the fly
+     */
+    size_t CompressBlocks(const char *data, const FillFunction *fill, const size_t num_bytes,
+            const size_t header_type_size, std::vector<char> &output, ThreadPool *pool) const;
+
+    /*!
+     * \brief Returns the maximum size of compressed block
+     * @param size Size of uncompressed block
+     */
+    size_t CompressBound(const size_t size) const;
+
+    /*!
+     * \brief Compresses a single block
+     * @return Size of the compressed block, 0 in case of failure
+     */
+    size_t CompressBlock(const char *in, const size_t in_size, char *out, const size_t out_size) const;
+
+    /*!
+     * \brief Writes integer of the header type into the buffer
+     */
+    static void WriteHeaderInt(const size_t value, const size_t header_type_size, char *buffer);
+
+private:
+    std::string name;           //!< VTK name of the compressor
+    int level;                  //!< Compression level
+    size_t block_size;          //!< Size of uncompressed blocks
+};
+
+} /* namespace xmlw */
+
+#endif /* DATACOMPRESSOR_H_ */
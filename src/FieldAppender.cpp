@@ -0,0 +1,264 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "FieldAppender.h"
+
+#include <iostream>
+#include <sstream>
+
+namespace xmlw {
+
+FieldAppender::FieldAppender() :
+        AppendedFileWriter("") {
+}
+
+FieldAppender *FieldAppender::Clone() const {
+    return new FieldAppender(*this);
+}
+
+bool FieldAppender::Write(const std::string file_name) {
+    return Append(file_name);
+}
+
+bool FieldAppender::ReadHeader(std::fstream &stream, std::string &header) {
+
+    const size_t chunk_size = size_t(1) << 16;
+    std::vector<char> chunk(chunk_size);
+
+    header.clear();
+    while (stream) {
+        stream.read(chunk.data(), chunk_size);
+        header.append(chunk.data(), stream.gcount());
+
+        const size_t appended = header.find("<AppendedData encoding=\"raw\">");
+        if (appended == std::string::npos)
+            continue;
+        const size_t underscore = header.find('_', appended);
+        if (underscore != std::string::npos) {
+            header.resize(underscore + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string FieldAppender::GetAttribute(const std::string &header, const std::string &element,
+        const std::string &attribute) {
+
+    const size_t begin = header.find("<" + element + " ");
+    if (begin == std::string::npos)
+        return "";
+    const size_t end = header.find('>', begin);
+    const size_t pos = header.find(" " + attribute + "=\"", begin);
+    if (pos == std::string::npos || pos > end)
+        return "";
+    const size_t first = pos + attribute.size() + 3;
+    return header.substr(first, header.find('"', first) - first);
+}
+
+void FieldAppender::InsertSection(const std::string section, const size_t base_offset, std::string &header) {
+
+    std::string first_name;
+    for(size_t n = 0; n < order.size() && first_name.empty(); ++n)
+        if (arrays[order[n]].section == section)
+            first_name = arrays[order[n]].name;
+    if (first_name.empty())
+        return;
+
+    /*
+     * New data sets go to the end of the existing section, otherwise the section is created in front of the
+     * sections which follow it in the piece
+     */
+    size_t pos = header.find("</" + section + ">");
+    const bool exists = pos != std::string::npos;
+    if (!exists) {
+        const char *next_sections[] = { "<CellData", "<Points>", "<Coordinates>", "<Cells>", "</Piece>" };
+        for(size_t s = (section == "PointData") ? 0 : 1; s < sizeof(next_sections) / sizeof(next_sections[0]); ++s)
+            if ((pos = header.find(next_sections[s])) != std::string::npos)
+                break;
+    }
+
+    /* New lines are indented as the line they are inserted in front of */
+    const size_t line = header.rfind('\n', pos) + 1;
+    SetIndentationLevel((pos - line) / 2 + (exists ? 1 : 0));
+
+    std::ostringstream str;
+    if (!exists)
+        OpenSection(section + " Scalars=\"" + first_name + "\"", str);
+    for(size_t n = 0; n < order.size(); ++n) {
+        const ArrayInfo &arr = arrays[order[n]];
+        if (arr.section != section)
+            continue;
+        OpenDataArrSection(arr.type, arr.name, arr.num_of_comp, "appended", base_offset + arr.offset,
+                arr.attributes, str);
+        CloseDataArrSection(str);
+    }
+    if (!exists)
+        CloseSection(section, str);
+
+    header.insert(line, str.str());
+}
+
+bool FieldAppender::Append(const std::string file_name) {
+
+    XMLW_STATS(stats.Reset(); stats.file_name = file_name; const double start = StatsTimer::Now();)
+    std::fstream fs(file_name.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+    XMLW_STATS(++stats.num_syscalls;)
+    if (!fs.is_open()) {
+        std::cerr << "Error! Can't open file " << file_name << " for update. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    std::string header;
+    if (!ReadHeader(fs, header)) {
+        std::cerr << "Error! File " << file_name << " has no raw appended data. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    if (header.find("<Piece") != header.rfind("<Piece")) {
+        std::cerr << "Error! File " << file_name << " has several pieces, data sets can't be appended. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    for(size_t n = 0; n < arrays.size(); ++n) {
+        const ArrayInfo &arr = arrays[n];
+        const size_t begin = header.find("<" + arr.section);
+        const size_t end = header.find("</" + arr.section + ">");
+        if (arr.section != "PointData" && arr.section != "CellData") {
+            std::cerr << "Error! Only point and cell data can be appended, data set " << arr.name << " is in section "
+                    << arr.section << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+        if (begin != std::string::npos && header.find("Name=\"" + arr.name + "\"", begin) < end) {
+            std::cerr << "Error! Data set " << arr.name << " already exists in file " << file_name << ". See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+    }
+
+    /* New data sets are encoded exactly as the existing ones */
+    const std::string header_type = GetAttribute(header, "VTKFile", "header_type");
+    const std::string compressor = GetAttribute(header, "VTKFile", "compressor");
+    SetHeaderType(header_type.empty() ? "UInt32" : header_type);
+    if (RequiresUInt64Header() && GetHeaderTypeSize() != sizeof(uint64_t)) {
+        std::cerr << "Error! Data sets larger than 4 GiB can't be appended to file " << file_name
+                << " with UInt32 headers. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    SetCompressor(compressor);
+    if (!compressor.empty() && GetCompressor() == NULL)
+        return false;
+
+    /* Appended data ends right before the closing lines of the file */
+    std::ostringstream tail;
+    SetIndentationLevel(2);
+    CloseAppendedSection(tail);
+    const std::string tail_str = tail.str();
+
+    fs.clear();
+    fs.seekg(0, std::ios::end);
+    const std::streamoff file_size = fs.tellg();
+    std::string file_tail(tail_str.size(), '\0');
+    if (file_size >= (std::streamoff)(header.size() + tail_str.size())) {
+        fs.seekg(file_size - tail_str.size());
+        fs.read(&file_tail[0], tail_str.size());
+    }
+    if (file_tail != tail_str) {
+        std::cerr << "Error! Unexpected end of file " << file_name << ". See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    const std::streamoff data_end = file_size - tail_str.size();
+
+    size_t total_size;
+    bool compressed;
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_PREPARE]);)
+        compressed = ComputeOffsets(total_size);
+    }
+    if (!compressed) {
+        ReleaseEncoded();
+        return false;
+    }
+    XMLW_STATS(const double header_start = StatsTimer::Now();)
+    const size_t appended_size = data_end - header.size();
+    const size_t old_size = header.size();
+    InsertSection("PointData", appended_size, header);
+    InsertSection("CellData", appended_size, header);
+
+    /* The main body keeps its size by consuming the padding in front of the appended section */
+    const size_t growth = header.size() - old_size;
+    size_t appended = header.rfind("<AppendedData");
+    while (appended != 0 && header[appended - 1] == ' ')
+        --appended;
+    size_t blanks = 0;
+    while (appended > blanks + 1 && header[appended - blanks - 2] == ' ')
+        ++blanks;
+    if (growth > blanks) {
+        std::cerr << "Error! Header padding of file " << file_name << " is too small: " << growth
+                << " Bytes required, " << blanks << " available. See " << __FILE__ << ":" << __LINE__ << "\n";
+        ReleaseEncoded();
+        return false;
+    }
+    header.erase(appended - 1 - growth, growth);
+    XMLW_STATS(
+        stats.phase_time[WriterStats::PHASE_HEADER] += StatsTimer::Now() - header_start;
+        stats.header_bytes = header.size();
+    )
+
+    /* New data sets are written first, so a failure leaves the original file intact */
+    std::vector<Segment> segments;
+    std::vector<char> prefixes;
+    CollectSegments(segments, prefixes);
+
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_PAYLOAD]); stats.num_writes += 2;)
+        fs.clear();
+        fs.seekp(data_end);
+        WriteSegments(segments, fs);
+        fs << tail_str;
+        fs.flush();
+
+        if (fs.good()) {
+            fs.seekp(0);
+            fs.write(header.data(), header.size());
+        }
+    }
+
+    ReleaseEncoded();
+
+    {
+        XMLW_STATS(StatsTimer timer(stats.phase_time[WriterStats::PHASE_CLOSE]); ++stats.num_syscalls;)
+        fs.close();
+    }
+    XMLW_STATS(stats.total_time = StatsTimer::Now() - start; ReportStats();)
+    return !fs.fail();
+}
+
+}
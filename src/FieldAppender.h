@@ -0,0 +1,118 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef FIELDAPPENDER_H_
+#define FIELDAPPENDER_H_
+
+#include <string>
+#include <fstream>
+
+#include "AppendedFileWriter.h"
+
+namespace xmlw {
+
+/*!
+ * \class FieldAppender
+ * \brief Adds point and cell data sets to a file previously written by AppendedFileWriter
+ * Only the main body of the file (everything before the appended data) is read. New 'DataArray' sections are
+ * inserted into the 'PointData' and 'CellData' sections of the piece, new data sets are written after the existing
+ * appended data. Offsets in the appended section are counted from its beginning, so the existing data can stay where
+ * it is only if the main body keeps its size: the file should be written with SetHeaderPadding() large enough for
+ * all sections added later (roughly 150 Bytes per data set). The compressor and the header type are taken from the
+ * file, settings of the appender are ignored. New data sets are written before the main body is updated, so a
+ * failure leaves the original file readable.
+ * Typical usage:
+ *   xmlw::UnstructuredGridWriter writer;
+ *   writer.SetHeaderPadding(4096);
+ *   ... register data sets ...
+ *   writer.Write("result.vtu");
+ *   ...
+ *   xmlw::FieldAppender appender;
+ *   appender.AddArray("PointData", "vorticity", vorticity);
+ *   appender.Append("result.vtu");
+ * \note Only single-piece files with raw appended data are supported.
+ */
+class FieldAppender : public AppendedFileWriter {
+public:
+
+    /*!
+     * \brief Constructor
+     */
+    FieldAppender();
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~FieldAppender() { }
+
+    /*!
+     * \brief Returns copy of the writer, data sets are referenced, not copied (see AppendedFileWriter::Clone())
+     */
+    virtual FieldAppender *Clone() const;
+
+    /*!
+     * \brief Adds all registered data sets to the existing file
+     * @param file_name Name of the file
+     * @return True if the file was successfully updated
+     */
+    bool Append(const std::string file_name);
+
+    /*!
+     * \brief Same as Append(), the file should exist
+     */
+    virtual bool Write(const std::string file_name);
+
+private:
+    /*!
+     * \brief Reads the main body of the file including the leading underscore of the appended data
+     * @param stream Input stream
+     * @param header Main body of the file
+     * @return True if the appended section was found
+     */
+    static bool ReadHeader(std::fstream &stream, std::string &header);
+
+    /*!
+     * \brief Returns value of the attribute of the first element with the given name
+     * @param header Main body of the file
+     * @param element Name of the element
+     * @param attribute Name of the attribute
+     * @return Value of the attribute, empty if not found
+     */
+    static std::string GetAttribute(const std::string &header, const std::string &element,
+            const std::string &attribute);
+
+    /*!
+     * \brief Inserts 'DataArray' sections of all registered data sets of the section into the main body
+     * @param section Name of the section ("PointData" or "CellData")
+     * @param base_offset Offset of the first new data set in the appended section
+     * @param header Main body of the file
+     */
+    void InsertSection(const std::string section, const size_t base_offset, std::string &header);
+};
+
+} /* namespace xmlw */
+
+#endif /* FIELDAPPENDER_H_ */
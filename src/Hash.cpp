@@ -0,0 +1,167 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "Hash.h"
+
+#include <cstring>
+
+namespace xmlw {
+
+static const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+static const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+static const uint64_t prime3 = 0x165667B19E3779F9ULL;
+static const uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+static const uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+static inline uint64_t RotateLeft(const uint64_t x, const int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+/*
+ * Unaligned little-endian loads (memcpy is turned into a single instruction by the compiler)
+ */
+static inline uint64_t Read64(const unsigned char *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint32_t Read32(const unsigned char *p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static inline uint64_t Round(uint64_t acc, const uint64_t input) {
+    acc += input * prime2;
+    acc = RotateLeft(acc, 31);
+    return acc * prime1;
+}
+
+static inline uint64_t MergeRound(uint64_t acc, const uint64_t value) {
+    acc ^= Round(0, value);
+    return acc * prime1 + prime4;
+}
+
+Hash64::Hash64(const uint64_t _seed) :
+        buffered(0), total(0), seed(_seed) {
+    acc[0] = seed + prime1 + prime2;
+    acc[1] = seed + prime2;
+    acc[2] = seed;
+    acc[3] = seed - prime1;
+}
+
+void Hash64::Update(const void *data, size_t size) {
+
+    const unsigned char *in = (const unsigned char*)data;
+    total += size;
+
+    /* Complete the stripe left from the previous chunk */
+    if (buffered != 0) {
+        const size_t count = (size < 32 - buffered) ? size : 32 - buffered;
+        std::memcpy(buffer + buffered, in, count);
+        buffered += count;
+        in += count;
+        size -= count;
+        if (buffered < 32)
+            return;
+        for(int lane = 0; lane < 4; ++lane)
+            acc[lane] = Round(acc[lane], Read64(buffer + 8 * lane));
+        buffered = 0;
+    }
+
+    /* Full stripes are consumed directly from the input */
+    uint64_t v0 = acc[0], v1 = acc[1], v2 = acc[2], v3 = acc[3];
+    for(; size >= 32; in += 32, size -= 32) {
+        v0 = Round(v0, Read64(in));
+        v1 = Round(v1, Read64(in + 8));
+        v2 = Round(v2, Read64(in + 16));
+        v3 = Round(v3, Read64(in + 24));
+    }
+    acc[0] = v0;
+    acc[1] = v1;
+    acc[2] = v2;
+    acc[3] = v3;
+
+    std::memcpy(buffer, in, size);
+    buffered = size;
+}
+
+void Hash64::Update(const std::string &str) {
+    Update((uint64_t)str.size());
+    Update(str.data(), str.size());
+}
+
+void Hash64::Update(const uint64_t value) {
+    Update(&value, sizeof(value));
+}
+
+uint64_t Hash64::Digest() const {
+
+    uint64_t h;
+    if (total >= 32) {
+        h = RotateLeft(acc[0], 1) + RotateLeft(acc[1], 7) + RotateLeft(acc[2], 12) + RotateLeft(acc[3], 18);
+        for(int lane = 0; lane < 4; ++lane)
+            h = MergeRound(h, acc[lane]);
+    }
+    else
+        h = seed + prime5;
+    h += total;
+
+    /* The tail shorter than a stripe */
+    const unsigned char *p = buffer;
+    size_t left = buffered;
+    for(; left >= 8; p += 8, left -= 8) {
+        h ^= Round(0, Read64(p));
+        h = RotateLeft(h, 27) * prime1 + prime4;
+    }
+    if (left >= 4) {
+        h ^= (uint64_t)Read32(p) * prime1;
+        h = RotateLeft(h, 23) * prime2 + prime3;
+        p += 4;
+        left -= 4;
+    }
+    for(; left != 0; ++p, --left) {
+        h ^= (*p) * prime5;
+        h = RotateLeft(h, 11) * prime1;
+    }
+
+    /* Final avalanche */
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t Hash64::Compute(const void *data, const size_t size, const uint64_t seed) {
+    Hash64 hash(seed);
+    hash.Update(data, size);
+    return hash.Digest();
+}
+
+}
@@ -0,0 +1,91 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace xmlw {
+
+/*!
+ * \class Hash64
+ * \brief Streaming 64-bit hash of binary data (XXH64 algorithm)
+ * The hash is used to detect unchanged data sets, it is not cryptographic. Data can be fed by chunks of any size,
+ * the result doesn't depend on how the data is split:
+ *   xmlw::Hash64 hash;
+ *   hash.Update(data.data(), data.size() * sizeof(data[0]));
+ *   uint64_t digest = hash.Digest();
+ */
+class Hash64 {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _seed Seed of the hash
+     */
+    explicit Hash64(const uint64_t _seed = 0);
+
+    /*!
+     * \brief Adds a chunk of data
+     * @param data Pointer to the chunk
+     * @param size Size of the chunk in Bytes
+     */
+    void Update(const void *data, size_t size);
+
+    /*!
+     * \brief Adds a string (including its length, so concatenated strings don't collide)
+     */
+    void Update(const std::string &str);
+
+    /*!
+     * \brief Adds an integer value
+     */
+    void Update(const uint64_t value);
+
+    /*!
+     * \brief Returns hash of all data added so far
+     */
+    uint64_t Digest() const;
+
+    /*!
+     * \brief Returns hash of a contiguous chunk of data
+     */
+    static uint64_t Compute(const void *data, const size_t size, const uint64_t seed = 0);
+
+private:
+    uint64_t acc[4];                //!< Accumulators of the four lanes
+    unsigned char buffer[32];       //!< Incomplete stripe
+    size_t buffered;                //!< Number of Bytes in the buffer
+    uint64_t total;                 //!< Total number of Bytes added
+    uint64_t seed;                  //!< Seed of the hash
+};
+
+} /* namespace xmlw */
+
+#endif /* HASH_H_ */
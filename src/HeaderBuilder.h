@@ -0,0 +1,107 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef HEADERBUILDER_H_
+#define HEADERBUILDER_H_
+
+#include <string>
+#include <cstddef>
+#include <type_traits>
+
+namespace xmlw {
+
+/*!
+ * \class HeaderBuilder
+ * \brief Text buffer used to assemble the main body of a file
+ * The builder accepts the same stream operators as std::ostream, so all Open*Section() functions of VTK_XML_Writer
+ * can write into it. Unlike std::ostringstream it appends directly into one buffer without locale-aware formatting
+ * and keeps the allocated memory when it is cleared, so the buffer is allocated once and reused for all files and
+ * pieces written by the same writer. Integers are formatted by AsciiEncoder.
+ */
+class HeaderBuilder {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param capacity Initial capacity of the buffer in Bytes
+     */
+    explicit HeaderBuilder(const size_t capacity = 1 << 12);
+
+    /*!
+     * \brief Appends a string
+     */
+    inline HeaderBuilder &operator<<(const std::string &str);
+
+    /*!
+     * \brief Appends a null-terminated string
+     */
+    inline HeaderBuilder &operator<<(const char *str);
+
+    /*!
+     * \brief Appends a character
+     */
+    inline HeaderBuilder &operator<<(const char c);
+
+    /*!
+     * \brief Appends an integer value
+     */
+    template<typename T>
+    inline typename std::enable_if<std::is_integral<T>::value, HeaderBuilder&>::type operator<<(const T value);
+
+    /*!
+     * \brief Appends a chunk of characters
+     */
+    inline HeaderBuilder &write(const char *data, const size_t size);
+
+    /*!
+     * \brief Returns pointer to the text
+     */
+    inline const char *data() const;
+
+    /*!
+     * \brief Returns size of the text in Bytes
+     */
+    inline size_t size() const;
+
+    /*!
+     * \brief Returns copy of the text
+     */
+    inline std::string str() const;
+
+    /*!
+     * \brief Removes the text, the memory is kept for the next use
+     */
+    inline void clear();
+
+private:
+    std::string buffer;     //!< Text
+};
+
+} /* namespace xmlw */
+
+#include "HeaderBuilder.inl"
+
+#endif /* HEADERBUILDER_H_ */
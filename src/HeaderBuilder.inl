@@ -0,0 +1,86 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef HEADERBUILDER_INL_
+#define HEADERBUILDER_INL_
+
+#include <cstring>
+
+#include "AsciiEncoder.h"
+
+namespace xmlw {
+
+inline HeaderBuilder::HeaderBuilder(const size_t capacity) {
+    buffer.reserve(capacity);
+}
+
+inline HeaderBuilder &HeaderBuilder::operator<<(const std::string &str) {
+    buffer.append(str);
+    return *this;
+}
+
+inline HeaderBuilder &HeaderBuilder::operator<<(const char *str) {
+    buffer.append(str, std::strlen(str));
+    return *this;
+}
+
+inline HeaderBuilder &HeaderBuilder::operator<<(const char c) {
+    buffer.push_back(c);
+    return *this;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value, HeaderBuilder&>::type
+HeaderBuilder::operator<<(const T value) {
+    char digits[32];
+    buffer.append(digits, AsciiEncoder::Format(value, digits) - digits);
+    return *this;
+}
+
+inline HeaderBuilder &HeaderBuilder::write(const char *data, const size_t size) {
+    buffer.append(data, size);
+    return *this;
+}
+
+inline const char *HeaderBuilder::data() const {
+    return buffer.data();
+}
+
+inline size_t HeaderBuilder::size() const {
+    return buffer.size();
+}
+
+inline std::string HeaderBuilder::str() const {
+    return buffer;
+}
+
+inline void HeaderBuilder::clear() {
+    buffer.clear();
+}
+
+}
+
+#endif /* HEADERBUILDER_INL_ */
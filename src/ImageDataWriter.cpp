@@ -0,0 +1,78 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "ImageDataWriter.h"
+
+namespace xmlw {
+
+ImageDataWriter::ImageDataWriter() : AppendedFileWriter("ImageData") {
+    for(size_t n = 0; n < 3; ++n) {
+        origin[n] = 0.;
+        spacing[n] = 1.;
+    }
+    UpdateGridAttributes();
+}
+
+ImageDataWriter *ImageDataWriter::Clone() const {
+    return new ImageDataWriter(*this);
+}
+
+void ImageDataWriter::SetDimensions(const size_t ni, const size_t nj, const size_t nk) {
+    SetExtent(0, ni != 0 ? ni - 1 : 0, 0, nj != 0 ? nj - 1 : 0, 0, nk != 0 ? nk - 1 : 0);
+}
+
+void ImageDataWriter::SetOrigin(const double x, const double y, const double z) {
+    origin[0] = x;
+    origin[1] = y;
+    origin[2] = z;
+    UpdateGridAttributes();
+}
+
+void ImageDataWriter::SetSpacing(const double dx, const double dy, const double dz) {
+    spacing[0] = dx;
+    spacing[1] = dy;
+    spacing[2] = dz;
+    UpdateGridAttributes();
+}
+
+void ImageDataWriter::UpdateGridAttributes() {
+
+    char buffer[64];
+    std::string origin_str, spacing_str;
+
+    for(size_t n = 0; n < 3; ++n) {
+        if (n != 0) {
+            origin_str += " ";
+            spacing_str += " ";
+        }
+        origin_str.append(buffer, AsciiEncoder::Format(origin[n], buffer));
+        spacing_str.append(buffer, AsciiEncoder::Format(spacing[n], buffer));
+    }
+
+    grid_attributes = " Origin=\"" + origin_str + "\" Spacing=\"" + spacing_str + "\"";
+}
+
+}
@@ -0,0 +1,96 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef IMAGEDATAWRITER_H_
+#define IMAGEDATAWRITER_H_
+
+#include <string>
+
+#include "AppendedFileWriter.h"
+
+namespace xmlw {
+
+/*!
+ * \class ImageDataWriter
+ * \brief Writes uniform Cartesian grids into .vti files
+ * Geometry of the grid is defined implicitly by the origin, the spacing and the extent, so only point and cell
+ * data sets are written. The point with indices (i, j, k) of the extent is located at Origin + (i, j, k) * Spacing,
+ * thus SetDimensions() uses extents starting from 0, so the first point of the grid is located at the origin.
+ * Example:
+ *   xmlw::ImageDataWriter writer;
+ *   writer.SetDimensions(nx, ny, nz);
+ *   writer.SetOrigin(0., 0., 0.);
+ *   writer.SetSpacing(dx, dy, dz);
+ *   writer.AddArray("PointData", "pressure", pressure);
+ *   writer.Write("grid.vti");
+ */
+class ImageDataWriter : public AppendedFileWriter {
+public:
+
+    /*!
+     * \brief Constructor
+     */
+    ImageDataWriter();
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~ImageDataWriter() { }
+
+    /*!
+     * \brief Returns copy of the writer, data sets are referenced, not copied (see AppendedFileWriter::Clone())
+     */
+    virtual ImageDataWriter *Clone() const;
+
+    /*!
+     * \brief Sets number of points in each direction, the extent is set to [0, n - 1]
+     */
+    void SetDimensions(const size_t ni, const size_t nj, const size_t nk);
+
+    /*!
+     * \brief Sets coordinates of the point with zero indices
+     */
+    void SetOrigin(const double x, const double y, const double z);
+
+    /*!
+     * \brief Sets distances between points in each direction
+     */
+    void SetSpacing(const double dx, const double dy, const double dz);
+
+private:
+    /*!
+     * \brief Updates attributes of the grid section
+     */
+    void UpdateGridAttributes();
+
+private:
+    double origin[3];       //!< Coordinates of the point with zero indices
+    double spacing[3];      //!< Distances between points
+};
+
+} /* namespace xmlw */
+
+#endif /* IMAGEDATAWRITER_H_ */
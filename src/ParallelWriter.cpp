@@ -0,0 +1,532 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifdef XMLW_WITH_MPI
+
+#include "ParallelWriter.h"
+#include "XMLReader.h"
+#include "VTKCellType.h"
+
+#include <fstream>
+#include <iostream>
+
+namespace xmlw {
+
+ParallelWriter::ParallelWriter(const std::string _grid_type, MPI_Comm _comm, const int _root) :
+        AppendedFileWriter(_grid_type), comm(_comm), root(_root), info(MPI_INFO_NULL) {
+}
+
+ParallelWriter *ParallelWriter::Clone() const {
+    return new ParallelWriter(*this);
+}
+
+void ParallelWriter::SetFileInfo(MPI_Info _info) {
+    info = _info;
+}
+
+std::string ParallelWriter::FileExtension(const std::string grid_type) {
+    if (grid_type == "UnstructuredGrid")
+        return "vtu";
+    if (grid_type == "StructuredGrid")
+        return "vts";
+    if (grid_type == "RectilinearGrid")
+        return "vtr";
+    if (grid_type == "ImageData")
+        return "vti";
+    if (grid_type == "PolyData")
+        return "vtp";
+
+    std::cerr << "Error! Unknown type of the data set : " << grid_type << ". See "
+            << __FILE__ << ":" << __LINE__ << "\n";
+    return "vtk";
+}
+
+bool ParallelWriter::Write(const std::string base_name) {
+
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    const std::string ext = FileExtension(grid_type);
+
+    /* Pieces are referenced from the master file relative to its location */
+    const size_t slash = base_name.find_last_of('/');
+    const std::string local_name = (slash == std::string::npos) ? base_name : base_name.substr(slash + 1);
+
+    int status = AppendedFileWriter::Write(base_name + "_" + std::to_string(rank) + "." + ext) ? 1 : 0;
+
+    std::vector<unsigned long long> local(extent, extent + 6);
+    std::vector<unsigned long long> extents;
+    if (rank == root)
+        extents.resize(6 * size);
+    MPI_Gather(local.data(), 6, MPI_UNSIGNED_LONG_LONG, extents.data(), 6, MPI_UNSIGNED_LONG_LONG, root, comm);
+
+    if (rank == root) {
+        std::vector<std::string> sources(size);
+        for(int r = 0; r < size; ++r)
+            sources[r] = local_name + "_" + std::to_string(r) + "." + ext;
+        if (!WriteMaster(base_name + ".p" + ext, sources, extents))
+            status = 0;
+    }
+
+    int global_status = 0;
+    MPI_Allreduce(&status, &global_status, 1, MPI_INT, MPI_MIN, comm);
+
+    return global_status == 1;
+}
+
+bool ParallelWriter::WriteShared(const std::string file_name) {
+
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    XMLW_STATS(stats.Reset(); stats.file_name = file_name; const double start = StatsTimer::Now();)
+
+    /* All pieces share the header type of the file */
+    const std::string requested_header_type = GetHeaderType();
+    int large = RequiresUInt64Header() ? 1 : 0;
+    int any_large = 0;
+    MPI_Allreduce(&large, &any_large, 1, MPI_INT, MPI_MAX, comm);
+    if (any_large)
+        SetHeaderType("UInt64");
+
+    /* Position of data sets of the rank in the appended section */
+    XMLW_STATS(double phase_start = StatsTimer::Now();)
+    size_t total_size;
+    const bool compressed = ComputeOffsets(total_size);
+    unsigned long long data_size = total_size;
+    XMLW_STATS(stats.phase_time[WriterStats::PHASE_PREPARE] += StatsTimer::Now() - phase_start;)
+    unsigned long long data_offset = 0;
+    unsigned long long data_total = 0;
+    MPI_Exscan(&data_size, &data_offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    MPI_Allreduce(&data_size, &data_total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0)
+        data_offset = 0;
+
+    /* Parts of the main body, each rank assembles only its own piece */
+    XMLW_STATS(phase_start = StatsTimer::Now();)
+    HeaderBuilder prolog, piece, epilog, trailer(64);
+    Header(prolog);
+    OpenVTKSection(grid_type, prolog);
+        OpenSection(GridSection(), prolog);
+            WritePiece(piece, data_offset);
+        CloseSection(grid_type, epilog);
+    OpenAppendedSection(epilog);
+    CloseAppendedSection(trailer);
+
+    const std::string prolog_str = prolog.str();
+    const std::string piece_str = piece.str();
+    const std::string epilog_str = epilog.str();
+    const std::string trailer_str = trailer.str();
+    XMLW_STATS(
+        stats.phase_time[WriterStats::PHASE_HEADER] += StatsTimer::Now() - phase_start;
+        stats.header_bytes = piece_str.size() + (rank == root ? prolog_str.size() + epilog_str.size() : 0);
+    )
+
+    /* Position of the piece of the rank in the main body */
+    unsigned long long piece_size = piece_str.size();
+    unsigned long long piece_offset = 0;
+    unsigned long long pieces_total = 0;
+    MPI_Exscan(&piece_size, &piece_offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    MPI_Allreduce(&piece_size, &pieces_total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    if (rank == 0)
+        piece_offset = 0;
+
+    const unsigned long long body_size = prolog_str.size() + pieces_total + epilog_str.size();
+    const unsigned long long file_size = body_size + data_total + trailer_str.size();
+
+    /* Opening is collective, so ranks which failed to compress their data sets open the file as well */
+    int status = compressed ? 1 : 0;
+    MPI_File file;
+    XMLW_STATS(phase_start = StatsTimer::Now();)
+    const bool opened = MPI_File_open(comm, (char*)file_name.c_str(), MPI_MODE_CREATE | MPI_MODE_WRONLY, info,
+            &file) == MPI_SUCCESS;
+    if (!opened) {
+        std::cerr << "Error! Can't open file " << file_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        status = 0;
+    }
+
+    int global_status = 0;
+    MPI_Allreduce(&status, &global_status, 1, MPI_INT, MPI_MIN, comm);
+    if (global_status == 0) {
+        if (opened)
+            MPI_File_close(&file);
+        ReleaseEncoded();
+        SetHeaderType(requested_header_type);
+        return false;
+    }
+
+    /* Removes the rest of an old file, if any */
+    if (MPI_File_set_size(file, file_size) != MPI_SUCCESS)
+        status = 0;
+
+    if (rank == root) {
+        if (MPI_File_write_at(file, 0, (void*)prolog_str.data(), prolog_str.size(), MPI_CHAR,
+                MPI_STATUS_IGNORE) != MPI_SUCCESS)
+            status = 0;
+        if (MPI_File_write_at(file, prolog_str.size() + pieces_total, (void*)epilog_str.data(),
+                epilog_str.size(), MPI_CHAR, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+            status = 0;
+        if (MPI_File_write_at(file, body_size + data_total, (void*)trailer_str.data(), trailer_str.size(),
+                MPI_CHAR, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+            status = 0;
+    }
+
+    if (MPI_File_write_at_all(file, prolog_str.size() + piece_offset, (void*)piece_str.data(), piece_str.size(),
+            MPI_CHAR, MPI_STATUS_IGNORE) != MPI_SUCCESS)
+        status = 0;
+
+    if (!WriteSharedData(file, body_size + data_offset))
+        status = 0;
+    XMLW_STATS(
+        stats.num_writes += (rank == root) ? 5 : 2;
+        stats.phase_time[WriterStats::PHASE_PAYLOAD] += StatsTimer::Now() - phase_start;
+        phase_start = StatsTimer::Now();
+    )
+
+    if (MPI_File_close(&file) != MPI_SUCCESS)
+        status = 0;
+    XMLW_STATS(stats.phase_time[WriterStats::PHASE_CLOSE] += StatsTimer::Now() - phase_start;)
+
+    ReleaseEncoded();
+    SetHeaderType(requested_header_type);
+
+    MPI_Allreduce(&status, &global_status, 1, MPI_INT, MPI_MIN, comm);
+    XMLW_STATS(stats.total_time = StatsTimer::Now() - start; ReportStats();)
+
+    return global_status == 1;
+}
+
+bool ParallelWriter::WriteSharedData(MPI_File file, const unsigned long long position) {
+
+    /* MPI counts are integers, so large data sets are split into several blocks */
+    const size_t max_block = size_t(1) << 30;
+    std::vector<Segment> segments;
+    std::vector<char> prefixes;
+    std::vector<int> lengths;
+    std::vector<MPI_Aint> displacements;
+
+    CollectSegments(segments, prefixes);
+
+    /* MPI datatypes describe memory, so data sets generated on the fly are materialized first */
+    std::vector<std::vector<char> > generated;
+    generated.reserve(segments.size());
+    for(size_t n = 0; n < segments.size(); ++n) {
+        if (segments[n].fill == NULL)
+            continue;
+        generated.push_back(std::vector<char>(segments[n].size));
+        (*segments[n].fill)(0, segments[n].size, generated.back().data());
+        segments[n].data = generated.back().data();
+        segments[n].fill = NULL;
+    }
+
+    for(size_t n = 0; n < segments.size(); ++n) {
+        for(size_t pos = 0; pos < segments[n].size; pos += max_block) {
+            MPI_Aint address;
+            MPI_Get_address((void*)(segments[n].data + pos), &address);
+            displacements.push_back(address);
+            lengths.push_back(segments[n].size - pos < max_block ? segments[n].size - pos : max_block);
+        }
+    }
+
+    int result;
+    if (lengths.empty()) {
+        result = MPI_File_write_at_all(file, position, NULL, 0, MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    else {
+        MPI_Datatype type;
+        MPI_Type_create_hindexed(lengths.size(), lengths.data(), displacements.data(), MPI_BYTE, &type);
+        MPI_Type_commit(&type);
+        result = MPI_File_write_at_all(file, position, MPI_BOTTOM, 1, type, MPI_STATUS_IGNORE);
+        MPI_Type_free(&type);
+    }
+
+    return result == MPI_SUCCESS;
+}
+
+bool ParallelWriter::WriteMaster(const std::string file_name, const std::vector<std::string> &sources,
+        const std::vector<unsigned long long> &extents) {
+
+    std::ofstream os;
+    const std::string pgrid_type = "P" + grid_type;
+    const std::string pgrid = "P" + GridSection() + " GhostLevel=\"0\"";
+
+    os.open(file_name.c_str(), std::ios::out);
+    if (!os.is_open()) {
+        std::cerr << "Error! Can't open file " << file_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    Header(os);
+    OpenVTKSection(pgrid_type, os);
+        OpenSection(pgrid, os);
+            WritePArrays(os);
+
+            for(size_t n = 0; n < sources.size(); ++n) {
+                std::string piece = "Piece";
+                if (has_extent) {
+                    size_t ext[6];
+                    for(size_t e = 0; e < 6; ++e)
+                        ext[e] = extents[6 * n + e];
+                    piece += " Extent=\"" + ExtentToString(ext) + "\"";
+                }
+                OneLineSection(piece + " Source=\"" + sources[n] + "\"", os);
+            }
+
+        CloseSection(pgrid_type, os);
+    CloseVTKSection(os);
+
+    os.close();
+
+    return !os.fail();
+}
+
+/*
+ * Piece of the test grid owned by the rank: 3x3x3 points shifted along x by two cells per rank and 2x2x2 hexahedra
+ */
+struct TestPiece {
+    std::vector<float> points;
+    std::vector<int> connectivity;
+    std::vector<int> offsets;
+    std::vector<uint8_t> types;
+    std::vector<double> scalars;
+    std::vector<int> ranks;
+
+    explicit TestPiece(const int rank) {
+        for(int k = 0; k < 3; ++k)
+            for(int j = 0; j < 3; ++j)
+                for(int i = 0; i < 3; ++i) {
+                    points.push_back(2 * rank + i);
+                    points.push_back(j);
+                    points.push_back(k);
+                    scalars.push_back(1000.0 * rank + 0.25 * (i + 3 * j + 9 * k));
+                }
+        for(int k = 0; k < 2; ++k)
+            for(int j = 0; j < 2; ++j)
+                for(int i = 0; i < 2; ++i) {
+                    const int first = i + 3 * j + 9 * k;
+                    const int nodes[8] = { first, first + 1, first + 4, first + 3,
+                            first + 9, first + 10, first + 13, first + 12 };
+                    connectivity.insert(connectivity.end(), nodes, nodes + 8);
+                    offsets.push_back(connectivity.size());
+                    types.push_back(VTK_HEXAHEDRON);
+                    ranks.push_back(rank);
+                }
+    }
+};
+
+/*
+ * Loads the data set of the piece from the file and compares it with the written one, prints an error if they differ
+ */
+template<typename T>
+static bool CheckPieceArray(VTK_XML_Reader &reader, const std::string &file_name, const std::string &section,
+        const std::string &name, const std::vector<T> &data, const size_t piece) {
+
+    const VTK_XML_Reader::ArrayInfo *arr = reader.FindArray(section, name, piece);
+    std::vector<T> loaded;
+
+    if (arr == NULL || !reader.ReadArray(*arr, loaded) || loaded != data) {
+        std::cerr << "Error! Data set " << section << "/" << name << " of piece " << piece << " of file "
+                << file_name << " differs from the written one. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Compares the attribute of an element of the file with the expected value, prints an error if they differ
+ */
+static bool CheckPieceAttribute(const VTK_XML_Reader &reader, const std::string &file_name,
+        const std::string &element, const std::string &attribute, const std::string &value, const size_t index) {
+
+    if (reader.GetAttribute(element, attribute, index) != value) {
+        std::cerr << "Error! Attribute " << attribute << " of " << element << " " << index << " of file " << file_name
+                << " is '" << reader.GetAttribute(element, attribute, index) << "' instead of '" << value
+                << "'. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Reads the file on the root, prints an error if it can't be opened
+ */
+static bool OpenTestFile(VTK_XML_Reader &reader, const std::string &file_name) {
+    if (!reader.Open(file_name)) {
+        std::cerr << "Error! Can't read back " << file_name << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool ParallelWriter::TestParallelOutput(MPI_Comm comm) {
+
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    const int root = 0;
+    const TestPiece local(rank);
+    bool written = true;
+    bool status = true;
+
+    /* Pieces of an unstructured grid with the master file (.pvtu) */
+    {
+        ParallelWriter writer("UnstructuredGrid", comm, root);
+        writer.SetPiece(local.scalars.size(), local.ranks.size());
+        writer.AddArray("Points", "Points", local.points, 3);
+        writer.AddArray("Cells", "connectivity", local.connectivity);
+        writer.AddArray("Cells", "offsets", local.offsets);
+        writer.AddArray("Cells", "types", local.types);
+        writer.AddArray("PointData", "scalars", local.scalars);
+        writer.AddArray("CellData", "rank", local.ranks);
+        written = writer.Write("parallel_unstructured") && written;
+    }
+
+    /* Slabs of a structured grid with the master file (.pvts) */
+    {
+        ParallelWriter writer("StructuredGrid", comm, root);
+        writer.SetExtent(2 * rank, 2 * rank + 2, 0, 2, 0, 2);
+        writer.SetWholeExtent(0, 2 * size, 0, 2, 0, 2);
+        writer.AddArray("Points", "Points", local.points, 3);
+        writer.AddArray("PointData", "scalars", local.scalars);
+        written = writer.Write("parallel_structured") && written;
+    }
+
+    /* All pieces of an unstructured grid in one file */
+    const char *shared_compressors[] = {
+        "",
+#ifdef XMLW_WITH_ZLIB
+        "vtkZLibDataCompressor",
+#endif
+    };
+    const size_t num_shared = sizeof(shared_compressors) / sizeof(shared_compressors[0]);
+    for(size_t c = 0; c < num_shared; ++c) {
+        ParallelWriter writer("UnstructuredGrid", comm, root);
+        if (*shared_compressors[c] != '\0')
+            writer.SetCompressor(shared_compressors[c]);
+        writer.SetPiece(local.scalars.size(), local.ranks.size());
+        writer.AddArray("Points", "Points", local.points, 3);
+        writer.AddArray("Cells", "connectivity", local.connectivity);
+        writer.AddArray("Cells", "offsets", local.offsets);
+        writer.AddArray("Cells", "types", local.types);
+        writer.AddArray("PointData", "scalars", local.scalars);
+        writer.AddArray("CellData", "rank", local.ranks);
+        written = writer.WriteShared("parallel_shared_" + std::to_string(c) + ".vtu") && written;
+    }
+
+    if (!written) {
+        if (rank == root)
+            std::cerr << "Error! Parallel output failed. See " << __FILE__ << ":" << __LINE__ << "\n";
+        status = false;
+    }
+
+    /* Files are complete once the collective writes return */
+    if (status && rank == root) {
+        VTK_XML_Reader reader;
+
+        std::string file_name = "parallel_unstructured.pvtu";
+        if (OpenTestFile(reader, file_name)) {
+            status = CheckPieceAttribute(reader, file_name, "PPointData", "Scalars", "scalars", 0) && status;
+            for(int r = 0; r < size; ++r)
+                status = CheckPieceAttribute(reader, file_name, "Piece", "Source",
+                        "parallel_unstructured_" + std::to_string(r) + ".vtu", r) && status;
+        }
+        else
+            status = false;
+
+        for(int r = 0; r < size; ++r) {
+            const TestPiece piece(r);
+            file_name = "parallel_unstructured_" + std::to_string(r) + ".vtu";
+            if (!OpenTestFile(reader, file_name)) {
+                status = false;
+                continue;
+            }
+            status = CheckPieceAttribute(reader, file_name, "Piece", "NumberOfPoints", "27", 0) && status;
+            status = CheckPieceArray(reader, file_name, "Points", "Points", piece.points, 0) && status;
+            status = CheckPieceArray(reader, file_name, "Cells", "connectivity", piece.connectivity, 0) && status;
+            status = CheckPieceArray(reader, file_name, "PointData", "scalars", piece.scalars, 0) && status;
+            status = CheckPieceArray(reader, file_name, "CellData", "rank", piece.ranks, 0) && status;
+        }
+
+        file_name = "parallel_structured.pvts";
+        if (OpenTestFile(reader, file_name)) {
+            status = CheckPieceAttribute(reader, file_name, "PStructuredGrid", "WholeExtent",
+                    "0 " + std::to_string(2 * size) + " 0 2 0 2", 0) && status;
+            for(int r = 0; r < size; ++r)
+                status = CheckPieceAttribute(reader, file_name, "Piece", "Extent",
+                        std::to_string(2 * r) + " " + std::to_string(2 * r + 2) + " 0 2 0 2", r) && status;
+        }
+        else
+            status = false;
+
+        for(int r = 0; r < size; ++r) {
+            const TestPiece piece(r);
+            file_name = "parallel_structured_" + std::to_string(r) + ".vts";
+            if (!OpenTestFile(reader, file_name)) {
+                status = false;
+                continue;
+            }
+            status = CheckPieceArray(reader, file_name, "Points", "Points", piece.points, 0) && status;
+            status = CheckPieceArray(reader, file_name, "PointData", "scalars", piece.scalars, 0) && status;
+        }
+
+        for(size_t c = 0; c < num_shared; ++c) {
+            file_name = "parallel_shared_" + std::to_string(c) + ".vtu";
+            if (!OpenTestFile(reader, file_name)) {
+                status = false;
+                continue;
+            }
+            if (reader.GetNumberOfPieces() != size_t(size)) {
+                std::cerr << "Error! " << file_name << " has " << reader.GetNumberOfPieces() << " pieces instead of "
+                        << size << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+                status = false;
+                continue;
+            }
+            for(int r = 0; r < size; ++r) {
+                const TestPiece piece(r);
+                status = CheckPieceAttribute(reader, file_name, "Piece", "NumberOfCells", "8", r) && status;
+                status = CheckPieceArray(reader, file_name, "Points", "Points", piece.points, r) && status;
+                status = CheckPieceArray(reader, file_name, "Cells", "connectivity", piece.connectivity, r)
+                        && status;
+                status = CheckPieceArray(reader, file_name, "Cells", "offsets", piece.offsets, r) && status;
+                status = CheckPieceArray(reader, file_name, "PointData", "scalars", piece.scalars, r) && status;
+                status = CheckPieceArray(reader, file_name, "CellData", "rank", piece.ranks, r) && status;
+            }
+        }
+    }
+
+    int result = status ? 1 : 0;
+    MPI_Bcast(&result, 1, MPI_INT, root, comm);
+
+    return result == 1;
+}
+
+}
+
+#endif /* XMLW_WITH_MPI */
@@ -0,0 +1,199 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef PARALLELWRITER_H_
+#define PARALLELWRITER_H_
+
+#ifdef XMLW_WITH_MPI
+
+#include <string>
+#include <vector>
+#include <mpi.h>
+
+#include "AppendedFileWriter.h"
+
+namespace xmlw {
+
+/*!
+ * \class ParallelWriter
+ * \brief Writes a parallel VTK data set (.pvtu, .pvts, ...) from MPI-decomposed data
+ * Each rank registers its own data sets exactly as for AppendedFileWriter and writes its own piece file
+ * "<base>_<rank>.vtu" through the appended path. The designated rank (the root) also writes the master file
+ * "<base>.pvtu" which lists all data sets ('PPoints', 'PPointData', 'PCellData', ...) and all pieces:
+ *   <VTKFile type="PUnstructuredGrid" ...>
+ *     <PUnstructuredGrid GhostLevel="0">
+ *       <PPointData Scalars="scalars">
+ *         <PDataArray type="Float32" Name="scalars" NumberOfComponents="1"/>
+ *       </PPointData>
+ *       <PPoints>
+ *         <PDataArray type="Float32" Name="points" NumberOfComponents="3"/>
+ *       </PPoints>
+ *       <Piece Source="test_0.vtu"/>
+ *       ...
+ *     </PUnstructuredGrid>
+ *   </VTKFile>
+ * For structured data sets the extent of every piece is gathered on the root and the whole extent should be set
+ * with SetWholeExtent() on all ranks.
+ * Alternatively all pieces can be written into one shared file (see WriteShared()), which avoids creating one file
+ * per rank. In this case the file contains one 'Piece' section per rank and all data sets are placed into the common
+ * appended section:
+ *   <UnstructuredGrid>
+ *     <Piece ...> ... offset="0" ... offset="O1" ... </Piece>        <- rank 0
+ *     <Piece ...> ... offset="S0" ... offset="S0+O1" ... </Piece>    <- rank 1
+ *   </UnstructuredGrid>
+ *   <AppendedData encoding="raw">
+ *   _[data of rank 0][data of rank 1]...
+ * where S0 is the size of all data sets of rank 0. Positions of pieces and data sets of each rank in the file are
+ * obtained by exclusive prefix sums of their sizes, after that everything is written by collective MPI-IO calls.
+ * Data sets of a rank are described by a single MPI datatype, so the whole appended section is written by one
+ * collective call and can be aggregated and aligned by the MPI-IO layer (see SetFileInfo() for the hints).
+ * \note All ranks should register the same data sets (names, types and numbers of components). Write() and
+ * WriteShared() are collective.
+ */
+class ParallelWriter : public AppendedFileWriter {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param _grid_type Type of the data set (UnstructuredGrid, StructuredGrid, ...)
+     * @param _comm MPI communicator
+     * @param _root Rank which writes the master file
+     */
+    ParallelWriter(const std::string _grid_type, MPI_Comm _comm = MPI_COMM_WORLD, const int _root = 0);
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~ParallelWriter() { }
+
+    /*!
+     * \brief Returns copy of the writer, data sets are referenced, not copied (see AppendedFileWriter::Clone())
+     */
+    virtual ParallelWriter *Clone() const;
+
+    /*!
+     * \brief Writes down piece files of all ranks and the master file
+     * @param base_name Name of the files without extension
+     * @return True if all files were successfully written (the same value on all ranks)
+     */
+    virtual bool Write(const std::string base_name);
+
+    /*!
+     * \brief Writes down pieces of all ranks into one shared file using MPI-IO
+     * @param file_name Name of the file
+     * @return True if the file was successfully written (the same value on all ranks)
+     */
+    bool WriteShared(const std::string file_name);
+
+    /*!
+     * \brief Sets MPI-IO hints used by WriteShared() (striping, collective buffering, ...)
+     * @param _info MPI info object, should stay valid until the file is written
+     */
+    void SetFileInfo(MPI_Info _info);
+
+    /*!
+     * \brief Returns extension of piece files for the given type of the data set ("vtu", "vts", ...)
+     * @param grid_type Type of the data set
+     */
+    static std::string FileExtension(const std::string grid_type);
+
+    /*!
+     * \brief Writes down unstructured and structured grids decomposed between ranks and checks them on the root
+     * Piece files with the master file (Write()) and shared files (WriteShared()) are read back by VTK_XML_Reader.
+     * Collective, should be run on several ranks (e.g. "mpirun -np 3 xmlwriter_test"). Files "parallel_*" are left
+     * in the working directory.
+     * @param comm MPI communicator
+     * @return True if all files were read back unchanged (the same value on all ranks)
+     */
+    static bool TestParallelOutput(MPI_Comm comm = MPI_COMM_WORLD);
+
+protected:
+    /*!
+     * \brief Writes down the master file
+     * @param file_name Name of the master file
+     * @param sources Names of piece files
+     * @param extents Extents of all pieces (six numbers per piece)
+     * @return True if the file was successfully written
+     */
+    bool WriteMaster(const std::string file_name, const std::vector<std::string> &sources,
+            const std::vector<unsigned long long> &extents);
+
+    /*!
+     * \brief Writes down description of data sets (without data) for the master file
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void WritePArrays(Stream &stream);
+
+    /*!
+     * \brief Writes down all data sets of the rank into the shared file by a single collective call
+     * @param file MPI file handle
+     * @param position Position of the first data set of the rank in the file
+     * @return True if data was successfully written
+     */
+    bool WriteSharedData(MPI_File file, const unsigned long long position);
+
+protected:
+    MPI_Comm comm;      //!< MPI communicator
+    int root;           //!< Rank which writes the master file
+    MPI_Info info;      //!< MPI-IO hints
+};
+
+template<typename Stream>
+inline void ParallelWriter::WritePArrays(Stream &stream) {
+
+    std::string section;
+
+    SortArrays();
+    for(size_t n = 0; n < order.size(); ++n) {
+        const ArrayInfo &arr = arrays[order[n]];
+
+        /* Topology of unstructured pieces is not described in the master file */
+        if (arr.section == "Cells")
+            continue;
+
+        if (arr.section != section) {
+            if (!section.empty())
+                CloseSection("P" + section, stream);
+            section = arr.section;
+            if (section == "PointData" || section == "CellData")
+                OpenSection("P" + FieldSection(section), stream);
+            else
+                OpenSection("P" + section, stream);
+        }
+
+        OneLineSection("PDataArray type=\"" + ConvertedType(arr) + "\" Name=\"" + arr.name
+                + "\" NumberOfComponents=\"" + std::to_string(arr.num_of_comp) + "\"", stream);
+    }
+    if (!section.empty())
+        CloseSection("P" + section, stream);
+}
+
+} /* namespace xmlw */
+
+#endif /* XMLW_WITH_MPI */
+
+#endif /* PARALLELWRITER_H_ */
@@ -0,0 +1,98 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef RECTILINEARGRIDWRITER_H_
+#define RECTILINEARGRIDWRITER_H_
+
+#include <string>
+
+#include "AppendedFileWriter.h"
+
+namespace xmlw {
+
+/*!
+ * \class RectilinearGridWriter
+ * \brief Writes Cartesian grids with non-uniform spacing into .vtr files
+ * Geometry of the grid is defined by three one-dimensional arrays of coordinates, which are written into the
+ * 'Coordinates' section instead of coordinates of every point.
+ * Example:
+ *   xmlw::RectilinearGridWriter writer;
+ *   writer.SetCoordinates(x, y, z);
+ *   writer.AddArray("CellData", "pressure", pressure);
+ *   writer.Write("grid.vtr");
+ */
+class RectilinearGridWriter : public AppendedFileWriter {
+public:
+
+    /*!
+     * \brief Constructor
+     */
+    inline RectilinearGridWriter();
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~RectilinearGridWriter() { }
+
+    /*!
+     * \brief Returns copy of the writer, data sets are referenced, not copied (see AppendedFileWriter::Clone())
+     */
+    inline virtual RectilinearGridWriter *Clone() const;
+
+    /*!
+     * \brief Registers coordinates of the grid lines, previously registered coordinates are replaced
+     * Unless the extent was set explicitly by SetExtent(), it is set to [0, n - 1] in each direction.
+     * @param x Coordinates along the first axis, should be compatible with STL library
+     * @param y Coordinates along the second axis, should be compatible with STL library
+     * @param z Coordinates along the third axis, should be compatible with STL library
+     */
+    template<typename DataX, typename DataY, typename DataZ>
+    inline void SetCoordinates(DataX &x, DataY &y, DataZ &z);
+
+    /*!
+     * \brief Sets extent of the piece, it is kept when the coordinates are replaced
+     * The extent should match the numbers of coordinates along the axes.
+     */
+    inline virtual void SetExtent(const size_t i0, const size_t i1, const size_t j0, const size_t j1,
+            const size_t k0, const size_t k1);
+
+private:
+    /*!
+     * \brief Checks that the extent matches the numbers of coordinates (if they are registered)
+     * @return True if the extent is consistent
+     */
+    inline bool CheckExtent() const;
+
+private:
+    bool user_extent;       //!< True if the extent was set by SetExtent(), not deduced from the coordinates
+    size_t num_coordinates[3]; //!< Numbers of coordinates along the axes (0 if not registered)
+};
+
+} /* namespace xmlw */
+
+#include "RectilinearGridWriter.inl"
+
+#endif /* RECTILINEARGRIDWRITER_H_ */
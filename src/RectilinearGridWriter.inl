@@ -0,0 +1,84 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef RECTILINEARGRIDWRITER_INL_
+#define RECTILINEARGRIDWRITER_INL_
+
+namespace xmlw {
+
+inline RectilinearGridWriter::RectilinearGridWriter() : AppendedFileWriter("RectilinearGrid"), user_extent(false) {
+    for(size_t n = 0; n < 3; ++n)
+        num_coordinates[n] = 0;
+}
+
+inline RectilinearGridWriter *RectilinearGridWriter::Clone() const {
+    return new RectilinearGridWriter(*this);
+}
+
+template<typename DataX, typename DataY, typename DataZ>
+inline void RectilinearGridWriter::SetCoordinates(DataX &x, DataY &y, DataZ &z) {
+
+    for(size_t n = arrays.size(); n > 0; --n)
+        if (arrays[n - 1].section == "Coordinates")
+            arrays.erase(arrays.begin() + (n - 1));
+
+    AddArray("Coordinates", "x", x);
+    AddArray("Coordinates", "y", y);
+    AddArray("Coordinates", "z", z);
+
+    num_coordinates[0] = x.size();
+    num_coordinates[1] = y.size();
+    num_coordinates[2] = z.size();
+
+    if (!user_extent) {
+        const size_t ni = x.size(), nj = y.size(), nk = z.size();
+        AppendedFileWriter::SetExtent(0, ni != 0 ? ni - 1 : 0, 0, nj != 0 ? nj - 1 : 0, 0, nk != 0 ? nk - 1 : 0);
+    }
+    else
+        CheckExtent();
+}
+
+inline void RectilinearGridWriter::SetExtent(const size_t i0, const size_t i1, const size_t j0, const size_t j1,
+        const size_t k0, const size_t k1) {
+    AppendedFileWriter::SetExtent(i0, i1, j0, j1, k0, k1);
+    user_extent = true;
+    CheckExtent();
+}
+
+inline bool RectilinearGridWriter::CheckExtent() const {
+    for(size_t n = 0; n < 3; ++n) {
+        if (num_coordinates[n] != 0 && extent[2 * n + 1] - extent[2 * n] + 1 != num_coordinates[n]) {
+            std::cerr << "Error! Extent " << ExtentToString(extent) << " doesn't match " << num_coordinates[n]
+                    << " coordinates along axis " << n << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+#endif /* RECTILINEARGRIDWRITER_INL_ */
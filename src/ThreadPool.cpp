@@ -0,0 +1,148 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace xmlw {
+
+struct ThreadPool::Batch {
+    std::function<void(size_t)> task;               //!< Task to be executed
+    size_t num_tasks;                               //!< Number of tasks in the batch
+    std::atomic<size_t> next;                       //!< Index of the next task to be taken
+    size_t num_done;                                //!< Number of finished tasks
+};
+
+ThreadPool::ThreadPool(size_t num_threads) :
+        stop(false) {
+
+    if (num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+
+    /* The calling thread is one of the workers */
+    for(size_t n = 1; n < num_threads; ++n)
+        workers.push_back(std::thread(&ThreadPool::Worker, this));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    start.notify_all();
+    for(size_t n = 0; n < workers.size(); ++n)
+        workers[n].join();
+}
+
+void ThreadPool::Run(const size_t num_tasks, const std::function<void(size_t)> &task) {
+
+    if (num_tasks == 0)
+        return;
+
+    if (workers.empty() || num_tasks == 1) {
+        for(size_t n = 0; n < num_tasks; ++n)
+            task(n);
+        return;
+    }
+
+    Wait(Submit(num_tasks, task));
+}
+
+ThreadPool::Job ThreadPool::Submit(const size_t num_tasks, const std::function<void(size_t)> &task) {
+
+    Job job = std::make_shared<Batch>();
+    job->task = task;
+    job->num_tasks = num_tasks;
+    job->next = 0;
+    job->num_done = 0;
+
+    if (num_tasks == 0)
+        return job;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(job);
+    }
+    start.notify_all();
+
+    return job;
+}
+
+void ThreadPool::Wait(const Job &job) {
+
+    Execute(*job);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finish.wait(lock, [&job] { return job->num_done == job->num_tasks; });
+}
+
+size_t ThreadPool::GetNumberOfThreads() const {
+    return workers.size() + 1;
+}
+
+void ThreadPool::Worker() {
+
+    while (true) {
+        Job current;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            start.wait(lock, [this] { return stop || !queue.empty(); });
+            /* Batches submitted before the pool is destroyed are still finished */
+            if (queue.empty())
+                return;
+            current = queue.front();
+        }
+        Execute(*current);
+    }
+}
+
+void ThreadPool::Execute(Batch &current) {
+
+    /* The batch is kept alive by its handle, so it can be touched after all tasks are taken */
+    size_t done = 0;
+    for(size_t n = current.next++; n < current.num_tasks; n = current.next++) {
+        current.task(n);
+        ++done;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    /* All tasks are taken, threads looking for work should skip the batch */
+    std::deque<Job>::iterator it = std::find_if(queue.begin(), queue.end(),
+            [&current](const Job &job) { return job.get() == &current; });
+    if (it != queue.end())
+        queue.erase(it);
+
+    if (done == 0)
+        return;
+
+    current.num_done += done;
+    if (current.num_done == current.num_tasks)
+        finish.notify_all();
+}
+
+}
@@ -0,0 +1,126 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+
+namespace xmlw {
+
+/*!
+ * \class ThreadPool
+ * \brief Fixed-size pool of worker threads
+ * The pool executes batches of independent tasks (e.g. compression of blocks of a data set). Tasks are taken
+ * from a shared counter, so faster threads simply take more of them. The calling thread takes part in the work
+ * as well, thus a pool with zero workers executes everything serially.
+ * Several batches may be in flight at once (see Submit()): idle threads take tasks of the oldest batch which still
+ * has some, so small batches don't leave threads waiting at a barrier and earlier batches are finished first.
+ */
+class ThreadPool {
+public:
+
+    /*!
+     * \brief Constructor
+     * @param num_threads Total number of threads including the calling one (0 - use all available cores)
+     */
+    explicit ThreadPool(size_t num_threads = 0);
+
+    /*!
+     * \brief Destructor, stops all workers
+     */
+    ~ThreadPool();
+
+    /*!
+     * \brief Executes task(n) for every n in [0, num_tasks) and returns when all of them are done
+     * @param num_tasks Number of tasks
+     * @param task Function to be called for each task index
+     */
+    void Run(const size_t num_tasks, const std::function<void(size_t)> &task);
+
+    /*!
+     * \brief Batch of tasks submitted by Submit()
+     */
+    struct Batch;
+
+    /*!
+     * \brief Handle of a submitted batch
+     */
+    typedef std::shared_ptr<Batch> Job;
+
+    /*!
+     * \brief Starts task(n) for every n in [0, num_tasks) and returns immediately
+     * The task is copied and kept alive until the batch is done.
+     * @param num_tasks Number of tasks
+     * @param task Function to be called for each task index
+     * @return Handle of the batch, see Wait()
+     */
+    Job Submit(const size_t num_tasks, const std::function<void(size_t)> &task);
+
+    /*!
+     * \brief Returns when all tasks of the batch are done, the calling thread executes its tasks meanwhile
+     * @param job Handle returned by Submit()
+     */
+    void Wait(const Job &job);
+
+    /*!
+     * \brief Returns total number of threads including the calling one
+     */
+    size_t GetNumberOfThreads() const;
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool &operator=(const ThreadPool&);
+
+    /*!
+     * \brief Main loop of a worker thread
+     */
+    void Worker();
+
+    /*!
+     * \brief Takes and executes tasks of the batch until there are no more left
+     */
+    void Execute(Batch &batch);
+
+private:
+    std::vector<std::thread> workers;               //!< Worker threads
+    std::mutex mutex;                               //!< Protects the queue and counters of finished tasks
+    std::condition_variable start;                  //!< Signals workers about a new batch
+    std::condition_variable finish;                 //!< Signals callers about finished batches
+    std::deque<Job> queue;                          //!< Batches with tasks which are not taken yet
+    bool stop;                                      //!< Signals workers to quit
+};
+
+} /* namespace xmlw */
+
+#endif /* THREADPOOL_H_ */
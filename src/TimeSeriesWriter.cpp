@@ -0,0 +1,139 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "TimeSeriesWriter.h"
+
+#include <iostream>
+#include <sstream>
+#include <limits>
+
+namespace xmlw {
+
+TimeSeriesWriter::TimeSeriesWriter(const std::string _collection_name) :
+        collection_name(_collection_name), skip_unchanged(false), static_geometry(false), has_previous(false),
+        previous_hash(0), num_data_sets(0), num_files(0), footer_position(0) {
+}
+
+void TimeSeriesWriter::SetSkipUnchanged(const bool _skip_unchanged) {
+    skip_unchanged = _skip_unchanged;
+    has_previous = false;
+}
+
+void TimeSeriesWriter::SetStaticGeometry(const bool _static_geometry) {
+    static_geometry = _static_geometry;
+    has_previous = false;
+}
+
+bool TimeSeriesWriter::Write(AppendedFileWriter &writer, const double time, const std::string file_name) {
+
+    uint64_t hash = 0;
+    if (skip_unchanged) {
+        hash = writer.Hash(static_geometry);
+        if (has_previous && hash == previous_hash)
+            return AddDataSet(time, previous_file);
+    }
+
+    has_previous = false;
+    if (!writer.Write(file_name))
+        return false;
+    ++num_files;
+
+    has_previous = skip_unchanged;
+    previous_hash = hash;
+    previous_file = file_name;
+
+    return AddDataSet(time, file_name);
+}
+
+bool TimeSeriesWriter::AddDataSet(const double time, const std::string file_name, const size_t part) {
+
+    std::fstream fs;
+
+    /* The first step creates the collection, later steps only overwrite its closing lines */
+    if (num_data_sets == 0) {
+        fs.open(collection_name.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+        if (fs.is_open()) {
+            Header(fs);
+            OpenVTKSection("Collection", fs);
+                OpenSection("Collection", fs);
+            footer_position = fs.tellp();
+        }
+    }
+    else {
+        fs.open(collection_name.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+        if (fs.is_open())
+            fs.seekp(footer_position);
+        SetIndentationLevel(2);
+    }
+
+    if (!fs.is_open()) {
+        std::cerr << "Error! Can't open file " << collection_name << " for writing. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    std::ostringstream timestep;
+    timestep.precision(std::numeric_limits<double>::max_digits10);
+    timestep << time;
+
+    OneLineSection("DataSet timestep=\"" + timestep.str() + "\" group=\"\" part=\"" + std::to_string(part)
+            + "\" file=\"" + RelativeName(file_name) + "\"", fs);
+    const std::streamoff position = fs.tellp();
+    WriteFooter(fs);
+
+    fs.close();
+    if (fs.fail())
+        return false;
+
+    footer_position = position;
+    ++num_data_sets;
+    return true;
+}
+
+void TimeSeriesWriter::WriteFooter(std::ostream &stream) {
+    CloseSection("Collection", stream);
+    CloseVTKSection(stream);
+}
+
+std::string TimeSeriesWriter::RelativeName(const std::string &file_name) const {
+    const size_t slash = collection_name.find_last_of('/');
+    if (slash == std::string::npos)
+        return file_name;
+    const std::string directory = collection_name.substr(0, slash + 1);
+    if (file_name.compare(0, directory.size(), directory) == 0)
+        return file_name.substr(directory.size());
+    return file_name;
+}
+
+size_t TimeSeriesWriter::GetNumberOfDataSets() const {
+    return num_data_sets;
+}
+
+size_t TimeSeriesWriter::GetNumberOfFiles() const {
+    return num_files;
+}
+
+}
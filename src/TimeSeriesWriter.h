@@ -0,0 +1,150 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef TIMESERIESWRITER_H_
+#define TIMESERIESWRITER_H_
+
+#include <string>
+#include <cstdint>
+#include <fstream>
+
+#include "XMLWriter.h"
+#include "AppendedFileWriter.h"
+
+namespace xmlw {
+
+/*!
+ * \class TimeSeriesWriter
+ * \brief Writes files of a transient simulation and keeps the '.pvd' collection listing them up to date
+ * Each step is written by AppendedFileWriter (or any class derived from it) and added to the collection:
+ *   <VTKFile type="Collection" version="0.1" byte_order="LittleEndian">
+ *   <Collection>
+ *   <DataSet timestep="0.5" group="" part="0" file="step_1.vtu"/>
+ *   ...
+ *   </Collection>
+ *   </VTKFile>
+ * The collection is never rewritten: a new 'DataSet' entry overwrites the closing lines, which are written again
+ * right after it, so the collection is valid after every step and the cost of a step doesn't grow with the number
+ * of steps.
+ * Every file is self-contained: VTK XML files can't refer to data sets of other files, so each step contains the
+ * geometry and the collection doesn't reduce the volume of steps which change any field.
+ * Optionally (see SetSkipUnchanged()) the writer is hashed before a step is written (see AppendedFileWriter::Hash()).
+ * If the file would be identical to the previously written one (e.g. a converged steady state), no new file is
+ * written and the collection refers to the previous file. Hashing costs an additional pass over all data sets of
+ * every step, so it is disabled by default. If the geometry is known to be static (see SetStaticGeometry()) only
+ * its description is hashed, which saves the pass over the largest data sets of the step.
+ * Typical usage:
+ *   xmlw::TimeSeriesWriter series("result.pvd");
+ *   for(each step) {
+ *       compute();
+ *       xmlw::UnstructuredGridWriter writer;
+ *       ... register data sets ...
+ *       series.Write(writer, time, "result_" + std::to_string(step) + ".vtu");
+ *   }
+ */
+class TimeSeriesWriter : public VTK_XML_Writer {
+public:
+
+    /*!
+     * \brief Constructor, the collection file is created by the first step
+     * @param _collection_name Name of the collection file (.pvd)
+     */
+    explicit TimeSeriesWriter(const std::string _collection_name);
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~TimeSeriesWriter() { }
+
+    /*!
+     * \brief Enables detection of unchanged steps (disabled by default)
+     * @param _skip_unchanged True to reuse the previous file if the step doesn't change it
+     */
+    void SetSkipUnchanged(const bool _skip_unchanged);
+
+    /*!
+     * \brief Declares the geometry ("Points", "Coordinates" and "Cells") as static, its contents are not hashed
+     * Affects only detection of unchanged steps (see SetSkipUnchanged()), the geometry is still written to every file.
+     * \warning Changes of the geometry are not detected, a step which changes only the geometry is not written
+     * @param _static_geometry True if the geometry is the same in all steps
+     */
+    void SetStaticGeometry(const bool _static_geometry);
+
+    /*!
+     * \brief Writes down the step (unless it repeats the previous file) and adds it to the collection
+     * @param writer Writer with all data sets of the step registered
+     * @param time Time of the step
+     * @param file_name Name of the file of the step
+     * @return True if the file and the collection were successfully written
+     */
+    bool Write(AppendedFileWriter &writer, const double time, const std::string file_name);
+
+    /*!
+     * \brief Adds a file written elsewhere (e.g. the master file of ParallelWriter) to the collection
+     * @param time Time of the step
+     * @param file_name Name of the file
+     * @param part Index of the part of the step (several files of the same step have different parts)
+     * @return True if the collection was successfully written
+     */
+    bool AddDataSet(const double time, const std::string file_name, const size_t part = 0);
+
+    /*!
+     * \brief Returns number of data sets in the collection
+     */
+    size_t GetNumberOfDataSets() const;
+
+    /*!
+     * \brief Returns number of files actually written by Write()
+     */
+    size_t GetNumberOfFiles() const;
+
+private:
+    /*!
+     * \brief Returns name of the file relative to the directory of the collection (if the file is there)
+     */
+    std::string RelativeName(const std::string &file_name) const;
+
+    /*!
+     * \brief Writes down the closing lines of the collection at the current position
+     * @param stream Output stream
+     */
+    void WriteFooter(std::ostream &stream);
+
+private:
+    std::string collection_name;        //!< Name of the collection file
+    bool skip_unchanged;                //!< True if unchanged steps reuse the previous file
+    bool static_geometry;               //!< True if contents of the geometry are not hashed
+    bool has_previous;                  //!< True if the hash of the previous file is known
+    uint64_t previous_hash;             //!< Hash of the previously written file
+    std::string previous_file;          //!< Name of the previously written file
+    size_t num_data_sets;               //!< Number of data sets in the collection
+    size_t num_files;                   //!< Number of written files
+    std::streamoff footer_position;     //!< Position of the closing lines in the collection file
+};
+
+} /* namespace xmlw */
+
+#endif /* TIMESERIESWRITER_H_ */
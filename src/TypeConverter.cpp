@@ -0,0 +1,156 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "TypeConverter.h"
+
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xmlw {
+
+/* Number of values converted at once */
+static const size_t conversion_chunk = 2048;
+
+/*
+ * Generates Bytes [offset, offset + size) of the converted data set. Values cut by the borders
+ * of the range are converted completely and copied partially.
+ */
+template<typename To, typename Convert>
+static void FillConverted(const char *data, const FillFunction &fill, size_t offset, size_t size, char *out,
+        const Convert &convert) {
+
+    double in[conversion_chunk];
+    To converted[conversion_chunk];
+
+    size_t value = offset / sizeof(To);
+    size_t skip = offset % sizeof(To);
+    const size_t last = (offset + size + sizeof(To) - 1) / sizeof(To);
+
+    while (value < last) {
+        const size_t n = (last - value < conversion_chunk) ? last - value : conversion_chunk;
+        const double *src = in;
+
+        if (data != NULL)
+            src = (const double*)data + value;
+        else
+            fill(value * sizeof(double), n * sizeof(double), (char*)in);
+
+        convert(src, n, converted);
+
+        const size_t bytes = (n * sizeof(To) - skip < size) ? n * sizeof(To) - skip : size;
+        std::memcpy(out, (const char*)converted + skip, bytes);
+        out += bytes;
+        size -= bytes;
+        skip = 0;
+        value += n;
+    }
+}
+
+void TypeConverter::ToFloat32(const double *in, const size_t size, float *out) {
+
+    size_t n = 0;
+
+#if defined(__SSE2__)
+    for(; n + 4 <= size; n += 4) {
+        const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(in + n));
+        const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(in + n + 2));
+        _mm_storeu_ps(out + n, _mm_movelh_ps(lo, hi));
+    }
+#endif
+
+    for(; n < size; ++n)
+        out[n] = (float)in[n];
+}
+
+void TypeConverter::ToUInt16(const double *in, const size_t size, const double shift, const double scale,
+        uint16_t *out) {
+
+    const double inv_scale = 1. / scale;
+
+    for(size_t n = 0; n < size; ++n) {
+        const double q = (in[n] - shift) * inv_scale + 0.5;
+        /* Comparisons are false for NaN, so it goes to 0 */
+        out[n] = (q >= 65535.) ? 65535 : (q > 0.) ? (uint16_t)q : 0;
+    }
+}
+
+void TypeConverter::FindRange(const char *data, const FillFunction &fill, const size_t size,
+        double &min, double &max) {
+
+    double in[conversion_chunk];
+    bool found = false;
+
+    min = 0.;
+    max = 0.;
+
+    for(size_t value = 0; value < size; value += conversion_chunk) {
+        const size_t n = (size - value < conversion_chunk) ? size - value : conversion_chunk;
+        const double *src = in;
+
+        if (data != NULL)
+            src = (const double*)data + value;
+        else
+            fill(value * sizeof(double), n * sizeof(double), (char*)in);
+
+        for(size_t i = 0; i < n; ++i) {
+            if (!std::isfinite(src[i]))
+                continue;
+            if (!found) {
+                min = src[i];
+                max = src[i];
+                found = true;
+            }
+            if (src[i] < min)
+                min = src[i];
+            if (src[i] > max)
+                max = src[i];
+        }
+    }
+}
+
+FillFunction TypeConverter::Float32Fill(const char *data, const FillFunction &fill) {
+    return [data, fill](size_t offset, size_t size, char *out) {
+        FillConverted<float>(data, fill, offset, size, out, [](const double *in, size_t n, float *converted) {
+            ToFloat32(in, n, converted);
+        });
+    };
+}
+
+FillFunction TypeConverter::UInt16Fill(const char *data, const FillFunction &fill, const double shift,
+        const double scale) {
+    return [data, fill, shift, scale](size_t offset, size_t size, char *out) {
+        FillConverted<uint16_t>(data, fill, offset, size, out,
+                [shift, scale](const double *in, size_t n, uint16_t *converted) {
+            ToUInt16(in, n, shift, scale, converted);
+        });
+    };
+}
+
+}
@@ -0,0 +1,97 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef TYPECONVERTER_H_
+#define TYPECONVERTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ArrayViews.h"
+
+namespace xmlw {
+
+/*!
+ * \class TypeConverter
+ * \brief Converts Float64 data sets into smaller types while they are written
+ * Two conversions are supported: rounding to Float32 and quantization to UInt16, where a value is stored as
+ * q = round((value - shift) / scale) and restored as value = q * scale + shift. Shift and scale are chosen to map
+ * the range of the data set onto [0, 65535]. Data sets are converted by chunks of a bounded size, so no converted
+ * copy of the whole data set is made.
+ */
+class TypeConverter {
+public:
+
+    /*!
+     * \brief Rounds Float64 values to Float32
+     * @param in Input values
+     * @param size Number of values
+     * @param out Output values
+     */
+    static void ToFloat32(const double *in, const size_t size, float *out);
+
+    /*!
+     * \brief Quantizes Float64 values to UInt16, values out of range are clamped
+     * @param in Input values
+     * @param size Number of values
+     * @param shift Value corresponding to 0
+     * @param scale Difference of values corresponding to consecutive integers
+     * @param out Output values
+     */
+    static void ToUInt16(const double *in, const size_t size, const double shift, const double scale,
+            uint16_t *out);
+
+    /*!
+     * \brief Finds the minimum and the maximum of a Float64 data set (infinite and NaN values are ignored)
+     * @param data Pointer to the data set (NULL if it is generated on the fly)
+     * @param fill Function generating the data set (used only if data is NULL)
+     * @param size Number of values
+     * @param min Minimum value (0 for empty data sets)
+     * @param max Maximum value (0 for empty data sets)
+     */
+    static void FindRange(const char *data, const FillFunction &fill, const size_t size, double &min, double &max);
+
+    /*!
+     * \brief Returns function generating the data set converted to Float32
+     * @param data Pointer to the Float64 data set (NULL if it is generated on the fly)
+     * @param fill Function generating the Float64 data set (used only if data is NULL)
+     */
+    static FillFunction Float32Fill(const char *data, const FillFunction &fill);
+
+    /*!
+     * \brief Returns function generating the data set quantized to UInt16
+     * @param data Pointer to the Float64 data set (NULL if it is generated on the fly)
+     * @param fill Function generating the Float64 data set (used only if data is NULL)
+     * @param shift Value corresponding to 0
+     * @param scale Difference of values corresponding to consecutive integers
+     */
+    static FillFunction UInt16Fill(const char *data, const FillFunction &fill, const double shift,
+            const double scale);
+};
+
+} /* namespace xmlw */
+
+#endif /* TYPECONVERTER_H_ */
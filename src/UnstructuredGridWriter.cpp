@@ -0,0 +1,188 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "UnstructuredGridWriter.h"
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+
+namespace xmlw {
+
+/*
+ * Generates 'offsets', 'types' or 'HigherOrderDegrees' (three values per cell) of cells described
+ * by blocks of cells of the same type
+ */
+template<typename T>
+class CellBlocksView {
+public:
+    enum Mode { OFFSETS, TYPES, DEGREES };
+
+    CellBlocksView(const std::vector<UnstructuredGridWriter::CellBlock> &blocks, const Mode _mode) :
+            mode(_mode) {
+        size_t cell = 0, node = 0;
+        for(size_t b = 0; b < blocks.size(); ++b) {
+            if (blocks[b].num_cells == 0)
+                continue;
+            first_cell.push_back(cell);
+            first_node.push_back(node);
+            nodes.push_back(blocks[b].GetNumberOfNodes());
+            types.push_back(blocks[b].type);
+            orders.push_back(blocks[b].order);
+            cell += blocks[b].num_cells;
+            node += blocks[b].num_cells * blocks[b].GetNumberOfNodes();
+        }
+        first_cell.push_back(cell);
+    }
+
+    void Gather(const size_t first, const size_t count, char *out) const {
+        const size_t values_per_cell = (mode == DEGREES) ? 3 : 1;
+        size_t b = std::upper_bound(first_cell.begin(), first_cell.end(), first / values_per_cell)
+                - first_cell.begin() - 1;
+
+        for(size_t v = first; v < first + count; ++v) {
+            const size_t c = v / values_per_cell;
+            while (c >= first_cell[b + 1])
+                ++b;
+
+            T value;
+            if (mode == OFFSETS)
+                value = T(first_node[b] + (c - first_cell[b] + 1) * nodes[b]);
+            else if (mode == TYPES)
+                value = T(types[b]);
+            else
+                value = T(orders[b]);
+
+            std::memcpy(out, &value, sizeof(T));
+            out += sizeof(T);
+        }
+    }
+
+    void Fill(const size_t offset, const size_t size, char *out) const {
+        FillValues<T>(*this, offset, size, out);
+    }
+
+private:
+    Mode mode;                          //!< Array to be generated
+    std::vector<size_t> first_cell;     //!< Index of the first cell of each block (plus the total number)
+    std::vector<size_t> first_node;     //!< Index of the first node of each block in the connectivity
+    std::vector<size_t> nodes;          //!< Number of nodes of each cell of the block
+    std::vector<uint8_t> types;         //!< Type of cells of the block
+    std::vector<size_t> orders;         //!< Order of cells of the block
+};
+
+UnstructuredGridWriter::UnstructuredGridWriter() : AppendedFileWriter("UnstructuredGrid"),
+        num_points(0), num_cells(0) {
+    UpdatePiece();
+}
+
+UnstructuredGridWriter *UnstructuredGridWriter::Clone() const {
+    return new UnstructuredGridWriter(*this);
+}
+
+size_t UnstructuredGridWriter::GetNumberOfPoints() const {
+    return num_points;
+}
+
+size_t UnstructuredGridWriter::GetNumberOfCells() const {
+    return num_cells;
+}
+
+void UnstructuredGridWriter::RemoveSection(const std::string section) {
+    for(size_t n = arrays.size(); n > 0; --n)
+        if (arrays[n - 1].section == section)
+            arrays.erase(arrays.begin() + (n - 1));
+}
+
+void UnstructuredGridWriter::RemoveCells() {
+    RemoveSection("Cells");
+    for(size_t n = arrays.size(); n > 0; --n)
+        if (arrays[n - 1].section == "CellData" && arrays[n - 1].name == "HigherOrderDegrees")
+            arrays.erase(arrays.begin() + (n - 1));
+    num_cells = 0;
+}
+
+bool UnstructuredGridWriter::RegisterCellBlocks(const std::vector<CellBlock> &blocks,
+        const size_t connectivity_size, const bool wide) {
+
+    size_t total_cells = 0, total_nodes = 0;
+    bool high_order = false;
+
+    for(size_t b = 0; b < blocks.size(); ++b) {
+        const size_t num_nodes = blocks[b].GetNumberOfNodes();
+        high_order = high_order || blocks[b].order != 0;
+        if (num_nodes == 0) {
+            std::cerr << "Error! Number of nodes of cells of type " << blocks[b].type << " should be given. See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            return false;
+        }
+        total_cells += blocks[b].num_cells;
+        total_nodes += blocks[b].num_cells * num_nodes;
+    }
+
+    if (total_nodes != connectivity_size) {
+        std::cerr << "Error! Cells refer to " << total_nodes << " nodes, while the connectivity has "
+                << connectivity_size << " entries. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    if (wide || total_nodes > (size_t)std::numeric_limits<int32_t>::max()) {
+        const CellBlocksView<int64_t> offsets(blocks, CellBlocksView<int64_t>::OFFSETS);
+        Register("Cells", "offsets", "Int64", NULL, total_cells * sizeof(int64_t), 1, std::shared_ptr<void>(),
+                [offsets](size_t offset, size_t size, char *out) { offsets.Fill(offset, size, out); });
+    }
+    else {
+        const CellBlocksView<int32_t> offsets(blocks, CellBlocksView<int32_t>::OFFSETS);
+        Register("Cells", "offsets", "Int32", NULL, total_cells * sizeof(int32_t), 1, std::shared_ptr<void>(),
+                [offsets](size_t offset, size_t size, char *out) { offsets.Fill(offset, size, out); });
+    }
+
+    const CellBlocksView<uint8_t> types(blocks, CellBlocksView<uint8_t>::TYPES);
+    Register("Cells", "types", "UInt8", NULL, total_cells * sizeof(uint8_t), 1, std::shared_ptr<void>(),
+            [types](size_t offset, size_t size, char *out) { types.Fill(offset, size, out); });
+
+    if (high_order) {
+        const CellBlocksView<uint8_t> degrees(blocks, CellBlocksView<uint8_t>::DEGREES);
+        Register("CellData", "HigherOrderDegrees", "UInt8", NULL, 3 * total_cells * sizeof(uint8_t), 3,
+                std::shared_ptr<void>(),
+                [degrees](size_t offset, size_t size, char *out) { degrees.Fill(offset, size, out); });
+    }
+
+    num_cells = total_cells;
+    return true;
+}
+
+void UnstructuredGridWriter::RegisterPolyhedronTypes() {
+    Register("Cells", "types", "UInt8", NULL, num_cells * sizeof(uint8_t), 1, std::shared_ptr<void>(),
+            [](size_t, size_t size, char *out) { std::memset(out, VTK_POLYHEDRON, size); });
+}
+
+void UnstructuredGridWriter::UpdatePiece() {
+    SetPiece(num_points, num_cells);
+}
+
+}
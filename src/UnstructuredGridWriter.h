@@ -0,0 +1,209 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef UNSTRUCTUREDGRIDWRITER_H_
+#define UNSTRUCTUREDGRIDWRITER_H_
+
+#include <string>
+#include <vector>
+
+#include "AppendedFileWriter.h"
+#include "VTKCellType.h"
+
+namespace xmlw {
+
+/*!
+ * \class UnstructuredGridWriter
+ * \brief Writes unstructured grids into .vtu files
+ * Cells are described by the connectivity array and a list of blocks of cells of the same type (run-length
+ * description of the mesh), so 'offsets' and 'types' arrays are generated on the fly while the file is written
+ * and never stored in memory. Mesh of a single cell type is a single block. Connectivity can be of any integer
+ * type, 'offsets' are written as Int64 if the connectivity is 64-bit or has more than 2^31 - 1 entries. Numbers
+ * of points and cells of the piece are set automatically.
+ * High-order (Lagrange and Bezier) cells are described by blocks with the order of cells set, the cell data set
+ * 'HigherOrderDegrees' is then generated as well. Meshes of arbitrary polyhedra are described by a compact list of
+ * faces (see SetPolyhedra()), the connectivity, 'faces' and 'faceoffsets' arrays required by VTK are generated.
+ * Example:
+ *   xmlw::UnstructuredGridWriter writer;
+ *   writer.SetPoints(points);                           // x, y, z of every point
+ *   writer.SetCells(xmlw::VTK_HEXAHEDRON, connectivity); // 8 nodes per cell
+ *   writer.AddArray("CellData", "pressure", pressure);
+ *   writer.Write("mesh.vtu");
+ */
+class UnstructuredGridWriter : public AppendedFileWriter {
+public:
+
+    /*!
+     * \brief Block of consecutive cells of the same type
+     */
+    struct CellBlock {
+        VTKCellType type;           //!< Type of cells
+        size_t num_cells;           //!< Number of cells in the block
+        size_t num_nodes;           //!< Number of nodes of each cell (0 - defined by the type and the order)
+        size_t order;               //!< Order of Lagrange and Bezier cells (0 for other cells)
+
+        CellBlock(const VTKCellType _type, const size_t _num_cells, const size_t _num_nodes = 0,
+                const size_t _order = 0) :
+            type(_type), num_cells(_num_cells), num_nodes(_num_nodes), order(_order) { }
+
+        /*!
+         * \brief Returns number of nodes of each cell, 0 if it is unknown
+         */
+        size_t GetNumberOfNodes() const {
+            if (num_nodes != 0)
+                return num_nodes;
+            return order != 0 ? VTKNumberOfNodes(type, order) : VTKNumberOfNodes(type);
+        }
+    };
+
+    /*!
+     * \brief Constructor
+     */
+    UnstructuredGridWriter();
+
+    /*!
+     * \brief Deafult Destructor
+     */
+    virtual ~UnstructuredGridWriter() { }
+
+    /*!
+     * \brief Returns copy of the writer, data sets are referenced, not copied (see AppendedFileWriter::Clone())
+     */
+    virtual UnstructuredGridWriter *Clone() const;
+
+    /*!
+     * \brief Registers coordinates of points, previously registered points are replaced
+     * @param points Coordinates (three values or a structure of three values per point), should be compatible
+     * with STL library
+     */
+    template<typename Data>
+    inline void SetPoints(Data &points);
+    template<typename T>
+    inline void SetPoints(const StridedView<T> points);
+    template<typename T>
+    inline void SetPoints(const SoAView<T> points);
+
+    /*!
+     * \brief Registers cells of a single type, previously registered cells are replaced
+     * @param type Type of cells
+     * @param connectivity Indices of nodes of all cells, should be compatible with STL library
+     * @param num_nodes Number of nodes of each cell (0 - defined by the type)
+     */
+    template<typename Data>
+    inline void SetCells(const VTKCellType type, Data &connectivity, const size_t num_nodes = 0);
+
+    /*!
+     * \brief Registers cells described by blocks of cells of the same type, previously registered cells are replaced
+     * @param blocks Blocks of cells in the order of their appearance in the connectivity
+     * @param connectivity Indices of nodes of all cells, should be compatible with STL library
+     */
+    template<typename Data>
+    inline void SetCells(const std::vector<CellBlock> &blocks, Data &connectivity);
+
+    /*!
+     * \brief Registers cells described by explicit arrays, previously registered cells are replaced
+     * @param connectivity Indices of nodes of all cells
+     * @param offsets Index of the end of each cell in the connectivity
+     * @param types Type of each cell (UInt8)
+     */
+    template<typename Connectivity, typename Offsets, typename Types>
+    inline void SetCells(Connectivity &connectivity, Offsets &offsets, Types &types);
+
+    /*!
+     * \brief Registers cells described by explicit arrays including polyhedra, previously registered cells are replaced
+     * @param connectivity Indices of nodes of all cells
+     * @param offsets Index of the end of each cell in the connectivity
+     * @param types Type of each cell (UInt8)
+     * @param faces Description of faces of polyhedra: number of faces followed by the number of nodes and indices of
+     * nodes of each face
+     * @param faceoffsets Index of the end of each cell in faces (-1 for cells which are not polyhedra)
+     */
+    template<typename Connectivity, typename Offsets, typename Types, typename Faces, typename FaceOffsets>
+    inline void SetCells(Connectivity &connectivity, Offsets &offsets, Types &types, Faces &faces,
+            FaceOffsets &faceoffsets);
+
+    /*!
+     * \brief Registers mesh of arbitrary polyhedra, previously registered cells are replaced
+     * Nodes of each cell, 'offsets', 'faces' and 'faceoffsets' are produced from the compact description. Only
+     * per-cell offsets are kept in memory, nodes of cells and faces are generated while the file is written. All
+     * arrays should be compatible with STL library and stay alive and unchanged until the file is written.
+     * @param faces_per_cell Number of faces of each cell
+     * @param face_sizes Number of nodes of each face (faces of all cells one after another)
+     * @param face_nodes Indices of nodes of all faces one after another
+     */
+    template<typename FacesPerCell, typename FaceSizes, typename FaceNodes>
+    inline void SetPolyhedra(FacesPerCell &faces_per_cell, FaceSizes &face_sizes, FaceNodes &face_nodes);
+
+    /*!
+     * \brief Returns number of points
+     */
+    size_t GetNumberOfPoints() const;
+
+    /*!
+     * \brief Returns number of cells
+     */
+    size_t GetNumberOfCells() const;
+
+protected:
+    /*!
+     * \brief Removes all registered data sets of the section
+     */
+    void RemoveSection(const std::string section);
+
+    /*!
+     * \brief Removes all registered cells
+     */
+    void RemoveCells();
+
+    /*!
+     * \brief Registers generated 'offsets' and 'types', the connectivity should be registered before
+     * @param blocks Blocks of cells
+     * @param connectivity_size Number of entries in the connectivity
+     * @param wide True if the connectivity is 64-bit
+     * @return False if blocks don't match the connectivity
+     */
+    bool RegisterCellBlocks(const std::vector<CellBlock> &blocks, const size_t connectivity_size, const bool wide);
+
+    /*!
+     * \brief Registers generated 'types' of a mesh of polyhedra
+     */
+    void RegisterPolyhedronTypes();
+
+    /*!
+     * \brief Updates numbers of points and cells of the piece
+     */
+    void UpdatePiece();
+
+protected:
+    size_t num_points;      //!< Number of points
+    size_t num_cells;       //!< Number of cells
+};
+
+} /* namespace xmlw */
+
+#include "UnstructuredGridWriter.inl"
+
+#endif /* UNSTRUCTUREDGRIDWRITER_H_ */
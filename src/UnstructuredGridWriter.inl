@@ -0,0 +1,241 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef UNSTRUCTUREDGRIDWRITER_INL_
+#define UNSTRUCTUREDGRIDWRITER_INL_
+
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace xmlw {
+
+/*
+ * Generates nodes of cells or the 'faces' array of a mesh of polyhedra from the compact list of faces.
+ * Only per-cell positions are stored, values of a cell are produced when the cell is reached.
+ */
+template<typename C, typename S, typename N>
+class PolyhedraView {
+public:
+    enum Mode { CONNECTIVITY, FACES };
+
+    /*!
+     * \brief Per-cell positions shared by all views of the mesh
+     */
+    struct Index {
+        std::shared_ptr<std::vector<int64_t> > offsets;      //!< End of each cell in the connectivity
+        std::shared_ptr<std::vector<int64_t> > faceoffsets;  //!< End of each cell in 'faces'
+        std::vector<size_t> first_face;                     //!< Index of the first face of each cell
+        std::vector<size_t> first_node;                     //!< Index of the first node of the first face
+    };
+
+    PolyhedraView(const C *_faces_per_cell, const S *_face_sizes, const N *_face_nodes,
+            const std::shared_ptr<const Index> _index, const Mode _mode) :
+            faces_per_cell(_faces_per_cell), face_sizes(_face_sizes), face_nodes(_face_nodes),
+            index(_index), mode(_mode) {
+    }
+
+    void Gather(const size_t first, const size_t count, char *out) const {
+        const std::vector<int64_t> &ends = (mode == CONNECTIVITY) ? *index->offsets : *index->faceoffsets;
+        std::vector<int64_t> values;
+        size_t c = std::upper_bound(ends.begin(), ends.end(), (int64_t)first) - ends.begin();
+        size_t v = first;
+
+        while (v < first + count) {
+            CellValues(c, values);
+            const size_t start = (c != 0) ? ends[c - 1] : 0;
+            for(size_t i = v - start; i < values.size() && v < first + count; ++i, ++v) {
+                std::memcpy(out, &values[i], sizeof(int64_t));
+                out += sizeof(int64_t);
+            }
+            ++c;
+        }
+    }
+
+    void Fill(const size_t offset, const size_t size, char *out) const {
+        FillValues<int64_t>(*this, offset, size, out);
+    }
+
+    /*!
+     * \brief Produces unique nodes of the cell (in the order of appearance) or its description in 'faces'
+     */
+    void CellValues(const size_t c, std::vector<int64_t> &values) const {
+        size_t node = index->first_node[c];
+        const size_t face_end = index->first_face[c] + faces_per_cell[c];
+
+        values.clear();
+        if (mode == FACES)
+            values.push_back(faces_per_cell[c]);
+
+        for(size_t f = index->first_face[c]; f < face_end; ++f) {
+            if (mode == FACES)
+                values.push_back(face_sizes[f]);
+            for(size_t n = node; n < node + face_sizes[f]; ++n) {
+                const int64_t id = face_nodes[n];
+                if (mode == FACES || std::find(values.begin(), values.end(), id) == values.end())
+                    values.push_back(id);
+            }
+            node += face_sizes[f];
+        }
+    }
+
+private:
+    const C *faces_per_cell;                //!< Number of faces of each cell
+    const S *face_sizes;                    //!< Number of nodes of each face
+    const N *face_nodes;                    //!< Nodes of all faces
+    std::shared_ptr<const Index> index;     //!< Per-cell positions
+    Mode mode;                              //!< Array to be generated
+};
+
+template<typename Data>
+inline void UnstructuredGridWriter::SetPoints(Data &points) {
+    typedef typename Data::value_type value_type;
+    RemoveSection("Points");
+    AddArray("Points", "Points", points, 3);
+    num_points = points.size() * VTKNumberOfComponents<value_type>() / 3;
+    UpdatePiece();
+}
+
+template<typename T>
+inline void UnstructuredGridWriter::SetPoints(const StridedView<T> points) {
+    RemoveSection("Points");
+    AddArray("Points", "Points", points);
+    num_points = points.size() / 3;
+    UpdatePiece();
+}
+
+template<typename T>
+inline void UnstructuredGridWriter::SetPoints(const SoAView<T> points) {
+    RemoveSection("Points");
+    AddArray("Points", "Points", points);
+    num_points = points.size() / 3;
+    UpdatePiece();
+}
+
+template<typename Data>
+inline void UnstructuredGridWriter::SetCells(const VTKCellType type, Data &connectivity, const size_t num_nodes) {
+    const size_t nodes = (num_nodes != 0) ? num_nodes : VTKNumberOfNodes(type);
+    SetCells(std::vector<CellBlock>(1, CellBlock(type, nodes != 0 ? connectivity.size() / nodes : 0, num_nodes)),
+            connectivity);
+}
+
+template<typename Data>
+inline void UnstructuredGridWriter::SetCells(const std::vector<CellBlock> &blocks, Data &connectivity) {
+    typedef typename Data::value_type value_type;
+
+    RemoveCells();
+    AddArray("Cells", "connectivity", connectivity);
+    if (!RegisterCellBlocks(blocks, connectivity.size(), sizeof(value_type) == sizeof(int64_t)))
+        RemoveCells();
+    UpdatePiece();
+}
+
+template<typename Connectivity, typename Offsets, typename Types>
+inline void UnstructuredGridWriter::SetCells(Connectivity &connectivity, Offsets &offsets, Types &types) {
+    RemoveCells();
+    AddArray("Cells", "connectivity", connectivity);
+    AddArray("Cells", "offsets", offsets);
+    AddArray("Cells", "types", types);
+    num_cells = types.size();
+    UpdatePiece();
+}
+
+template<typename Connectivity, typename Offsets, typename Types, typename Faces, typename FaceOffsets>
+inline void UnstructuredGridWriter::SetCells(Connectivity &connectivity, Offsets &offsets, Types &types,
+        Faces &faces, FaceOffsets &faceoffsets) {
+    SetCells(connectivity, offsets, types);
+    AddArray("Cells", "faces", faces);
+    AddArray("Cells", "faceoffsets", faceoffsets);
+}
+
+template<typename FacesPerCell, typename FaceSizes, typename FaceNodes>
+inline void UnstructuredGridWriter::SetPolyhedra(FacesPerCell &faces_per_cell, FaceSizes &face_sizes,
+        FaceNodes &face_nodes) {
+    typedef PolyhedraView<typename FacesPerCell::value_type, typename FaceSizes::value_type,
+            typename FaceNodes::value_type> View;
+
+    RemoveCells();
+
+    const size_t cells = faces_per_cell.size();
+    std::shared_ptr<typename View::Index> index = std::make_shared<typename View::Index>();
+    index->offsets = std::make_shared<std::vector<int64_t> >(cells);
+    index->faceoffsets = std::make_shared<std::vector<int64_t> >(cells);
+    index->first_face.resize(cells);
+    index->first_node.resize(cells);
+
+    /* Positions of cells are found in a single pass over faces */
+    View connectivity(faces_per_cell.data(), face_sizes.data(), face_nodes.data(), index, View::CONNECTIVITY);
+    std::vector<int64_t> values;
+    size_t face = 0, node = 0;
+    int64_t connectivity_size = 0, faces_size = 0;
+
+    for(size_t c = 0; c < cells; ++c) {
+        index->first_face[c] = face;
+        index->first_node[c] = node;
+
+        const size_t num_faces = faces_per_cell[c];
+        if (face + num_faces > face_sizes.size())
+            break;
+        for(size_t f = face; f < face + num_faces; ++f)
+            node += face_sizes[f];
+        if (node > face_nodes.size())
+            break;
+
+        connectivity.CellValues(c, values);
+        connectivity_size += values.size();
+        faces_size += 1 + num_faces + (node - index->first_node[c]);
+        (*index->offsets)[c] = connectivity_size;
+        (*index->faceoffsets)[c] = faces_size;
+        face += num_faces;
+    }
+
+    if (face != face_sizes.size() || node != face_nodes.size()) {
+        std::cerr << "Error! Faces of polyhedra don't match their sizes and nodes. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        UpdatePiece();
+        return;
+    }
+
+    const View faces(faces_per_cell.data(), face_sizes.data(), face_nodes.data(), index, View::FACES);
+
+    Register("Cells", "connectivity", "Int64", NULL, connectivity_size * sizeof(int64_t), 1,
+            std::shared_ptr<void>(),
+            [connectivity](size_t offset, size_t size, char *out) { connectivity.Fill(offset, size, out); });
+    Register("Cells", "offsets", "Int64", (const char*)index->offsets->data(), cells * sizeof(int64_t), 1,
+            index->offsets);
+    num_cells = cells;
+    RegisterPolyhedronTypes();
+    Register("Cells", "faces", "Int64", NULL, faces_size * sizeof(int64_t), 1, std::shared_ptr<void>(),
+            [faces](size_t offset, size_t size, char *out) { faces.Fill(offset, size, out); });
+    Register("Cells", "faceoffsets", "Int64", (const char*)index->faceoffsets->data(), cells * sizeof(int64_t), 1,
+            index->faceoffsets);
+
+    UpdatePiece();
+}
+
+}
+
+#endif /* UNSTRUCTUREDGRIDWRITER_INL_ */
@@ -0,0 +1,151 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef VTKCELLTYPE_H_
+#define VTKCELLTYPE_H_
+
+#include <cstddef>
+
+namespace xmlw {
+
+/*!
+ * \brief Types of cells of unstructured grids (values are the same as in vtkCellType.h)
+ */
+enum VTKCellType {
+    VTK_EMPTY_CELL = 0,
+    VTK_VERTEX = 1,
+    VTK_POLY_VERTEX = 2,
+    VTK_LINE = 3,
+    VTK_POLY_LINE = 4,
+    VTK_TRIANGLE = 5,
+    VTK_TRIANGLE_STRIP = 6,
+    VTK_POLYGON = 7,
+    VTK_PIXEL = 8,
+    VTK_QUAD = 9,
+    VTK_TETRA = 10,
+    VTK_VOXEL = 11,
+    VTK_HEXAHEDRON = 12,
+    VTK_WEDGE = 13,
+    VTK_PYRAMID = 14,
+    VTK_PENTAGONAL_PRISM = 15,
+    VTK_HEXAGONAL_PRISM = 16,
+    VTK_QUADRATIC_EDGE = 21,
+    VTK_QUADRATIC_TRIANGLE = 22,
+    VTK_QUADRATIC_QUAD = 23,
+    VTK_QUADRATIC_TETRA = 24,
+    VTK_QUADRATIC_HEXAHEDRON = 25,
+    VTK_QUADRATIC_WEDGE = 26,
+    VTK_QUADRATIC_PYRAMID = 27,
+    VTK_BIQUADRATIC_QUAD = 28,
+    VTK_TRIQUADRATIC_HEXAHEDRON = 29,
+    VTK_QUADRATIC_LINEAR_QUAD = 30,
+    VTK_QUADRATIC_LINEAR_WEDGE = 31,
+    VTK_BIQUADRATIC_QUADRATIC_WEDGE = 32,
+    VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON = 33,
+    VTK_BIQUADRATIC_TRIANGLE = 34,
+    VTK_CUBIC_LINE = 35,
+    VTK_QUADRATIC_POLYGON = 36,
+    VTK_TRIQUADRATIC_PYRAMID = 37,
+    VTK_POLYHEDRON = 42,
+    VTK_LAGRANGE_CURVE = 68,
+    VTK_LAGRANGE_TRIANGLE = 69,
+    VTK_LAGRANGE_QUADRILATERAL = 70,
+    VTK_LAGRANGE_TETRAHEDRON = 71,
+    VTK_LAGRANGE_HEXAHEDRON = 72,
+    VTK_LAGRANGE_WEDGE = 73,
+    VTK_LAGRANGE_PYRAMID = 74,
+    VTK_BEZIER_CURVE = 75,
+    VTK_BEZIER_TRIANGLE = 76,
+    VTK_BEZIER_QUADRILATERAL = 77,
+    VTK_BEZIER_TETRAHEDRON = 78,
+    VTK_BEZIER_HEXAHEDRON = 79,
+    VTK_BEZIER_WEDGE = 80,
+    VTK_BEZIER_PYRAMID = 81
+};
+
+/*!
+ * \brief Returns number of nodes of cells of the given type, 0 if cells of this type may have any number of nodes
+ */
+inline size_t VTKNumberOfNodes(const VTKCellType type) {
+    switch (type) {
+        case VTK_VERTEX:                            return 1;
+        case VTK_LINE:                              return 2;
+        case VTK_TRIANGLE:                          return 3;
+        case VTK_PIXEL:                             return 4;
+        case VTK_QUAD:                              return 4;
+        case VTK_TETRA:                             return 4;
+        case VTK_VOXEL:                             return 8;
+        case VTK_HEXAHEDRON:                        return 8;
+        case VTK_WEDGE:                             return 6;
+        case VTK_PYRAMID:                           return 5;
+        case VTK_PENTAGONAL_PRISM:                  return 10;
+        case VTK_HEXAGONAL_PRISM:                   return 12;
+        case VTK_QUADRATIC_EDGE:                    return 3;
+        case VTK_QUADRATIC_TRIANGLE:                return 6;
+        case VTK_QUADRATIC_QUAD:                    return 8;
+        case VTK_QUADRATIC_TETRA:                   return 10;
+        case VTK_QUADRATIC_HEXAHEDRON:              return 20;
+        case VTK_QUADRATIC_WEDGE:                   return 15;
+        case VTK_QUADRATIC_PYRAMID:                 return 13;
+        case VTK_BIQUADRATIC_QUAD:                  return 9;
+        case VTK_TRIQUADRATIC_HEXAHEDRON:           return 27;
+        case VTK_QUADRATIC_LINEAR_QUAD:             return 6;
+        case VTK_QUADRATIC_LINEAR_WEDGE:            return 12;
+        case VTK_BIQUADRATIC_QUADRATIC_WEDGE:       return 18;
+        case VTK_BIQUADRATIC_QUADRATIC_HEXAHEDRON:  return 24;
+        case VTK_BIQUADRATIC_TRIANGLE:              return 7;
+        case VTK_CUBIC_LINE:                        return 4;
+        case VTK_TRIQUADRATIC_PYRAMID:              return 19;
+        default:                                    return 0;
+    }
+}
+
+/*!
+ * \brief Returns number of nodes of Lagrange and Bezier cells of the given order (the same in all directions),
+ * 0 for other types of cells
+ */
+inline size_t VTKNumberOfNodes(const VTKCellType type, const size_t order) {
+    const size_t p = order;
+    switch (type) {
+        case VTK_LAGRANGE_CURVE:
+        case VTK_BEZIER_CURVE:              return p + 1;
+        case VTK_LAGRANGE_TRIANGLE:
+        case VTK_BEZIER_TRIANGLE:           return (p + 1) * (p + 2) / 2;
+        case VTK_LAGRANGE_QUADRILATERAL:
+        case VTK_BEZIER_QUADRILATERAL:      return (p + 1) * (p + 1);
+        case VTK_LAGRANGE_TETRAHEDRON:
+        case VTK_BEZIER_TETRAHEDRON:        return (p + 1) * (p + 2) * (p + 3) / 6;
+        case VTK_LAGRANGE_HEXAHEDRON:
+        case VTK_BEZIER_HEXAHEDRON:         return (p + 1) * (p + 1) * (p + 1);
+        case VTK_LAGRANGE_WEDGE:
+        case VTK_BEZIER_WEDGE:              return (p + 1) * (p + 1) * (p + 2) / 2;
+        default:                            return 0;
+    }
+}
+
+} /* namespace xmlw */
+
+#endif /* VTKCELLTYPE_H_ */
@@ -0,0 +1,120 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef VTKTYPETRAITS_H_
+#define VTKTYPETRAITS_H_
+
+#include <cstddef>
+#include <array>
+#include <type_traits>
+
+namespace xmlw {
+
+/*!
+ * \brief Maps fundamental types onto VTK data types by their kind and size
+ * Types which have no VTK counterpart (bool, long double, ...) fall into the primary template and are rejected.
+ */
+template<bool is_float, bool is_signed, size_t size>
+struct VTKScalarTraits {
+    static constexpr bool supported = false;
+};
+
+template<> struct VTKScalarTraits<true, true, 4>   { static constexpr bool supported = true; static constexpr const char *name() { return "Float32"; } };
+template<> struct VTKScalarTraits<true, true, 8>   { static constexpr bool supported = true; static constexpr const char *name() { return "Float64"; } };
+template<> struct VTKScalarTraits<false, true, 1>  { static constexpr bool supported = true; static constexpr const char *name() { return "Int8"; } };
+template<> struct VTKScalarTraits<false, true, 2>  { static constexpr bool supported = true; static constexpr const char *name() { return "Int16"; } };
+template<> struct VTKScalarTraits<false, true, 4>  { static constexpr bool supported = true; static constexpr const char *name() { return "Int32"; } };
+template<> struct VTKScalarTraits<false, true, 8>  { static constexpr bool supported = true; static constexpr const char *name() { return "Int64"; } };
+template<> struct VTKScalarTraits<false, false, 1> { static constexpr bool supported = true; static constexpr const char *name() { return "UInt8"; } };
+template<> struct VTKScalarTraits<false, false, 2> { static constexpr bool supported = true; static constexpr const char *name() { return "UInt16"; } };
+template<> struct VTKScalarTraits<false, false, 4> { static constexpr bool supported = true; static constexpr const char *name() { return "UInt32"; } };
+template<> struct VTKScalarTraits<false, false, 8> { static constexpr bool supported = true; static constexpr const char *name() { return "UInt64"; } };
+
+/*!
+ * \brief Traits of an element made of num_of_comp values of type Scalar
+ * Can be used as a base of specializations of VTKTypeTraits for user-defined structures, e.g.
+ * \code
+ * template<> struct VTKTypeTraits<Coord> : VTKComponentTraits<float, 3> { };
+ * \endcode
+ */
+template<typename Scalar, size_t N>
+struct VTKComponentTraits {
+    static constexpr bool supported = VTKScalarTraits<std::is_floating_point<Scalar>::value,
+            std::is_signed<Scalar>::value, sizeof(Scalar)>::supported;
+    static constexpr size_t num_of_comp = N;            //!< Number of components in one element
+    static constexpr size_t size = sizeof(Scalar) * N;  //!< Size of one element in Bytes
+    static constexpr const char *name() {               //!< VTK name of the type of components
+        return VTKScalarTraits<std::is_floating_point<Scalar>::value,
+                std::is_signed<Scalar>::value, sizeof(Scalar)>::name();
+    }
+};
+
+/*!
+ * \class VTKTypeTraits
+ * \brief Compile-time description of an element of a data set: VTK type name, number of components and size
+ * Arithmetic types (except of bool) and std::array of supported types are described out of the box, other types
+ * have to be described by a specialization (see VTKComponentTraits). The type name is resolved by the kind and the
+ * size of the type, so 'long' is "Int64" on LP64 systems and "Int32" on LLP64 ones.
+ */
+template<typename T, typename Enable = void>
+struct VTKTypeTraits {
+    static constexpr bool supported = false;
+};
+
+template<typename T>
+struct VTKTypeTraits<T, typename std::enable_if<std::is_arithmetic<T>::value
+        && !std::is_same<T, bool>::value>::type> : VTKComponentTraits<T, 1> { };
+
+template<typename T, size_t N>
+struct VTKTypeTraits<std::array<T, N> > {
+    static constexpr bool supported = VTKTypeTraits<T>::supported;
+    static constexpr size_t num_of_comp = VTKTypeTraits<T>::num_of_comp * N;
+    static constexpr size_t size = VTKTypeTraits<T>::size * N;
+    static constexpr const char *name() { return VTKTypeTraits<T>::name(); }
+};
+
+/*!
+ * \brief Returns VTK name of the type of components of T, fails to compile for unsupported types
+ */
+template<typename T>
+constexpr const char *VTKTypeName() {
+    static_assert(VTKTypeTraits<T>::supported, "The type has no VTK counterpart, specialize xmlw::VTKTypeTraits");
+    static_assert(VTKTypeTraits<T>::size == sizeof(T), "The type contains padding and can't be written directly");
+    return VTKTypeTraits<T>::name();
+}
+
+/*!
+ * \brief Returns number of components in one element of type T, fails to compile for unsupported types
+ */
+template<typename T>
+constexpr size_t VTKNumberOfComponents() {
+    static_assert(VTKTypeTraits<T>::supported, "The type has no VTK counterpart, specialize xmlw::VTKTypeTraits");
+    return VTKTypeTraits<T>::num_of_comp;
+}
+
+} /* namespace xmlw */
+
+#endif /* VTKTYPETRAITS_H_ */
@@ -0,0 +1,154 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef WRITERSTATS_H_
+#define WRITERSTATS_H_
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+/*
+ * Statements wrapped into XMLW_STATS() are compiled only in builds with XMLW_WITH_STATS (make stats=1),
+ * otherwise the instrumentation has no cost at all.
+ */
+#ifdef XMLW_WITH_STATS
+#define XMLW_STATS(...) __VA_ARGS__
+#else
+#define XMLW_STATS(...)
+#endif
+
+namespace xmlw {
+
+/*!
+ * \brief Statistics of a single data set
+ */
+struct ArrayStats {
+    std::string name;           //!< Name of the data set (empty for data sets written by VTK_XML_Writer directly)
+    size_t bytes;               //!< Bytes written into the file including the header (0 for ascii data sets)
+    double encode_time;         //!< Time of compression and encoding in seconds
+    double write_time;          //!< Time of passing the data set to the output in seconds
+
+    ArrayStats(const std::string _name = std::string()) :
+        name(_name), bytes(0), encode_time(0.), write_time(0.) { }
+};
+
+/*!
+ * \class WriterStats
+ * \brief Counters of a writer, collected in builds with XMLW_WITH_STATS only
+ * AppendedFileWriter (and writers derived from it) resets the counters at the beginning of every Write() and reports
+ * them to the callback set by VTK_XML_Writer::SetStatsCallback() when the file is closed. Data sets written by
+ * VTK_XML_Writer directly (WriteData(), WriteBinaryData(), AppendData()) are accumulated in the order of calls until
+ * VTK_XML_Writer::ResetStats() is called.
+ *
+ * The time of writing a data set is known only if data sets are written one by one (std::ofstream backend and
+ * VTK_XML_Writer::AppendData()), the vectored and mapped backends write several data sets at once, so only the total
+ * time of the payload is measured. System calls are counted where the library issues them directly (vectored and
+ * mapped backends and opening/closing of files), writes into std::ofstream are counted as write requests.
+ */
+struct WriterStats {
+
+    /*!
+     * \brief Phases of writing a file
+     */
+    enum Phase {
+        PHASE_PREPARE,          //!< Offsets, hashing, deduplication and compression of data sets
+        PHASE_HEADER,           //!< Assembling the main body of the file
+        PHASE_PAYLOAD,          //!< Writing the main body and the appended data
+        PHASE_CLOSE,            //!< Flushing, unmapping and closing the file
+        NUM_PHASES
+    };
+
+    std::string file_name;              //!< Name of the file
+    double phase_time[NUM_PHASES];      //!< Duration of every phase in seconds
+    double total_time;                  //!< Total time of writing the file in seconds
+    size_t header_bytes;                //!< Size of the main body in Bytes
+    size_t payload_bytes;               //!< Size of all data sets in Bytes
+    size_t num_syscalls;                //!< Number of system calls issued by the library
+    size_t num_writes;                  //!< Number of write requests (system calls, writes into the stream
+                                        //!< or chunks copied into the mapped file)
+    std::vector<ArrayStats> arrays;     //!< Statistics of the data sets
+
+    /*!
+     * \brief Constructor
+     */
+    WriterStats() { Reset(); }
+
+    /*!
+     * \brief Sets all counters to zero
+     */
+    inline void Reset();
+
+    /*!
+     * \brief Returns achieved bandwidth (main body and data sets) in Bytes per second
+     */
+    inline double GetBandwidth() const;
+
+    /*!
+     * \brief Returns name of the phase
+     */
+    static inline const char *GetPhaseName(const Phase phase);
+};
+
+/*!
+ * \brief Function called with the statistics of every written file
+ */
+typedef std::function<void(const WriterStats&)> StatsCallback;
+
+/*!
+ * \class StatsTimer
+ * \brief Adds time elapsed between construction and destruction to the given counter
+ */
+class StatsTimer {
+public:
+
+    /*!
+     * \brief Constructor, starts the timer
+     * @param _counter Counter of seconds
+     */
+    explicit StatsTimer(double &_counter) : counter(_counter), start(Now()) { }
+
+    /*!
+     * \brief Destructor, adds elapsed time to the counter
+     */
+    ~StatsTimer() { counter += Now() - start; }
+
+    /*!
+     * \brief Returns time of a monotonic clock in seconds
+     */
+    static inline double Now();
+
+private:
+    double &counter;        //!< Counter of seconds
+    const double start;     //!< Time of construction
+};
+
+} /* namespace xmlw */
+
+#include "WriterStats.inl"
+
+#endif /* WRITERSTATS_H_ */
@@ -0,0 +1,61 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef WRITERSTATS_INL_
+#define WRITERSTATS_INL_
+
+#include <chrono>
+
+namespace xmlw {
+
+inline void WriterStats::Reset() {
+    file_name.clear();
+    for(size_t n = 0; n < NUM_PHASES; ++n)
+        phase_time[n] = 0.;
+    total_time = 0.;
+    header_bytes = 0;
+    payload_bytes = 0;
+    num_syscalls = 0;
+    num_writes = 0;
+    arrays.clear();
+}
+
+inline double WriterStats::GetBandwidth() const {
+    return total_time > 0. ? (header_bytes + payload_bytes) / total_time : 0.;
+}
+
+inline const char *WriterStats::GetPhaseName(const Phase phase) {
+    static const char *names[NUM_PHASES] = { "prepare", "header", "payload", "close" };
+    return phase < NUM_PHASES ? names[phase] : "";
+}
+
+inline double StatsTimer::Now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+#endif /* WRITERSTATS_INL_ */
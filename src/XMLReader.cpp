@@ -0,0 +1,1685 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#include "XMLReader.h"
+#include "DataCompressor.h"
+#include "Base64Encoder.h"
+#include "ThreadPool.h"
+#include "UnstructuredGridWriter.h"
+#include "ImageDataWriter.h"
+#include "RectilinearGridWriter.h"
+#include "FieldAppender.h"
+#include "AsyncWriter.h"
+#include "TimeSeriesWriter.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <clocale>
+#include <limits>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XMLW_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+namespace xmlw {
+
+/* Sections of the piece which contain data sets */
+static const char *data_sections[] = { "PointData", "CellData", "Points", "Coordinates", "Cells", "FieldData" };
+static const size_t num_of_data_sections = sizeof(data_sections) / sizeof(data_sections[0]);
+
+/* Maximum size of a chunk of uncompressed data set copied by a single task */
+static const size_t read_chunk_size = size_t(1) << 22;
+
+/* Marks ASCII data sets which can't be parsed */
+static const size_t broken_ascii = std::numeric_limits<size_t>::max();
+
+static bool IsSpace(const char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r';
+}
+
+/*
+ * Finds the character in [pos, end), returns end if not found
+ */
+static const char *Find(const char *pos, const char *end, const char c) {
+    const char *found = (const char*)std::memchr(pos, c, end - pos);
+    return found != NULL ? found : end;
+}
+
+/*
+ * Finds the string in [pos, end), returns end if not found
+ */
+static const char *Find(const char *pos, const char *end, const char *str) {
+    const size_t length = std::strlen(str);
+    for(pos = Find(pos, end, str[0]); pos + length <= end; pos = Find(pos + 1, end, str[0]))
+        if (std::memcmp(pos, str, length) == 0)
+            return pos;
+    return end;
+}
+
+/*
+ * Returns value of the attribute, empty if not given
+ */
+static std::string GetValue(const std::map<std::string, std::string> &attributes, const std::string &key) {
+    std::map<std::string, std::string>::const_iterator it = attributes.find(key);
+    return it != attributes.end() ? it->second : std::string();
+}
+
+/*
+ * Converts integer to the type of the given size and stores it
+ */
+template<typename Signed, typename Unsigned>
+static void StoreInteger(const Signed value, const bool is_signed, const size_t size, char *out) {
+    if (is_signed) {
+        if (size == 1) { int8_t v = value; std::memcpy(out, &v, size); }
+        else if (size == 2) { int16_t v = value; std::memcpy(out, &v, size); }
+        else if (size == 4) { int32_t v = value; std::memcpy(out, &v, size); }
+        else { int64_t v = value; std::memcpy(out, &v, size); }
+    }
+    else {
+        const Unsigned uvalue = value;
+        if (size == 1) { uint8_t v = uvalue; std::memcpy(out, &v, size); }
+        else if (size == 2) { uint16_t v = uvalue; std::memcpy(out, &v, size); }
+        else if (size == 4) { uint32_t v = uvalue; std::memcpy(out, &v, size); }
+        else { uint64_t v = uvalue; std::memcpy(out, &v, size); }
+    }
+}
+
+VTK_XML_Reader::VTK_XML_Reader() :
+        file_data(NULL), file_size(0), mapped(false), appended_start(0), header_type_size(sizeof(uint32_t)),
+        swap_bytes(false), num_pieces(0), num_threads(0) {
+}
+
+VTK_XML_Reader::~VTK_XML_Reader() {
+    Close();
+}
+
+bool VTK_XML_Reader::Open(const std::string _file_name) {
+
+    Close();
+    file_name = _file_name;
+
+#ifdef XMLW_POSIX
+    const int fd = open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error! Can't open file " << file_name << " for reading. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        file_size = st.st_size;
+        /* Pages are loaded on demand, so data sets which are never read are never touched */
+        void *map = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map != MAP_FAILED) {
+            file_data = (const char*)map;
+            mapped = true;
+        }
+    }
+    close(fd);
+#endif
+
+    /* Systems without mmap() (or files which can't be mapped) are loaded as a whole */
+    if (file_data == NULL) {
+        std::ifstream is(file_name.c_str(), std::ios::in | std::ios::binary);
+        if (!is.is_open()) {
+            std::cerr << "Error! Can't open file " << file_name << " for reading. See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            Close();
+            return false;
+        }
+        is.seekg(0, std::ios::end);
+        storage.resize(is.tellg());
+        is.seekg(0);
+        if (!storage.empty())
+            is.read(storage.data(), storage.size());
+        file_data = storage.data();
+        file_size = storage.size();
+    }
+
+    if (file_size == 0 || !Parse()) {
+        std::cerr << "Error! File " << file_name << " is not a valid VTK XML file. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void VTK_XML_Reader::Close() {
+#ifdef XMLW_POSIX
+    if (mapped)
+        munmap((void*)file_data, file_size);
+#endif
+    file_data = NULL;
+    file_size = 0;
+    mapped = false;
+    std::vector<char>().swap(storage);
+    appended_start = 0;
+    file_type.clear();
+    header_type_size = sizeof(uint32_t);
+    swap_bytes = false;
+    compressor.reset();
+    elements.clear();
+    arrays.clear();
+    num_pieces = 0;
+}
+
+bool VTK_XML_Reader::IsOpen() const {
+    return file_data != NULL;
+}
+
+bool VTK_XML_Reader::Parse() {
+
+    const char *begin = file_data;
+    const char *end = file_data + file_size;
+    const char *pos = begin;
+    std::string section;
+
+    while ((pos = Find(pos, end, '<')) != end) {
+        ++pos;
+
+        /* Declaration and comments */
+        if (pos < end && (*pos == '?' || *pos == '!')) {
+            pos = (*pos == '!') ? Find(pos, end, "-->") : Find(pos, end, '>');
+            continue;
+        }
+
+        const bool closing = pos < end && *pos == '/';
+        if (closing)
+            ++pos;
+
+        const char *name_begin = pos;
+        while (pos < end && !IsSpace(*pos) && *pos != '>' && *pos != '/')
+            ++pos;
+        const std::string name(name_begin, pos);
+
+        /* Attributes: name="value" */
+        std::map<std::string, std::string> attributes;
+        bool self_closing = false;
+        while (true) {
+            while (pos < end && IsSpace(*pos))
+                ++pos;
+            if (pos >= end)
+                return false;
+            if (*pos == '>')
+                break;
+            if (*pos == '/') {
+                self_closing = true;
+                ++pos;
+                continue;
+            }
+
+            const char *key = pos;
+            pos = Find(pos, end, '=');
+            if (pos + 1 >= end || pos[1] != '"')
+                return false;
+            const char *value = pos + 2;
+            pos = Find(value, end, '"');
+            if (pos == end)
+                return false;
+            std::string key_str(key, std::find_if(key, value - 2, IsSpace));
+            attributes[key_str] = std::string(value, pos);
+            ++pos;
+        }
+        ++pos;
+
+        if (closing) {
+            if (name == section)
+                section.clear();
+            continue;
+        }
+
+        if (name == "DataArray") {
+            ArrayInfo arr;
+            arr.section = section;
+            arr.name = GetValue(attributes, "Name");
+            arr.type = GetValue(attributes, "type");
+            arr.num_of_comp = attributes.count("NumberOfComponents") ?
+                    std::strtoul(GetValue(attributes, "NumberOfComponents").c_str(), NULL, 10) : 1;
+            arr.piece = num_pieces != 0 ? num_pieces - 1 : 0;
+            arr.format = attributes.count("format") ? GetValue(attributes, "format") : "ascii";
+            arr.offset = 0;
+            arr.length = 0;
+
+            if (arr.format == "appended") {
+                arr.offset = std::strtoull(GetValue(attributes, "offset").c_str(), NULL, 10);
+            }
+            else if (!self_closing) {
+                /* The text of the data set is skipped, it is parsed only when requested */
+                const char *text_end = Find(pos, end, "</DataArray>");
+                if (text_end == end)
+                    return false;
+                arr.offset = pos - begin;
+                arr.length = text_end - pos;
+                pos = text_end;
+            }
+
+            arr.attributes.swap(attributes);
+            arrays.push_back(arr);
+            continue;
+        }
+
+        elements.push_back(Element());
+        elements.back().name = name;
+        elements.back().attributes = attributes;
+
+        if (name == "VTKFile") {
+            file_type = GetValue(attributes, "type");
+            header_type_size = GetValue(attributes, "header_type") == "UInt64" ?
+                    sizeof(uint64_t) : sizeof(uint32_t);
+
+            const short int number = 0x1;
+            const bool little_endian = ((const char*)&number)[0] == 1;
+            swap_bytes = attributes.count("byte_order") &&
+                    (GetValue(attributes, "byte_order") == "LittleEndian") != little_endian;
+
+            const std::string compressor_name = GetValue(attributes, "compressor");
+            if (!compressor_name.empty() && DataCompressor::IsSupported(compressor_name))
+                compressor = std::make_shared<DataCompressor>(compressor_name);
+        }
+        else if (name == "Piece") {
+            ++num_pieces;
+        }
+        else if (name == "AppendedData") {
+            const std::string encoding = GetValue(attributes, "encoding");
+            if (encoding != "raw") {
+                std::cerr << "Error! Only raw appended data is supported, file " << file_name << " has "
+                        << encoding << " encoding. See " << __FILE__ << ":" << __LINE__ << "\n";
+                return false;
+            }
+            /* Appended data follows the underscore, nothing after it is parsed */
+            pos = Find(pos, end, '_');
+            if (pos == end)
+                return false;
+            appended_start = pos + 1 - begin;
+            break;
+        }
+        else if (!self_closing) {
+            for(size_t s = 0; s < num_of_data_sections; ++s)
+                if (name == data_sections[s])
+                    section = name;
+        }
+    }
+
+    for(size_t n = 0; n < arrays.size(); ++n)
+        if (arrays[n].format == "appended" && appended_start == 0)
+            return false;
+
+    return !elements.empty() && elements[0].name == "VTKFile";
+}
+
+const std::string &VTK_XML_Reader::GetFileType() const {
+    return file_type;
+}
+
+std::string VTK_XML_Reader::GetAttribute(const std::string element, const std::string attribute,
+        const size_t index) const {
+    size_t count = 0;
+    for(size_t n = 0; n < elements.size(); ++n) {
+        if (elements[n].name != element || count++ != index)
+            continue;
+        return GetValue(elements[n].attributes, attribute);
+    }
+    return std::string();
+}
+
+const std::vector<VTK_XML_Reader::Element> &VTK_XML_Reader::GetElements() const {
+    return elements;
+}
+
+size_t VTK_XML_Reader::GetNumberOfPieces() const {
+    return num_pieces;
+}
+
+size_t VTK_XML_Reader::GetNumberOfArrays() const {
+    return arrays.size();
+}
+
+const VTK_XML_Reader::ArrayInfo &VTK_XML_Reader::GetArray(const size_t n) const {
+    return arrays[n];
+}
+
+const VTK_XML_Reader::ArrayInfo *VTK_XML_Reader::FindArray(const std::string section, const std::string name,
+        const size_t piece) const {
+    for(size_t n = 0; n < arrays.size(); ++n)
+        if (arrays[n].piece == piece && arrays[n].section == section && arrays[n].name == name)
+            return &arrays[n];
+    return NULL;
+}
+
+size_t VTK_XML_Reader::GetTypeSize(const std::string &type) {
+    if (type == "Int8" || type == "UInt8")
+        return 1;
+    if (type == "Int16" || type == "UInt16")
+        return 2;
+    if (type == "Int32" || type == "UInt32" || type == "Float32")
+        return 4;
+    if (type == "Int64" || type == "UInt64" || type == "Float64")
+        return 8;
+    return 0;
+}
+
+size_t VTK_XML_Reader::ReadHeaderInt(const char *pos) const {
+    char buffer[sizeof(uint64_t)];
+    std::memcpy(buffer, pos, header_type_size);
+    if (swap_bytes)
+        std::reverse(buffer, buffer + header_type_size);
+
+    if (header_type_size == sizeof(uint64_t)) {
+        uint64_t value;
+        std::memcpy(&value, buffer, sizeof(uint64_t));
+        return value;
+    }
+    uint32_t value;
+    std::memcpy(&value, buffer, sizeof(uint32_t));
+    return value;
+}
+
+size_t VTK_XML_Reader::GetNumberOfBytes(const ArrayInfo &arr) const {
+
+    const char *end = file_data + file_size;
+
+    if (arr.format == "appended") {
+        const char *pos = file_data + appended_start + arr.offset;
+        const size_t num_ints = compressor ? 3 : 1;
+        if (pos > end || (size_t)(end - pos) < num_ints * header_type_size)
+            return 0;
+        if (!compressor)
+            return ReadHeaderInt(pos);
+
+        const size_t num_blocks = ReadHeaderInt(pos);
+        const size_t block_size = ReadHeaderInt(pos + header_type_size);
+        const size_t last_block_size = ReadHeaderInt(pos + 2 * header_type_size);
+        return num_blocks == 0 ? 0 : (num_blocks - 1) * block_size + (last_block_size != 0 ?
+                last_block_size : block_size);
+    }
+
+    if (arr.format == "binary") {
+        const char *text = file_data + arr.offset;
+        const char *text_end = text + arr.length;
+        while (text < text_end && IsSpace(*text))
+            ++text;
+
+        /* The header is encoded separately, its first integers are decoded alone */
+        const size_t num_ints = compressor ? 3 : 1;
+        const size_t encoded = Base64Encoder::EncodedSize(num_ints * header_type_size);
+        char header[3 * sizeof(uint64_t) + 2];
+        if ((size_t)(text_end - text) < encoded || !Base64Encoder::Decode(text, encoded, header))
+            return 0;
+        if (!compressor)
+            return ReadHeaderInt(header);
+
+        const size_t num_blocks = ReadHeaderInt(header);
+        const size_t block_size = ReadHeaderInt(header + header_type_size);
+        const size_t last_block_size = ReadHeaderInt(header + 2 * header_type_size);
+        return num_blocks == 0 ? 0 : (num_blocks - 1) * block_size + (last_block_size != 0 ?
+                last_block_size : block_size);
+    }
+
+    const size_t num_values = ParseAscii(arr, NULL);
+    return num_values == broken_ascii ? 0 : num_values * GetTypeSize(arr.type);
+}
+
+size_t VTK_XML_Reader::GetNumberOfValues(const ArrayInfo &arr) const {
+    const size_t type_size = GetTypeSize(arr.type);
+    return type_size != 0 ? GetNumberOfBytes(arr) / type_size : 0;
+}
+
+const char *VTK_XML_Reader::GetRawData(const ArrayInfo &arr) const {
+
+    if (arr.format != "appended" || compressor || !IsOpen())
+        return NULL;
+
+    const char *pos = file_data + appended_start + arr.offset;
+    const size_t available = file_data + file_size - pos;
+    if (pos > file_data + file_size || available < header_type_size ||
+            available - header_type_size < ReadHeaderInt(pos))
+        return NULL;
+    return pos + header_type_size;
+}
+
+bool VTK_XML_Reader::ReadData(const ArrayInfo &arr, char *out) {
+
+    if (!IsOpen()) {
+        std::cerr << "Error! No file is opened. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    const size_t type_size = GetTypeSize(arr.type);
+    if (type_size == 0) {
+        std::cerr << "Error! Unknown type " << arr.type << " of data set " << arr.name << ". See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    const std::string compressor_name = GetAttribute("VTKFile", "compressor");
+    if (!compressor_name.empty() && !compressor && arr.format != "ascii") {
+        std::cerr << "Error! Compressor " << compressor_name << " of file " << file_name
+                << " is not supported by this build. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    bool status = true;
+    const size_t num_bytes = GetNumberOfBytes(arr);
+
+    if (arr.format == "appended" && compressor) {
+        status = Decompress(file_data + appended_start + arr.offset, file_data + file_size, out, num_bytes);
+    }
+    else if (arr.format == "appended") {
+        const char *data = GetRawData(arr);
+        status = data != NULL;
+
+        /* Large data sets are copied by chunks in parallel, so pages of the file are loaded concurrently */
+        const size_t num_chunks = (num_bytes + read_chunk_size - 1) / read_chunk_size;
+        if (status && num_chunks > 1)
+            GetThreadPool()->Run(num_chunks, [&](size_t n) {
+                const size_t begin = n * read_chunk_size;
+                std::memcpy(out + begin, data + begin, std::min(read_chunk_size, num_bytes - begin));
+            });
+        else if (status && num_bytes != 0)
+            std::memcpy(out, data, num_bytes);
+    }
+    else if (arr.format == "binary") {
+        status = DecodeBinary(arr, out, num_bytes);
+    }
+    else if (arr.format == "ascii") {
+        /* Values are parsed directly into the byte order of the system */
+        return ParseAscii(arr, out) != broken_ascii;
+    }
+    else {
+        std::cerr << "Error! Unknown format " << arr.format << " of data set " << arr.name << ". See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    if (!status) {
+        std::cerr << "Error! Data set " << arr.name << " of file " << file_name << " is broken. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    SwapBytes(out, num_bytes, type_size);
+    return true;
+}
+
+bool VTK_XML_Reader::Decompress(const char *pos, const char *end, char *out, const size_t num_bytes) {
+
+    if (pos > end || (size_t)(end - pos) < 3 * header_type_size)
+        return false;
+
+    const size_t num_blocks = ReadHeaderInt(pos);
+    const size_t block_size = ReadHeaderInt(pos + header_type_size);
+    const size_t header_size = (3 + num_blocks) * header_type_size;
+    if (num_blocks > (size_t)(end - pos) / header_type_size || (size_t)(end - pos) < header_size)
+        return false;
+
+    /* Positions of compressed blocks, blocks are independent and decompressed concurrently */
+    std::vector<size_t> begin(num_blocks + 1, header_size);
+    for(size_t n = 0; n < num_blocks; ++n)
+        begin[n + 1] = begin[n] + ReadHeaderInt(pos + (3 + n) * header_type_size);
+    if (begin[num_blocks] > (size_t)(end - pos))
+        return false;
+
+    std::vector<char> status(num_blocks, 0);
+    GetThreadPool()->Run(num_blocks, [&](size_t n) {
+        const size_t first = n * block_size;
+        const size_t size = std::min(block_size, num_bytes - first);
+        status[n] = compressor->DecompressBlock(pos + begin[n], begin[n + 1] - begin[n], out + first, size);
+    });
+
+    return std::find(status.begin(), status.end(), 0) == status.end();
+}
+
+bool VTK_XML_Reader::DecodeBinary(const ArrayInfo &arr, char *out, const size_t num_bytes) {
+
+    const char *text = file_data + arr.offset;
+    const char *text_end = text + arr.length;
+    while (text < text_end && IsSpace(*text))
+        ++text;
+    while (text_end > text && IsSpace(text_end[-1]))
+        --text_end;
+
+    if (!compressor) {
+        const size_t encoded = Base64Encoder::EncodedSize(header_type_size);
+        if ((size_t)(text_end - text) < encoded ||
+                Base64Encoder::DecodedSize(text + encoded, text_end - text - encoded) != num_bytes)
+            return false;
+        return Base64Encoder::Decode(text + encoded, text_end - text - encoded, out);
+    }
+
+    /* The header and the blocks are encoded separately, they are decoded into one buffer */
+    char first[3 * sizeof(uint64_t) + 2];
+    if ((size_t)(text_end - text) < Base64Encoder::EncodedSize(3 * header_type_size) ||
+            !Base64Encoder::Decode(text, Base64Encoder::EncodedSize(3 * header_type_size), first))
+        return false;
+    const size_t num_blocks = ReadHeaderInt(first);
+    if (num_blocks > (size_t)(text_end - text))
+        return false;
+    const size_t encoded = Base64Encoder::EncodedSize((3 + num_blocks) * header_type_size);
+    if ((size_t)(text_end - text) < encoded)
+        return false;
+
+    const size_t header_size = Base64Encoder::DecodedSize(text, encoded);
+    std::vector<char> buffer(header_size + Base64Encoder::DecodedSize(text + encoded, text_end - text - encoded));
+    if (!Base64Encoder::Decode(text, encoded, buffer.data()) ||
+            !Base64Encoder::Decode(text + encoded, text_end - text - encoded, buffer.data() + header_size))
+        return false;
+
+    return Decompress(buffer.data(), buffer.data() + buffer.size(), out, num_bytes);
+}
+
+size_t VTK_XML_Reader::ParseAscii(const ArrayInfo &arr, char *out) const {
+
+    const size_t type_size = GetTypeSize(arr.type);
+    const bool is_float = arr.type == "Float32" || arr.type == "Float64";
+    const bool is_signed = arr.type[0] == 'I';
+
+    /* Values are written with '.', which is replaced by the decimal point of the current locale */
+    const char decimal_point = *std::localeconv()->decimal_point;
+
+    const char *pos = file_data + arr.offset;
+    const char *end = pos + arr.length;
+    size_t count = 0;
+    char token[64];
+
+    while (true) {
+        while (pos < end && IsSpace(*pos))
+            ++pos;
+        if (pos == end)
+            break;
+
+        const char *token_end = pos;
+        while (token_end < end && !IsSpace(*token_end))
+            ++token_end;
+
+        if (out != NULL) {
+            const size_t length = token_end - pos;
+            if (length >= sizeof(token)) {
+                std::cerr << "Error! Value " << std::string(pos, token_end) << " of data set " << arr.name
+                        << " is too long. See " << __FILE__ << ":" << __LINE__ << "\n";
+                return broken_ascii;
+            }
+            std::memcpy(token, pos, length);
+            token[length] = '\0';
+
+            char *parsed;
+            if (is_float) {
+                if (decimal_point != '.')
+                    std::replace(token, token + length, '.', decimal_point);
+                const double value = std::strtod(token, &parsed);
+                if (type_size == sizeof(float)) {
+                    const float fvalue = value;
+                    std::memcpy(out + count * type_size, &fvalue, sizeof(float));
+                }
+                else {
+                    std::memcpy(out + count * type_size, &value, sizeof(double));
+                }
+            }
+            else if (is_signed) {
+                StoreInteger<long long, unsigned long long>(std::strtoll(token, &parsed, 10), true, type_size,
+                        out + count * type_size);
+            }
+            else {
+                StoreInteger<unsigned long long, unsigned long long>(std::strtoull(token, &parsed, 10), false,
+                        type_size, out + count * type_size);
+            }
+
+            if (parsed != token + length) {
+                std::cerr << "Error! Can't parse value " << token << " of data set " << arr.name << ". See "
+                        << __FILE__ << ":" << __LINE__ << "\n";
+                return broken_ascii;
+            }
+        }
+
+        ++count;
+        pos = token_end;
+    }
+
+    return count;
+}
+
+void VTK_XML_Reader::SwapBytes(char *data, const size_t num_bytes, const size_t value_size) const {
+    if (!swap_bytes || value_size == 1)
+        return;
+    for(size_t n = 0; n + value_size <= num_bytes; n += value_size)
+        std::reverse(data + n, data + n + value_size);
+}
+
+void VTK_XML_Reader::SetNumberOfThreads(const size_t _num_threads) {
+    if (pool && num_threads != _num_threads)
+        pool.reset();
+    num_threads = _num_threads;
+}
+
+ThreadPool *VTK_XML_Reader::GetThreadPool() {
+    if (!pool)
+        pool = std::make_shared<ThreadPool>(num_threads);
+    return pool.get();
+}
+
+/*
+ * Loads the data set from the file and compares it with the written one, prints an error if they differ
+ */
+template<typename T>
+static bool CheckArray(VTK_XML_Reader &reader, const std::string &file_name, const std::string &section,
+        const std::string &name, const std::vector<T> &data, const size_t piece = 0) {
+
+    const VTK_XML_Reader::ArrayInfo *arr = reader.FindArray(section, name, piece);
+    std::vector<T> loaded;
+
+    if (arr == NULL || !reader.ReadArray(*arr, loaded) || loaded != data) {
+        std::cerr << "Error! Data set " << section << "/" << name << " of piece " << piece << " of file "
+                << file_name << " differs from the written one. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Compares the attribute of an element of the file with the expected value, prints an error if they differ
+ */
+static bool CheckAttribute(const VTK_XML_Reader &reader, const std::string &file_name, const std::string &element,
+        const std::string &attribute, const std::string &value, const size_t index = 0) {
+
+    if (reader.GetAttribute(element, attribute, index) != value) {
+        std::cerr << "Error! Attribute " << attribute << " of " << element << " " << index << " of file " << file_name
+                << " is '" << reader.GetAttribute(element, attribute, index) << "' instead of '" << value
+                << "'. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Straightforward base64 encoding, the reference for the vectorized kernels of Base64Encoder
+ */
+static std::string EncodeBase64Reference(const unsigned char *in, const size_t size) {
+
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+
+    for(size_t n = 0; n < size; n += 3) {
+        const unsigned int word = (in[n] << 16) | (n + 1 < size ? in[n + 1] << 8 : 0) | (n + 2 < size ? in[n + 2] : 0);
+        out += table[(word >> 18) & 0x3f];
+        out += table[(word >> 12) & 0x3f];
+        out += n + 1 < size ? table[(word >> 6) & 0x3f] : '=';
+        out += n + 2 < size ? table[word & 0x3f] : '=';
+    }
+    return out;
+}
+
+/*
+ * Opens the file written by the test, prints an error if it can't be opened
+ */
+static bool OpenFile(VTK_XML_Reader &reader, const std::string &file_name) {
+    if (!reader.Open(file_name)) {
+        std::cerr << "Error! Can't read back " << file_name << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool VTK_XML_Reader::TestRoundTrip() {
+
+    bool status = true;
+    std::vector<float> points;
+    std::vector<int> cells;
+    std::vector<int> offsets;
+    std::vector<uint8_t> types;
+    std::vector<float> scalars;
+    std::vector<double> velocity;
+    std::vector<int64_t> ids;
+    std::vector<uint16_t> marks;
+    std::vector<float> vorticity;
+
+    /* Grid of 3x3x3 points and 2x2x2 hexahedra */
+    for(size_t i = 0; i < 3; ++i)
+        for(size_t j = 0; j < 3; ++j)
+            for(size_t k = 0; k < 3; ++k) {
+                points.push_back(i);
+                points.push_back(j);
+                points.push_back(k);
+            }
+    for(int i = 0; i < 2; ++i)
+        for(int j = 0; j < 2; ++j)
+            for(int k = 0; k < 2; ++k) {
+                const int first = 9 * i + 3 * j + k;
+                const int nodes[8] = { first, first + 9, first + 12, first + 3,
+                        first + 1, first + 10, first + 13, first + 4 };
+                cells.insert(cells.end(), nodes, nodes + 8);
+                offsets.push_back(cells.size());
+                types.push_back(VTK_HEXAHEDRON);
+            }
+
+    for(size_t n = 0; n < 27; ++n) {
+        scalars.push_back(-13.25f + n);
+        velocity.push_back(0.1 * n);
+        velocity.push_back(-1.0 / (n + 1));
+        velocity.push_back(1e-300 * n);
+        vorticity.push_back(0.5f * n - 3.0f);
+    }
+    for(size_t n = 0; n < 8; ++n) {
+        ids.push_back(int64_t(n) * 1000000000007LL - 4000000000000LL);
+        marks.push_back(65535 - n);
+    }
+
+    /* Appended data written by UnstructuredGridWriter: header types, compressors and backends */
+    struct Setup {
+        const char *name;
+        const char *header_type;
+        const char *compressor;
+        bool pipelining;
+        AppendedFileWriter::Backend backend;
+    };
+    const Setup setups[] = {
+        { "raw", "UInt32", "", false, AppendedFileWriter::BACKEND_STREAM },
+        { "uint64", "UInt64", "", false, AppendedFileWriter::BACKEND_VECTORED },
+#ifdef XMLW_WITH_ZLIB
+        { "zlib", "UInt32", "vtkZLibDataCompressor", false, AppendedFileWriter::BACKEND_MAPPED },
+        { "zlib_uint64_pipelined", "UInt64", "vtkZLibDataCompressor", true, AppendedFileWriter::BACKEND_STREAM },
+#endif
+    };
+
+    for(size_t s = 0; s < sizeof(setups) / sizeof(setups[0]); ++s) {
+        const std::string file_name = std::string("roundtrip_") + setups[s].name + ".vtu";
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+
+        writer.SetHeaderType(setups[s].header_type);
+        if (*setups[s].compressor != '\0') {
+            writer.SetCompressor(setups[s].compressor);
+            writer.SetCompressionBlockSize(100);
+        }
+        writer.SetPipelining(setups[s].pipelining);
+        writer.SetBackend(setups[s].backend);
+        writer.SetHeaderPadding(4096);
+        writer.SetPoints(points);
+        writer.SetCells(cells, offsets, types);
+        writer.AddArray("PointData", "scalars", scalars);
+        writer.AddArray("PointData", "velocity", velocity, 3);
+        writer.AddArray("CellData", "ids", ids);
+        writer.AddArray("CellData", "marks", marks);
+
+        if (!writer.Write(file_name)) {
+            std::cerr << "Error! Can't write " << file_name << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+            status = false;
+            continue;
+        }
+
+        if (!OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        if (writer.GetHeaderTypeSize() == sizeof(uint64_t))
+            status = CheckAttribute(reader, file_name, "VTKFile", "header_type", "UInt64") && status;
+        status = CheckAttribute(reader, file_name, "Piece", "NumberOfPoints", "27") && status;
+        status = CheckAttribute(reader, file_name, "Piece", "NumberOfCells", "8") && status;
+        status = CheckArray(reader, file_name, "Points", "Points", points) && status;
+        status = CheckArray(reader, file_name, "Cells", "connectivity", cells) && status;
+        status = CheckArray(reader, file_name, "Cells", "offsets", offsets) && status;
+        status = CheckArray(reader, file_name, "Cells", "types", types) && status;
+        status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+        status = CheckArray(reader, file_name, "PointData", "velocity", velocity) && status;
+        status = CheckArray(reader, file_name, "CellData", "ids", ids) && status;
+        status = CheckArray(reader, file_name, "CellData", "marks", marks) && status;
+        reader.Close();
+
+        /* Data set added to the written file in place */
+        FieldAppender appender;
+        appender.AddArray("PointData", "vorticity", vorticity);
+        if (!appender.Append(file_name)) {
+            std::cerr << "Error! Can't append data set to " << file_name << ". See " << __FILE__ << ":" << __LINE__
+                    << "\n";
+            status = false;
+            continue;
+        }
+
+        if (!OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        status = CheckArray(reader, file_name, "PointData", "vorticity", vorticity) && status;
+        status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+        status = CheckArray(reader, file_name, "Cells", "connectivity", cells) && status;
+        status = CheckArray(reader, file_name, "CellData", "ids", ids) && status;
+    }
+
+    /* Views and empty data sets written by every backend, with and without compression */
+    for(size_t b = 0; b < 3; ++b) {
+        const AppendedFileWriter::Backend backends[3] = { AppendedFileWriter::BACKEND_STREAM,
+                AppendedFileWriter::BACKEND_VECTORED, AppendedFileWriter::BACKEND_MAPPED };
+        std::vector<float> x, y, z, twice;
+        std::vector<double> velocity_y;
+        const std::vector<int> no_cells, no_offsets;
+        const std::vector<uint8_t> no_types;
+
+        for(size_t n = 0; n < 27; ++n) {
+            x.push_back(points[3 * n]);
+            y.push_back(points[3 * n + 1]);
+            z.push_back(points[3 * n + 2]);
+            twice.push_back(2 * scalars[n]);
+            velocity_y.push_back(velocity[3 * n + 1]);
+        }
+
+        for(size_t compressed = 0; compressed < 2; ++compressed) {
+#ifndef XMLW_WITH_ZLIB
+            if (compressed == 1)
+                break;
+#endif
+            std::ostringstream name;
+            name << "roundtrip_views_" << b << (compressed == 1 ? "_zlib" : "") << ".vtu";
+            const std::string file_name = name.str();
+            UnstructuredGridWriter writer;
+            VTK_XML_Reader reader;
+
+            writer.SetBackend(backends[b]);
+            if (compressed == 1)
+                writer.SetCompressor("vtkZLibDataCompressor");
+            writer.SetPoints(MakeSoAView(x.data(), y.data(), z.data(), x.size()));
+            writer.SetCells(no_cells, no_offsets, no_types);
+            writer.AddArray("PointData", "velocity_y", MakeStridedView(&velocity[1], 27, 3 * sizeof(double)));
+            writer.AddArray("PointData", "twice", MakeGeneratedView<float>(27, 1,
+                    [&](size_t first, size_t count, float *out) {
+                for(size_t n = 0; n < count; ++n)
+                    out[n] = 2 * scalars[first + n];
+            }));
+
+            if (!writer.Write(file_name) || !OpenFile(reader, file_name)) {
+                status = false;
+                continue;
+            }
+            status = CheckAttribute(reader, file_name, "Piece", "NumberOfCells", "0") && status;
+            status = CheckArray(reader, file_name, "Points", "Points", points) && status;
+            status = CheckArray(reader, file_name, "Cells", "connectivity", no_cells) && status;
+            status = CheckArray(reader, file_name, "Cells", "offsets", no_offsets) && status;
+            status = CheckArray(reader, file_name, "Cells", "types", no_types) && status;
+            status = CheckArray(reader, file_name, "PointData", "velocity_y", velocity_y) && status;
+            status = CheckArray(reader, file_name, "PointData", "twice", twice) && status;
+        }
+    }
+
+    /* Mapped output preallocates the file: overwriting a larger file gives the same bytes as the stream backend */
+    {
+        const std::string file_name = "roundtrip_mapped.vtu", reference_name = "roundtrip_mapped_stream.vtu";
+        UnstructuredGridWriter large, small;
+        VTK_XML_Reader reader;
+
+        large.SetBackend(AppendedFileWriter::BACKEND_MAPPED);
+        large.SetPoints(points);
+        large.SetCells(cells, offsets, types);
+        large.AddArray("PointData", "velocity", velocity, 3);
+        large.AddArray("PointData", "vorticity", vorticity);
+
+        small.SetPoints(points);
+        small.SetCells(cells, offsets, types);
+        small.AddArray("PointData", "scalars", scalars);
+
+        if (!large.Write(file_name) || !small.Write(reference_name))
+            status = false;
+        else {
+            small.SetBackend(AppendedFileWriter::BACKEND_MAPPED);
+            status = small.Write(file_name) && status;
+
+            std::ifstream mapped(file_name.c_str(), std::ios::binary);
+            std::ifstream stream(reference_name.c_str(), std::ios::binary);
+            const std::string mapped_bytes((std::istreambuf_iterator<char>(mapped)), std::istreambuf_iterator<char>());
+            const std::string stream_bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+            if (mapped_bytes != stream_bytes) {
+                std::cerr << "Error! " << file_name << " (" << mapped_bytes.size() << " Bytes) differs from "
+                        << reference_name << " (" << stream_bytes.size() << " Bytes). See " << __FILE__ << ":"
+                        << __LINE__ << "\n";
+                status = false;
+            }
+            if (OpenFile(reader, file_name)) {
+                status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+                if (reader.FindArray("PointData", "velocity") != NULL) {
+                    std::cerr << "Error! " << file_name << " keeps data sets of the overwritten file. See "
+                            << __FILE__ << ":" << __LINE__ << "\n";
+                    status = false;
+                }
+            }
+            else
+                status = false;
+        }
+    }
+
+    /* Polyhedra described by faces: a hexahedron of six quadrilaterals and a tetrahedron of four triangles */
+    {
+        const std::string file_name = "roundtrip_polyhedra.vtu";
+        const int hexahedron[6][4] = { { 0, 3, 12, 9 }, { 1, 10, 13, 4 }, { 0, 9, 10, 1 }, { 3, 4, 13, 12 },
+                { 0, 1, 4, 3 }, { 9, 12, 13, 10 } };
+        const int tetrahedron[4][3] = { { 13, 14, 16 }, { 13, 14, 22 }, { 13, 16, 22 }, { 14, 16, 22 } };
+        const int64_t unique_nodes[12] = { 0, 3, 12, 9, 1, 10, 13, 4, 13, 14, 16, 22 };
+        std::vector<int> faces_per_cell, face_sizes, face_nodes;
+        std::vector<int64_t> connectivity(unique_nodes, unique_nodes + 12), faces;
+        std::vector<int64_t> poly_offsets, faceoffsets;
+        std::vector<uint8_t> poly_types(2, VTK_POLYHEDRON);
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+
+        faces_per_cell.push_back(6);
+        faces_per_cell.push_back(4);
+        faces.push_back(6);
+        for(size_t f = 0; f < 6; ++f) {
+            face_sizes.push_back(4);
+            face_nodes.insert(face_nodes.end(), hexahedron[f], hexahedron[f] + 4);
+            faces.push_back(4);
+            faces.insert(faces.end(), hexahedron[f], hexahedron[f] + 4);
+        }
+        faceoffsets.push_back(faces.size());
+        faces.push_back(4);
+        for(size_t f = 0; f < 4; ++f) {
+            face_sizes.push_back(3);
+            face_nodes.insert(face_nodes.end(), tetrahedron[f], tetrahedron[f] + 3);
+            faces.push_back(3);
+            faces.insert(faces.end(), tetrahedron[f], tetrahedron[f] + 3);
+        }
+        faceoffsets.push_back(faces.size());
+        poly_offsets.push_back(8);
+        poly_offsets.push_back(12);
+
+        writer.SetPoints(points);
+        writer.SetPolyhedra(faces_per_cell, face_sizes, face_nodes);
+        if (!writer.Write(file_name) || !OpenFile(reader, file_name))
+            status = false;
+        else {
+            status = CheckAttribute(reader, file_name, "Piece", "NumberOfCells", "2") && status;
+            status = CheckArray(reader, file_name, "Cells", "connectivity", connectivity) && status;
+            status = CheckArray(reader, file_name, "Cells", "offsets", poly_offsets) && status;
+            status = CheckArray(reader, file_name, "Cells", "types", poly_types) && status;
+            status = CheckArray(reader, file_name, "Cells", "faces", faces) && status;
+            status = CheckArray(reader, file_name, "Cells", "faceoffsets", faceoffsets) && status;
+        }
+    }
+
+    /* Blocks of Lagrange quadrilaterals of the second order followed by a linear hexahedron */
+    {
+        const std::string file_name = "roundtrip_lagrange.vtu";
+        std::vector<UnstructuredGridWriter::CellBlock> blocks;
+        std::vector<int> connectivity, lagrange_offsets;
+        std::vector<uint8_t> lagrange_types, degrees;
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+
+        blocks.push_back(UnstructuredGridWriter::CellBlock(VTK_LAGRANGE_QUADRILATERAL, 2, 0, 2));
+        blocks.push_back(UnstructuredGridWriter::CellBlock(VTK_HEXAHEDRON, 1));
+        for(int n = 0; n < 18; ++n)
+            connectivity.push_back(n);
+        connectivity.insert(connectivity.end(), cells.begin(), cells.begin() + 8);
+        for(size_t c = 0; c < 2; ++c) {
+            lagrange_offsets.push_back(9 * (c + 1));
+            lagrange_types.push_back(VTK_LAGRANGE_QUADRILATERAL);
+            degrees.insert(degrees.end(), 3, 2);
+        }
+        lagrange_offsets.push_back(26);
+        lagrange_types.push_back(VTK_HEXAHEDRON);
+        degrees.insert(degrees.end(), 3, 0);
+
+        writer.SetPoints(points);
+        writer.SetCells(blocks, connectivity);
+        if (!writer.Write(file_name) || !OpenFile(reader, file_name))
+            status = false;
+        else {
+            status = CheckAttribute(reader, file_name, "Piece", "NumberOfCells", "3") && status;
+            status = CheckArray(reader, file_name, "Cells", "connectivity", connectivity) && status;
+            status = CheckArray(reader, file_name, "Cells", "offsets", lagrange_offsets) && status;
+            status = CheckArray(reader, file_name, "Cells", "types", lagrange_types) && status;
+            status = CheckArray(reader, file_name, "CellData", "HigherOrderDegrees", degrees) && status;
+        }
+    }
+
+    /* Identical data sets (copies and generated ones) share an offset, a data set differing in one value doesn't */
+    for(size_t compressed = 0; compressed < 2; ++compressed) {
+#ifndef XMLW_WITH_ZLIB
+        if (compressed == 1)
+            break;
+#endif
+        const std::string file_name = compressed == 1 ? "roundtrip_dedup_zlib.vtu" : "roundtrip_dedup.vtu";
+        const char *shared[] = { "scalars", "copy", "generated" };
+        std::vector<float> copy(scalars), almost(scalars);
+        std::vector<uint16_t> marks_copy(marks);
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+
+        almost.back() += 1;
+        writer.SetDeduplication(true);
+        if (compressed == 1)
+            writer.SetCompressor("vtkZLibDataCompressor");
+        writer.SetPoints(points);
+        writer.SetCells(cells, offsets, types);
+        writer.AddArray("PointData", "scalars", scalars);
+        writer.AddArray("PointData", "copy", copy);
+        writer.AddArray("PointData", "generated", MakeGeneratedView<float>(27, 1,
+                [&](size_t first, size_t count, float *out) {
+            std::copy(scalars.begin() + first, scalars.begin() + first + count, out);
+        }));
+        writer.AddArray("PointData", "almost", almost);
+        writer.AddArray("CellData", "marks", marks);
+        writer.AddArray("CellData", "marks_copy", marks_copy);
+
+        if (!writer.Write(file_name) || !OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        bool loaded = true;
+        for(size_t n = 0; n < 3; ++n)
+            loaded = CheckArray(reader, file_name, "PointData", shared[n], scalars) && loaded;
+        loaded = CheckArray(reader, file_name, "PointData", "almost", almost) && loaded;
+        loaded = CheckArray(reader, file_name, "CellData", "marks", marks) && loaded;
+        loaded = CheckArray(reader, file_name, "CellData", "marks_copy", marks) && loaded;
+        if (!loaded) {
+            status = false;
+            continue;
+        }
+
+        const size_t offset = reader.FindArray("PointData", "scalars")->offset;
+        const size_t marks_offset = reader.FindArray("CellData", "marks")->offset;
+        if (reader.FindArray("PointData", "copy")->offset != offset
+                || reader.FindArray("PointData", "generated")->offset != offset
+                || reader.FindArray("PointData", "almost")->offset == offset
+                || reader.FindArray("CellData", "marks_copy")->offset != marks_offset) {
+            std::cerr << "Error! Data sets of " << file_name << " are deduplicated wrongly. See " << __FILE__
+                    << ":" << __LINE__ << "\n";
+            status = false;
+        }
+    }
+
+    /* Successive appends consume the header padding, an append which doesn't fit or repeats a name changes nothing */
+    {
+        const std::string file_name = "roundtrip_append.vtu";
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+
+        writer.SetHeaderPadding(512);
+        writer.SetPoints(points);
+        writer.SetCells(cells, offsets, types);
+        writer.AddArray("PointData", "scalars", scalars);
+        status = writer.Write(file_name) && status;
+
+        FieldAppender first, second;
+        first.AddArray("PointData", "vorticity", vorticity);
+        second.AddArray("CellData", "marks", marks);
+        status = first.Append(file_name) && second.Append(file_name) && status;
+
+        FieldAppender repeated, too_large;
+        std::vector<std::string> names;
+        repeated.AddArray("CellData", "marks", ids);
+        for(size_t n = 0; n < 20; ++n) {
+            std::ostringstream name;
+            name << "field_" << n;
+            names.push_back(name.str());
+            too_large.AddArray("PointData", names.back(), scalars);
+        }
+
+        std::ifstream before_stream(file_name.c_str(), std::ios::binary);
+        const std::string before((std::istreambuf_iterator<char>(before_stream)), std::istreambuf_iterator<char>());
+        before_stream.close();
+        const bool appended = repeated.Append(file_name) || too_large.Append(file_name);
+        std::ifstream after_stream(file_name.c_str(), std::ios::binary);
+        const std::string after((std::istreambuf_iterator<char>(after_stream)), std::istreambuf_iterator<char>());
+        if (appended || after != before) {
+            std::cerr << "Error! Failed append changed " << file_name << ". See " << __FILE__ << ":" << __LINE__
+                    << "\n";
+            status = false;
+        }
+
+        if (OpenFile(reader, file_name)) {
+            status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+            status = CheckArray(reader, file_name, "PointData", "vorticity", vorticity) && status;
+            status = CheckArray(reader, file_name, "CellData", "marks", marks) && status;
+            status = CheckArray(reader, file_name, "Cells", "connectivity", cells) && status;
+        }
+        else
+            status = false;
+    }
+
+    /* Float64 conversion is applied when the file is written, the geometry is never quantized */
+    for(size_t step = 0; step < 2; ++step) {
+        const std::string file_name = "roundtrip_conversion.vtu";
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+        std::vector<double> points64(points.begin(), points.end());
+        std::vector<double> field(velocity);
+        std::vector<uint16_t> quantized;
+        std::vector<float> rounded;
+
+        /* The range of the second file is ten times wider */
+        for(size_t n = 0; n < field.size(); ++n)
+            field[n] *= (step + 1) * 10.;
+
+        writer.SetPoints(points64);
+        writer.SetCells(cells, offsets, types);
+        writer.AddArray("PointData", "velocity", field, 3);
+        writer.AddArray("CellData", "ids", ids);
+        writer.SetFloat64Conversion(AppendedFileWriter::CONVERSION_UINT16);
+
+        if (!writer.Write(file_name) || !OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        status = CheckArray(reader, file_name, "Points", "Points", points64) && status;
+        status = CheckArray(reader, file_name, "CellData", "ids", ids) && status;
+
+        const ArrayInfo *arr = reader.FindArray("PointData", "velocity");
+        if (arr == NULL || !reader.ReadArray(*arr, quantized) || quantized.size() != field.size()) {
+            std::cerr << "Error! Quantized data set of " << file_name << " can't be read. See " << __FILE__ << ":"
+                    << __LINE__ << "\n";
+            status = false;
+            continue;
+        }
+        const double scale = std::strtod(GetValue(arr->attributes, "Scale").c_str(), NULL);
+        const double shift = std::strtod(GetValue(arr->attributes, "Shift").c_str(), NULL);
+        for(size_t n = 0; n < field.size(); ++n) {
+            if (std::abs(quantized[n] * scale + shift - field[n]) > 0.5 * scale * (1. + 1e-9)) {
+                std::cerr << "Error! Value " << n << " of the quantized data set of " << file_name
+                        << " is out of range. See " << __FILE__ << ":" << __LINE__ << "\n";
+                status = false;
+                break;
+            }
+        }
+
+        /* Rounding to Float32 is applied to the geometry as well */
+        writer.SetFloat64Conversion(AppendedFileWriter::CONVERSION_FLOAT32);
+        if (!writer.Write(file_name) || !OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        for(size_t n = 0; n < field.size(); ++n)
+            rounded.push_back(field[n]);
+        status = CheckArray(reader, file_name, "Points", "Points", points) && status;
+        status = CheckArray(reader, file_name, "PointData", "velocity", rounded) && status;
+    }
+
+    /* Every step of a time series is written unless repeated steps are allowed to refer to the previous file */
+    for(size_t skip = 0; skip < 2; ++skip) {
+        const std::string collection = "roundtrip_series.pvd";
+        TimeSeriesWriter series(collection);
+        VTK_XML_Reader reader;
+        std::vector<float> field(scalars);
+        const size_t expected[3] = { 0, size_t(skip == 1 ? 0 : 1), 2 };
+
+        series.SetSkipUnchanged(skip == 1);
+        series.SetStaticGeometry(true);
+        for(size_t step = 0; step < 3; ++step) {
+            UnstructuredGridWriter writer;
+            if (step == 2)
+                field[0] += 1.f;
+            writer.SetPoints(points);
+            writer.SetCells(cells, offsets, types);
+            writer.AddArray("PointData", "field", field);
+            if (!series.Write(writer, 0.1 * step, "roundtrip_series_" + std::to_string(step) + ".vtu"))
+                status = false;
+        }
+
+        if (series.GetNumberOfFiles() != (skip == 1 ? 2u : 3u) || !OpenFile(reader, collection)) {
+            std::cerr << "Error! " << series.GetNumberOfFiles() << " files of the time series are written. See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            status = false;
+            continue;
+        }
+        for(size_t step = 0; step < 3; ++step) {
+            status = CheckAttribute(reader, collection, "DataSet", "file",
+                    "roundtrip_series_" + std::to_string(expected[step]) + ".vtu", step) && status;
+            if (std::strtod(reader.GetAttribute("DataSet", "timestep", step).c_str(), NULL) != 0.1 * step) {
+                std::cerr << "Error! Time of step " << step << " of " << collection << " differs. See " << __FILE__
+                        << ":" << __LINE__ << "\n";
+                status = false;
+            }
+        }
+
+        const std::string last_file = "roundtrip_series_2.vtu";
+        if (OpenFile(reader, last_file))
+            status = CheckArray(reader, last_file, "PointData", "field", field) && status;
+        else
+            status = false;
+    }
+
+    /* Structured grids: ImageData with origin and spacing, RectilinearGrid with coordinates along the axes */
+    {
+        const std::string file_name = "roundtrip_image.vti";
+        ImageDataWriter writer;
+        VTK_XML_Reader reader;
+
+        writer.SetDimensions(3, 3, 3);
+        writer.SetOrigin(1, -2, 0.5);
+        writer.SetSpacing(0.25, 2, 4);
+        writer.AddArray("PointData", "scalars", scalars);
+        writer.AddArray("PointData", "velocity", velocity, 3);
+
+        if (!writer.Write(file_name) || !OpenFile(reader, file_name))
+            status = false;
+        else {
+            status = CheckAttribute(reader, file_name, "ImageData", "WholeExtent", "0 2 0 2 0 2") && status;
+            status = CheckAttribute(reader, file_name, "ImageData", "Origin", "1 -2 0.5") && status;
+            status = CheckAttribute(reader, file_name, "ImageData", "Spacing", "0.25 2 4") && status;
+            status = CheckAttribute(reader, file_name, "Piece", "Extent", "0 2 0 2 0 2") && status;
+            status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+            status = CheckArray(reader, file_name, "PointData", "velocity", velocity) && status;
+        }
+    }
+    {
+        std::vector<double> x, y, z, x_old(2, 0.), y_old(2, 0.), z_old(2, 0.);
+        std::vector<float> field;
+        for(size_t n = 0; n < 3; ++n)
+            x.push_back(0.5 * n * n);
+        for(size_t n = 0; n < 2; ++n)
+            y.push_back(-1.0 - n);
+        for(size_t n = 0; n < 4; ++n)
+            z.push_back(1e-3 * n);
+        for(size_t n = 0; n < 24; ++n)
+            field.push_back(0.75f * n);
+
+        /* The extent follows replaced coordinates unless it is set explicitly, also through the base class */
+        RectilinearGridWriter deduced, explicit_extent;
+        AppendedFileWriter &base = explicit_extent;
+        deduced.SetCoordinates(x_old, y_old, z_old);
+        deduced.SetCoordinates(x, y, z);
+        base.SetExtent(1, 3, 0, 1, 0, 3);
+        explicit_extent.SetCoordinates(x, y, z);
+
+        RectilinearGridWriter *writers[2] = { &deduced, &explicit_extent };
+        const char *extents[2] = { "0 2 0 1 0 3", "1 3 0 1 0 3" };
+        for(size_t w = 0; w < 2; ++w) {
+            std::ostringstream name;
+            name << "roundtrip_rectilinear_" << w << ".vtr";
+            const std::string file_name = name.str();
+            VTK_XML_Reader reader;
+
+            writers[w]->AddArray("PointData", "field", field);
+            if (!writers[w]->Write(file_name) || !OpenFile(reader, file_name)) {
+                status = false;
+                continue;
+            }
+            status = CheckAttribute(reader, file_name, "RectilinearGrid", "WholeExtent", extents[w]) && status;
+            status = CheckAttribute(reader, file_name, "Piece", "Extent", extents[w]) && status;
+            status = CheckArray(reader, file_name, "Coordinates", "x", x) && status;
+            status = CheckArray(reader, file_name, "Coordinates", "y", y) && status;
+            status = CheckArray(reader, file_name, "Coordinates", "z", z) && status;
+            status = CheckArray(reader, file_name, "PointData", "field", field) && status;
+        }
+    }
+
+    /* Writers queued by AsyncWriter keep their class: the grid is written, then a data set is appended to it */
+    {
+        const std::string file_name = "roundtrip_async.vtu";
+        AsyncWriter async;
+        UnstructuredGridWriter writer;
+        FieldAppender appender;
+        VTK_XML_Reader reader;
+
+        writer.SetHeaderPadding(4096);
+        writer.SetPoints(points);
+        writer.SetCells(cells, offsets, types);
+        writer.AddArray("PointData", "scalars", scalars);
+        appender.AddArray("PointData", "vorticity", vorticity);
+
+        std::future<bool> grid_written = async.Write(writer, file_name);
+        std::future<bool> field_appended = async.Write(appender, file_name);
+        if (!grid_written.get() || !field_appended.get()) {
+            std::cerr << "Error! Can't write " << file_name << " in the background. See " << __FILE__ << ":"
+                    << __LINE__ << "\n";
+            status = false;
+        }
+        else if (OpenFile(reader, file_name)) {
+            status = CheckAttribute(reader, file_name, "Piece", "NumberOfCells", "8") && status;
+            status = CheckArray(reader, file_name, "Cells", "connectivity", cells) && status;
+            status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+            status = CheckArray(reader, file_name, "PointData", "vorticity", vorticity) && status;
+        }
+        else
+            status = false;
+    }
+
+    /* Base64 of short inputs: tails of the vectorized kernels, unaligned input and chunked writing */
+    {
+        std::vector<unsigned char> bytes(80);
+        for(size_t n = 0; n < bytes.size(); ++n)
+            bytes[n] = (unsigned char)(n * 97 + 13);
+
+        for(size_t size = 0; size <= 70; ++size) {
+            for(size_t shift = 0; shift < 4; ++shift) {
+                const unsigned char *in = &bytes[shift];
+                const std::string expected = EncodeBase64Reference(in, size);
+                std::string encoded(Base64Encoder::EncodedSize(size), ' ');
+                std::vector<char> decoded(size + 1, 0);
+                Base64Encoder chunked(6);
+                std::ostringstream ostr;
+
+                const size_t length = Base64Encoder::Encode((const char*)in, size, &encoded[0]);
+                chunked.Write((const char*)in, size, ostr);
+                const bool valid = Base64Encoder::Decode(expected.data(), expected.size(), decoded.data());
+                if (length != expected.size() || encoded != expected || ostr.str() != expected || !valid
+                        || Base64Encoder::DecodedSize(expected.data(), expected.size()) != size
+                        || !std::equal(in, in + size, (const unsigned char*)decoded.data())) {
+                    std::cerr << "Error! Kernel " << Base64Encoder::GetKernelName() << " encodes " << size
+                            << " Bytes at offset " << shift << " as '" << encoded << "' instead of '" << expected
+                            << "'. See " << __FILE__ << ":" << __LINE__ << "\n";
+                    status = false;
+                }
+            }
+        }
+    }
+
+    /* Data sets inside the main body: binary (base64) with both header types and ASCII formats */
+    struct Inline {
+        const char *name;
+        const char *format;
+        const char *header_type;
+    };
+    const Inline variants[] = {
+        { "binary", "binary", "UInt32" },
+        { "binary_uint64", "binary", "UInt64" },
+        { "ascii", "ascii", "UInt32" },
+    };
+    for(size_t f = 0; f < sizeof(variants) / sizeof(variants[0]); ++f) {
+        const std::string file_name = std::string("roundtrip_") + variants[f].name + ".vtu";
+        const std::string format = variants[f].format;
+        const bool binary = format == "binary";
+        VTK_XML_Writer wxml;
+        VTK_XML_Reader reader;
+        std::ofstream os(file_name.c_str(), std::ios::out | std::ios::binary);
+
+#ifdef XMLW_WITH_ZLIB
+        if (binary)
+            wxml.SetCompressor("vtkZLibDataCompressor");
+#endif
+        wxml.SetHeaderType(variants[f].header_type);
+        wxml.SetAsciiValuesPerLine(7);
+
+        wxml.Header(os);
+        wxml.OpenVTKSection("UnstructuredGrid", os);
+            wxml.OpenSection("UnstructuredGrid", os);
+                wxml.OpenPieceSection(27, 8, os);
+
+                    wxml.OpenPointDataSection("scalars", os);
+                        wxml.OpenDataArrSection("Float32", "scalars", 1, format, os);
+                        if (binary)
+                            wxml.WriteBinaryData(scalars, os);
+                        else
+                            wxml.WriteData(scalars, os);
+                        wxml.CloseDataArrSection(os);
+
+                        wxml.OpenDataArrSection("Float64", "velocity", 3, format, os);
+                        if (binary)
+                            wxml.WriteBinaryData(velocity, os);
+                        else
+                            wxml.WriteData(velocity, os);
+                        wxml.CloseDataArrSection(os);
+                    wxml.ClosePointDataSection(os);
+
+                    wxml.OpenSection("CellData", os);
+                        wxml.OpenDataArrSection("Int64", "ids", 1, format, os);
+                        if (binary)
+                            wxml.WriteBinaryData(ids, os);
+                        else
+                            wxml.WriteData(ids, os);
+                        wxml.CloseDataArrSection(os);
+                    wxml.CloseSection("CellData", os);
+
+                    wxml.OpenSection("Points", os);
+                        wxml.OpenDataArrSection("Float32", "points", 3, format, os);
+                        if (binary)
+                            wxml.WriteBinaryData(points, os);
+                        else
+                            wxml.WriteData(points, os);
+                        wxml.CloseDataArrSection(os);
+                    wxml.CloseSection("Points", os);
+
+                    wxml.OpenSection("Cells", os);
+                        wxml.OpenDataArrSection("Int32", "connectivity", 1, format, os);
+                        if (binary)
+                            wxml.WriteBinaryData(cells, os);
+                        else
+                            wxml.WriteData(cells, os);
+                        wxml.CloseDataArrSection(os);
+
+                        wxml.OpenDataArrSection("UInt8", "types", 1, format, os);
+                        if (binary)
+                            wxml.WriteBinaryData(types, os);
+                        else
+                            wxml.WriteData(types, os);
+                        wxml.CloseDataArrSection(os);
+                    wxml.CloseSection("Cells", os);
+
+                wxml.ClosePieceSection(os);
+            wxml.CloseSection("UnstructuredGrid", os);
+        wxml.CloseVTKSection(os);
+        os.close();
+
+        if (!OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        if (wxml.GetHeaderTypeSize() == sizeof(uint64_t))
+            status = CheckAttribute(reader, file_name, "VTKFile", "header_type", "UInt64") && status;
+        status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+        status = CheckArray(reader, file_name, "PointData", "velocity", velocity) && status;
+        status = CheckArray(reader, file_name, "CellData", "ids", ids) && status;
+        status = CheckArray(reader, file_name, "Points", "points", points) && status;
+        status = CheckArray(reader, file_name, "Cells", "connectivity", cells) && status;
+        status = CheckArray(reader, file_name, "Cells", "types", types) && status;
+    }
+
+    /* Compressed appended data with small blocks: partial last blocks, a single full block and an empty data set */
+    std::vector<std::string> compressors;
+#ifdef XMLW_WITH_ZLIB
+    compressors.push_back("vtkZLibDataCompressor");
+#endif
+#ifdef XMLW_WITH_LZ4
+    compressors.push_back("vtkLZ4DataCompressor");
+#endif
+    for(size_t c = 0; c < compressors.size(); ++c) {
+        const std::string file_name = "roundtrip_blocks_" + compressors[c] + ".vtu";
+        VTK_XML_Writer wxml;
+        VTK_XML_Reader reader;
+        std::ostringstream appended;
+        std::ofstream os(file_name.c_str(), std::ios::out | std::ios::binary);
+        const std::vector<float> block(scalars.begin(), scalars.begin() + 25);
+        const std::vector<float> empty;
+        size_t offsets[4] = { 0, 0, 0, 0 };
+
+        wxml.SetCompressor(compressors[c]);
+        wxml.SetCompressionBlockSize(100);
+        offsets[1] = offsets[0] + wxml.AppendData(scalars, appended);
+        offsets[2] = offsets[1] + wxml.AppendData(velocity, appended);
+        offsets[3] = offsets[2] + wxml.AppendData(block, appended);
+        if (offsets[1] == offsets[0] || offsets[2] == offsets[1] || offsets[3] == offsets[2]
+                || wxml.AppendData(empty, appended) == 0) {
+            std::cerr << "Error! Can't compress data sets of " << file_name << ". See " << __FILE__ << ":"
+                    << __LINE__ << "\n";
+            status = false;
+            continue;
+        }
+
+        wxml.Header(os);
+        wxml.OpenVTKSection("UnstructuredGrid", os);
+            wxml.OpenSection("UnstructuredGrid", os);
+                wxml.OpenSection("FieldData", os);
+                    wxml.OpenDataArrSection("Float32", "scalars", 1, "appended", offsets[0], os);
+                    wxml.CloseDataArrSection(os);
+                    wxml.OpenDataArrSection("Float64", "velocity", 3, "appended", offsets[1], os);
+                    wxml.CloseDataArrSection(os);
+                    wxml.OpenDataArrSection("Float32", "block", 1, "appended", offsets[2], os);
+                    wxml.CloseDataArrSection(os);
+                    wxml.OpenDataArrSection("Float32", "empty", 1, "appended", offsets[3], os);
+                    wxml.CloseDataArrSection(os);
+                wxml.CloseSection("FieldData", os);
+            wxml.CloseSection("UnstructuredGrid", os);
+            wxml.OpenSection("AppendedData encoding=\"raw\"", os);
+        os << "_" << appended.str();
+        wxml.CloseSection("AppendedData", os);
+        wxml.CloseVTKSection(os);
+        os.close();
+
+        if (!OpenFile(reader, file_name)) {
+            status = false;
+            continue;
+        }
+        status = CheckAttribute(reader, file_name, "VTKFile", "compressor", compressors[c]) && status;
+        status = CheckArray(reader, file_name, "FieldData", "scalars", scalars) && status;
+        status = CheckArray(reader, file_name, "FieldData", "velocity", velocity) && status;
+        status = CheckArray(reader, file_name, "FieldData", "block", block) && status;
+        status = CheckArray(reader, file_name, "FieldData", "empty", empty) && status;
+    }
+
+#ifdef XMLW_WITH_ZLIB
+    /* Data sets which can't be compressed (the level is invalid) aren't written at all */
+    {
+        VTK_XML_Writer wxml;
+        std::ostringstream ostr;
+
+        wxml.SetCompressor("vtkZLibDataCompressor", 42);
+        if (wxml.WriteBinaryData(scalars, ostr) != 0 || wxml.AppendData(scalars, ostr) != 0
+                || wxml.AppendData(MakeStridedView(velocity.data(), 27, 3 * sizeof(double), 1), ostr) != 0
+                || !ostr.str().empty()) {
+            std::cerr << "Error! Data sets are written although they can't be compressed. See "
+                    << __FILE__ << ":" << __LINE__ << "\n";
+            status = false;
+        }
+    }
+
+    /* A file which can't be written leaves the previous one intact, with or without pipelining */
+    {
+        const std::string file_name = "roundtrip_failed.vtu";
+        UnstructuredGridWriter writer;
+        VTK_XML_Reader reader;
+
+        writer.SetPoints(points);
+        writer.SetCells(cells, offsets, types);
+        writer.AddArray("PointData", "scalars", scalars);
+        status = writer.Write(file_name) && status;
+
+        writer.SetCompressor("vtkZLibDataCompressor", 42);
+        for(size_t pipelining = 0; pipelining < 2; ++pipelining) {
+            writer.SetPipelining(pipelining == 1);
+            if (writer.Write(file_name) || std::ifstream((file_name + ".part").c_str()).good()) {
+                std::cerr << "Error! Failed write of " << file_name << " left a file behind. See " << __FILE__
+                        << ":" << __LINE__ << "\n";
+                status = false;
+            }
+        }
+
+        if (OpenFile(reader, file_name))
+            status = CheckArray(reader, file_name, "PointData", "scalars", scalars) && status;
+        else
+            status = false;
+    }
+#endif
+
+    /* File with two pieces sharing the appended section, offsets account for the size of the header type */
+    const char *header_types[] = { "UInt32", "UInt64" };
+    for(size_t h = 0; h < 2; ++h) {
+        const std::string file_name = std::string("roundtrip_pieces_") + header_types[h] + ".vtu";
+        VTK_XML_Writer wxml;
+        wxml.SetHeaderType(header_types[h]);
+        VTK_XML_Reader reader;
+        std::ostringstream ostr;
+        std::ofstream os(file_name.c_str(), std::ios::out | std::ios::binary);
+        std::vector<float> points2(points.begin(), points.begin() + 9 * 3);
+        std::vector<float> scalars2(vorticity.begin(), vorticity.begin() + 9);
+        const std::string format = "appended";
+        const size_t size_of_dt = wxml.GetHeaderTypeSize();
+        size_t bofs = 0;
+
+        wxml.Header(ostr);
+        wxml.OpenVTKSection("UnstructuredGrid", ostr);
+            wxml.OpenSection("UnstructuredGrid", ostr);
+                wxml.OpenPieceSection(27, 0, ostr);
+                    wxml.OpenPointDataSection("scalars", ostr);
+                        wxml.OpenDataArrSection("Float32", "scalars", 1, format, bofs, ostr);
+                        bofs += wxml.CountOffset(scalars) + size_of_dt;
+                        wxml.CloseDataArrSection(ostr);
+                    wxml.ClosePointDataSection(ostr);
+
+                    wxml.OpenSection("Points", ostr);
+                        wxml.OpenDataArrSection("Float32", "points", 3, format, bofs, ostr);
+                        bofs += wxml.CountOffset(points) + size_of_dt;
+                        wxml.CloseDataArrSection(ostr);
+                    wxml.CloseSection("Points", ostr);
+                wxml.ClosePieceSection(ostr);
+
+                wxml.OpenPieceSection(9, 0, ostr);
+                    wxml.OpenPointDataSection("scalars", ostr);
+                        wxml.OpenDataArrSection("Float32", "scalars", 1, format, bofs, ostr);
+                        bofs += wxml.CountOffset(scalars2) + size_of_dt;
+                        wxml.CloseDataArrSection(ostr);
+                    wxml.ClosePointDataSection(ostr);
+
+                    wxml.OpenSection("Points", ostr);
+                        wxml.OpenDataArrSection("Float32", "points", 3, format, bofs, ostr);
+                        bofs += wxml.CountOffset(points2) + size_of_dt;
+                        wxml.CloseDataArrSection(ostr);
+                    wxml.CloseSection("Points", ostr);
+                wxml.ClosePieceSection(ostr);
+            wxml.CloseSection("UnstructuredGrid", ostr);
+
+            wxml.OpenSection("AppendedData encoding=\"raw\"", ostr);
+
+        os << ostr.str();
+        os << "_";
+        wxml.AppendData(scalars, os);
+        wxml.AppendData(points, os);
+        wxml.AppendData(scalars2, os);
+        wxml.AppendData(points2, os);
+
+        wxml.CloseSection("AppendedData", os);
+        wxml.CloseVTKSection(os);
+        os.close();
+
+        if (OpenFile(reader, file_name)) {
+            if (reader.GetNumberOfPieces() != 2) {
+                std::cerr << "Error! " << file_name << " has " << reader.GetNumberOfPieces()
+                        << " pieces instead of 2. See " << __FILE__ << ":" << __LINE__ << "\n";
+                status = false;
+            }
+            if (size_of_dt == sizeof(uint64_t))
+                status = CheckAttribute(reader, file_name, "VTKFile", "header_type", "UInt64") && status;
+            status = CheckAttribute(reader, file_name, "Piece", "NumberOfPoints", "9", 1) && status;
+            status = CheckArray(reader, file_name, "PointData", "scalars", scalars, 0) && status;
+            status = CheckArray(reader, file_name, "Points", "points", points, 0) && status;
+            status = CheckArray(reader, file_name, "PointData", "scalars", scalars2, 1) && status;
+            status = CheckArray(reader, file_name, "Points", "points", points2, 1) && status;
+        }
+        else
+            status = false;
+    }
+
+    return status;
+}
+
+}
@@ -0,0 +1,307 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef XMLREADER_H_
+#define XMLREADER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+
+#include "VTKTypeTraits.h"
+
+namespace xmlw {
+
+class ThreadPool;
+class DataCompressor;
+
+/*!
+ * \class VTK_XML_Reader
+ * \brief Reads VTK XML files written by this library (restarts, post-processing, round-trip checks)
+ * The file is mapped into memory, only the main body is parsed when the file is opened: attributes of all elements
+ * are kept and every 'DataArray' of every piece is indexed by its section, name, type, number of components and
+ * position in the file. Data sets are touched only when they are requested, so the pages of data sets which are
+ * never read are never loaded from the disk.
+ * Uncompressed data sets of the appended section are accessed in place (see GetRawData() and GetData()), any data
+ * set can be copied into a buffer of the caller (see ReadData() and ReadArray()): compressed blocks are decompressed
+ * by the threads of the pool (see SetNumberOfThreads()), data sets in the binary mode are decoded from base64 and
+ * the ASCII ones are parsed.
+ * If the byte order of the file differs from the one of the system, values are swapped while they are copied and
+ * data sets can't be accessed in place.
+ * Typical usage:
+ *   xmlw::VTK_XML_Reader reader;
+ *   if (reader.Open("result.vtu")) {
+ *       const xmlw::VTK_XML_Reader::ArrayInfo *arr = reader.FindArray("PointData", "pressure");
+ *       std::vector<double> pressure;
+ *       if (arr != NULL && reader.ReadArray(*arr, pressure))
+ *           ...
+ *   }
+ * \note Only features used by the writers of this library are supported: raw (not base64 encoded) appended data,
+ * "vtkZLibDataCompressor" and "vtkLZ4DataCompressor" (if enabled at build time).
+ */
+class VTK_XML_Reader {
+public:
+
+    /*!
+     * \brief Description of a single data set of the file
+     */
+    struct ArrayInfo {
+        std::string section;        //!< Name of the section ("PointData", "CellData", "Points", ...)
+        std::string name;           //!< The name of the data set (empty if not given)
+        std::string type;           //!< Data type (Int32, Float32, ...)
+        size_t num_of_comp;         //!< Number of components
+        size_t piece;               //!< Index of the piece the data set belongs to
+        std::string format;         //!< Format of the data set ("ascii", "binary" or "appended")
+        size_t offset;              //!< Offset in the appended section or position of the text in the file
+        size_t length;              //!< Length of the text in the file (ascii and binary formats)
+        std::map<std::string, std::string> attributes; //!< All attributes of the 'DataArray' section
+    };
+
+    /*!
+     * \brief Element of the main body of the file with its attributes ('DataArray' sections are kept separately)
+     */
+    struct Element {
+        std::string name;           //!< Name of the element
+        std::map<std::string, std::string> attributes; //!< Attributes of the element
+    };
+
+    /*!
+     * \brief Default constructor
+     */
+    VTK_XML_Reader();
+
+    /*!
+     * \brief Destructor, closes the file
+     */
+    ~VTK_XML_Reader();
+
+    /*!
+     * \brief Maps the file into memory and indexes its data sets
+     * @param file_name Name of the file
+     * @return True if the file was successfully opened and parsed
+     */
+    bool Open(const std::string file_name);
+
+    /*!
+     * \brief Releases the file, all pointers returned by GetRawData() and GetData() become invalid
+     */
+    void Close();
+
+    /*!
+     * \brief Returns true if a file is opened
+     */
+    bool IsOpen() const;
+
+    /*!
+     * \brief Returns type of the data set of the file (UnstructuredGrid, StructuredGrid, ImageData, ...)
+     */
+    const std::string &GetFileType() const;
+
+    /*!
+     * \brief Returns value of the attribute of an element of the main body
+     * @param element Name of the element ("VTKFile", "Piece", "ImageData", ...)
+     * @param attribute Name of the attribute
+     * @param index Index of the element among the elements with the same name (e.g. of the piece)
+     * @return Value of the attribute, empty if not found
+     */
+    std::string GetAttribute(const std::string element, const std::string attribute, const size_t index = 0) const;
+
+    /*!
+     * \brief Returns all elements of the main body except of 'DataArray' sections, in the order of the file
+     */
+    const std::vector<Element> &GetElements() const;
+
+    /*!
+     * \brief Returns number of pieces in the file
+     */
+    size_t GetNumberOfPieces() const;
+
+    /*!
+     * \brief Returns number of data sets in the file (of all pieces)
+     */
+    size_t GetNumberOfArrays() const;
+
+    /*!
+     * \brief Returns description of the data set
+     * @param n Index of the data set in the order of the file
+     */
+    const ArrayInfo &GetArray(const size_t n) const;
+
+    /*!
+     * \brief Finds data set by its section and name
+     * @param section Name of the section ("PointData", "CellData", "Points", "Coordinates" or "Cells")
+     * @param name The name of the data set (may be empty for the points)
+     * @param piece Index of the piece
+     * @return Description of the data set, NULL if not found
+     */
+    const ArrayInfo *FindArray(const std::string section, const std::string name, const size_t piece = 0) const;
+
+    /*!
+     * \brief Returns size of the decoded data set in Bytes
+     * \note The ASCII data sets are scanned to count their values
+     * @param arr Description of the data set
+     * @return Size in Bytes, 0 if the data set is broken
+     */
+    size_t GetNumberOfBytes(const ArrayInfo &arr) const;
+
+    /*!
+     * \brief Returns number of values (components of all elements) of the data set
+     * @param arr Description of the data set
+     */
+    size_t GetNumberOfValues(const ArrayInfo &arr) const;
+
+    /*!
+     * \brief Returns pointer to the data set inside the mapped file (zero-copy access)
+     * Only uncompressed data sets of the appended section are stored in the file as they are. The pointer may be
+     * unaligned and is valid until the file is closed.
+     * @param arr Description of the data set
+     * @return Pointer to the first Byte of the data set, NULL if it can't be accessed in place
+     */
+    const char *GetRawData(const ArrayInfo &arr) const;
+
+    /*!
+     * \brief Returns typed pointer to the data set inside the mapped file (zero-copy access)
+     * @param arr Description of the data set
+     * @return Pointer to the first value, NULL if the data set can't be accessed in place, its type differs from T
+     * or the data set is not aligned for T (use ReadArray() then)
+     */
+    template<typename T>
+    inline const T *GetData(const ArrayInfo &arr) const;
+
+    /*!
+     * \brief Copies decoded data set into the buffer
+     * @param arr Description of the data set
+     * @param out Buffer of at least GetNumberOfBytes(arr) Bytes
+     * @return True if the data set was successfully decoded
+     */
+    bool ReadData(const ArrayInfo &arr, char *out);
+
+    /*!
+     * \brief Loads data set into the vector, the type of values should match the type of the data set
+     * @param arr Description of the data set
+     * @param data Output vector, resized to the number of values
+     * @return True if the data set was successfully loaded
+     */
+    template<typename T>
+    inline bool ReadArray(const ArrayInfo &arr, std::vector<T> &data);
+
+    /*!
+     * \brief Sets number of threads used to decode data (0 - use all available cores)
+     * @param _num_threads Number of threads
+     */
+    void SetNumberOfThreads(const size_t _num_threads);
+
+    /*!
+     * \brief Returns size of a value of the VTK type in Bytes, 0 for unknown types
+     * @param type Data type (Int32, Float32, ...)
+     */
+    static size_t GetTypeSize(const std::string &type);
+
+    /*!
+     * \brief Writes down files in all supported formats and checks that they are read back unchanged
+     * Covers appended data (raw, "UInt64" headers, compressed), data sets added by FieldAppender, the binary and
+     * ASCII formats and a file with two pieces. Files "roundtrip_*.vtu" are left in the working directory.
+     * @return True if all data sets were read back unchanged
+     */
+    static bool TestRoundTrip();
+
+private:
+    VTK_XML_Reader(const VTK_XML_Reader&);
+    VTK_XML_Reader &operator=(const VTK_XML_Reader&);
+
+    /*!
+     * \brief Parses the main body of the file, stops at the beginning of the appended data
+     * @return True if the main body is well-formed
+     */
+    bool Parse();
+
+    /*!
+     * \brief Reads integer of the header type at the given position of the file
+     */
+    size_t ReadHeaderInt(const char *pos) const;
+
+    /*!
+     * \brief Returns pool of threads used to decode data
+     */
+    ThreadPool *GetThreadPool();
+
+    /*!
+     * \brief Decompresses data set, the compression header starts at the given position
+     * @param pos Position of the compression header
+     * @param end End of the data available for the data set
+     * @param out Output buffer
+     * @param num_bytes Expected size of the decompressed data set
+     * @return True if all blocks were successfully decompressed
+     */
+    bool Decompress(const char *pos, const char *end, char *out, const size_t num_bytes);
+
+    /*!
+     * \brief Decodes the data set in the binary mode
+     * @param arr Description of the data set
+     * @param out Output buffer
+     * @param num_bytes Expected size of the decoded data set
+     * @return True if the data set was successfully decoded
+     */
+    bool DecodeBinary(const ArrayInfo &arr, char *out, const size_t num_bytes);
+
+    /*!
+     * \brief Parses the data set in the ASCII mode
+     * @param arr Description of the data set
+     * @param out Output buffer (NULL - only the number of values is counted)
+     * @return Number of values, std::numeric_limits<size_t>::max() in case of failure
+     */
+    size_t ParseAscii(const ArrayInfo &arr, char *out) const;
+
+    /*!
+     * \brief Swaps bytes of values if the byte order of the file differs from the one of the system
+     */
+    void SwapBytes(char *data, const size_t num_bytes, const size_t value_size) const;
+
+private:
+    std::string file_name;          //!< Name of the opened file
+    const char *file_data;          //!< Contents of the file (mapped or loaded)
+    size_t file_size;               //!< Size of the file in Bytes
+    bool mapped;                    //!< True if the file is mapped into memory
+    std::vector<char> storage;      //!< Contents of the file on systems without mmap()
+    size_t appended_start;          //!< Position of the appended data in the file (after the underscore)
+    std::string file_type;          //!< Type of the data set of the file
+    size_t header_type_size;        //!< Size of integers in headers of data sets
+    bool swap_bytes;                //!< True if the byte order of the file differs from the one of the system
+    std::shared_ptr<DataCompressor> compressor; //!< Compressor of the file, NULL if data is not compressed
+    std::vector<Element> elements;  //!< Elements of the main body
+    std::vector<ArrayInfo> arrays;  //!< Data sets of all pieces
+    size_t num_pieces;              //!< Number of pieces
+    std::shared_ptr<ThreadPool> pool; //!< Threads used to decode data, created on the first use
+    size_t num_threads;             //!< Number of threads of the pool (0 - all available cores)
+};
+
+} /* namespace xmlw */
+
+#include "XMLReader.inl"
+
+#endif /* XMLREADER_H_ */
@@ -0,0 +1,65 @@
+/************************************************************************************
+ *                                                                                  *
+ * MIT License                                                                      *
+ *                                                                                  *
+ * Copyright 2018 Maxim Masterov                                                    *
+ *                                                                                  *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy     *
+ * of this software and associated documentation files (the "Software"), to deal    *
+ * in the Software without restriction, including without limitation the rights     *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell        *
+ * copies of the Software, and to permit persons to whom the Software is            *
+ * furnished to do so, subject to the following conditions:                         *
+ *                                                                                  *
+ * The above copyright notice and this permission notice shall be included in       *
+ * all copies or substantial portions of the Software.                              *
+ *                                                                                  *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS          *
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE      *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER           *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING          *
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS     *
+ * IN THE SOFTWARE.                                                                 *
+ *                                                                                  *
+ ************************************************************************************/
+
+#ifndef XMLREADER_INL_
+#define XMLREADER_INL_
+
+#include <iostream>
+#include <cstdint>
+
+namespace xmlw {
+
+template<typename T>
+inline const T *VTK_XML_Reader::GetData(const ArrayInfo &arr) const {
+    const char *data = GetRawData(arr);
+    if (data == NULL || swap_bytes || arr.type != VTKTypeName<T>() || (uintptr_t)data % alignof(T) != 0)
+        return NULL;
+    return (const T*)data;
+}
+
+template<typename T>
+inline bool VTK_XML_Reader::ReadArray(const ArrayInfo &arr, std::vector<T> &data) {
+
+    if (arr.type != VTKTypeName<T>()) {
+        std::cerr << "Error! Data set " << arr.name << " is of type " << arr.type << ", not " << VTKTypeName<T>()
+                << ". See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    const size_t num_values = GetNumberOfValues(arr);
+    if (num_values % VTKNumberOfComponents<T>() != 0) {
+        std::cerr << "Error! Number of values of data set " << arr.name << " is not divisible by the number of "
+                << "components of the element. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    data.resize(num_values / VTKNumberOfComponents<T>());
+    return ReadData(arr, (char*)data.data());
+}
+
+}
+
+#endif /* XMLREADER_INL_ */
@@ -46,6 +46,8 @@ public:
     }
 };
 
+template<> struct VTKTypeTraits<Coord> : VTKComponentTraits<float, 3> { };
+
 void VTK_XML_Writer::TestUntructuredOutput() {
 
     std::ofstream os;
@@ -99,7 +101,7 @@ void VTK_XML_Writer::TestUntructuredOutput() {
     os.open("test.vtu", std::ios::out | std::ios::binary);
     std::string format = "appended";
     size_t bofs = 0;
-    size_t size_of_dt = 4;
+    size_t size_of_dt = wxml.GetHeaderTypeSize();
 
     /* Assemble the body */
     wxml.Header(ostr);
@@ -205,7 +207,7 @@ void VTK_XML_Writer::TestStructuredOutput() {
     os.open("test.vts", std::ios::out);// | std::ios::binary);
     std::string format = "appended";
     size_t bofs = 0;
-    size_t size_of_dt = 4;
+    size_t size_of_dt = wxml.GetHeaderTypeSize();
     std::string extent = "\"1 " + std::to_string(NI) + " 1 " + std::to_string(NJ) + " 1 " + std::to_string(NK) + "\"";
 
     /*
@@ -30,7 +30,18 @@
 #include <string>
 #include <fstream>
 #include <iostream>
-#include <typeinfo>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <type_traits>
+
+#include "ArrayViews.h"
+#include "AsciiEncoder.h"
+#include "Base64Encoder.h"
+#include "DataCompressor.h"
+#include "ThreadPool.h"
+#include "VTKTypeTraits.h"
+#include "WriterStats.h"
 
 namespace xmlw {
 
@@ -38,9 +49,9 @@ namespace xmlw {
  * \class VTK_XML_Writer
  * \brief XML writer for VTK files
  * One can consider two ways of writing XML files for VTK readers (like ParaView). First one is the simplest one
- * and consists of writing all data section by section in ASCII mode (the binary one requires Base64 encoding and is
- * a bit complicated). Using this way one has to perform next steps: open 'DataArray', write all data in, close
- * 'DataArray'. This method suffers from two major problems. First of all, ASCII files are usually large (if accuracy
+ * and consists of writing all data section by section in ASCII mode (or in the binary one, which requires Base64
+ * encoding, see WriteBinaryData()). Using this way one has to perform next steps: open 'DataArray', write all data in,
+ * close 'DataArray'. This method suffers from two major problems. First of all, ASCII files are usually large (if accuracy
  * is preserved). Second, it is quite hard to append data into the file (doable, but simply inconvenient), since one has
  * to preserve hierarchy of all already opened and closed sections. Another way to write XML files readable by VTK-based
  * software is to create a main body of the file, which will contain only info on data structures but will not contain
@@ -60,6 +71,13 @@ namespace xmlw {
  * where NNNN are 4-byte integers and D - represents a data. Note also, that in a case of appended data one has to take into
  * account presence of these additional 4 bytes when calculating offsets for 'DataArray' sections (for more information see
  * documentation of VTK file formats)
+ * A single data set larger than 4 GiB doesn't fit into a 4-byte integer. For such data sets the header type should be
+ * switched to "UInt64" (see SetHeaderType()), then each data set starts with 8-byte unsigned integer and the 'VTKFile'
+ * section gets the header_type="UInt64" attribute. Use GetHeaderTypeSize() instead of hard-coded 4 bytes when offsets
+ * are counted.
+ * Appended data can also be compressed (see SetCompressor() and DataCompressor). In this case each data set starts
+ * with the compression header instead of a single integer and offsets are known only after compression, so it is
+ * easier to use AppendedFileWriter, which compresses all data sets before the main body is written.
  */
 class VTK_XML_Writer {
 public:
@@ -74,6 +92,16 @@ public:
 
         indentation = "";
 
+        header_type = "UInt32";
+        header_type_size = sizeof(uint32_t);
+
+        num_threads = 0;
+        pipelining = false;
+
+        push_size = 0;
+        push_written = 0;
+        push_value_size = 0;
+
         if (IsLittleEndian())
             byte_order = "LittleEndian";
         else
@@ -97,18 +125,19 @@ public:
 
     /*!
      * \brief Returns string of a data type for VTK format
+     * The type is resolved at compile time (see VTKTypeTraits), unsupported types are rejected by the compiler.
      * \warning One should provide one raw value, not a container!
      */
     template <typename T>
     std::string CheckDataType(const T data);
 
     /*!
-     * \brief Opens the section
-     * @param str Name of the section
+     * \brief Opens the section, sections opened afterwards are indented by two more spaces
+     * @param str Name of the section (with attributes)
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenSection(std::string str, Stream &stream);
+    inline void OpenSection(const std::string &str, Stream &stream);
 
     /*!
      * \brief Opens and closes the section in one line
@@ -116,15 +145,15 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OneLineSection(std::string str, Stream &stream);
+    inline void OneLineSection(const std::string &str, Stream &stream);
 
     /*!
-     * \brief Closes the section
+     * \brief Closes the section and restores indentation of its opening line
      * @param str Name of the section
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void CloseSection(std::string str, Stream &stream);
+    inline void CloseSection(const std::string &str, Stream &stream);
 
     /*!
      * \brief Opens 'DataArray' section for binary output
@@ -136,10 +165,25 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenDataArrSection(const std::string type, const std::string name,
-            const size_t num_of_comp, const std::string format, const size_t offset,
+    inline void OpenDataArrSection(const std::string &type, const std::string &name,
+            const size_t num_of_comp, const std::string &format, const size_t offset,
             Stream &stream);
 
+    /*!
+     * \brief Opens 'DataArray' section for binary output with additional attributes
+     * @param type Data type (Int32, Float32, ...)
+     * @param name The name of the data set
+     * @param num_of_comp Number of components in each element of data
+     * @param format Format of data (ascii, binary, appended)
+     * @param offset Offset for appended data
+     * @param attributes Additional attributes, each one starting with a space (e.g. ' RangeMin="0"')
+     * @param stream Output stream
+     */
+    template<typename Stream>
+    inline void OpenDataArrSection(const std::string &type, const std::string &name,
+            const size_t num_of_comp, const std::string &format, const size_t offset,
+            const std::string &attributes, Stream &stream);
+
     /*!
      * \brief Opens 'PDataArray' section for binary output
      * @param type Data type (Int32, Float32, ...)
@@ -150,8 +194,8 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenPDataArrSection(const std::string type, const std::string name,
-            const size_t num_of_comp, const std::string format, const size_t offset,
+    inline void OpenPDataArrSection(const std::string &type, const std::string &name,
+            const size_t num_of_comp, const std::string &format, const size_t offset,
             Stream &stream);
 
     /*!
@@ -170,8 +214,8 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenDataArrSection(const std::string type, const std::string name,
-            const size_t num_of_comp, const std::string format, Stream &stream);
+    inline void OpenDataArrSection(const std::string &type, const std::string &name,
+            const size_t num_of_comp, const std::string &format, Stream &stream);
 
     /*!
      * \brief Closes 'DataArray' section
@@ -186,7 +230,7 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenVTKSection(const std::string type, Stream &stream);
+    inline void OpenVTKSection(const std::string &type, Stream &stream);
 
     /*!
      * \brief Closes 'VTK' section
@@ -217,7 +261,7 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenPointDataSection(const std::string name, Stream &stream);
+    inline void OpenPointDataSection(const std::string &name, Stream &stream);
 
     /*!
      * \brief Closes 'PointData' section
@@ -232,7 +276,7 @@ public:
      * @param stream Output stream
      */
     template<typename Stream>
-    inline void OpenPPointDataSection(const std::string name, Stream &stream);
+    inline void OpenPPointDataSection(const std::string &name, Stream &stream);
 
     /*!
      * \brief Closes 'PPointData' section
@@ -256,6 +300,17 @@ public:
     template<typename Stream>
     inline void CloseCoordinatesSection(Stream &stream);
 
+    /*!
+     * \brief Sets nesting level of sections written afterwards (e.g. when a fragment is inserted into a file)
+     * @param level Number of enclosing sections, each one adds two spaces of indentation
+     */
+    inline void SetIndentationLevel(const size_t level);
+
+    /*!
+     * \brief Returns nesting level of sections written afterwards
+     */
+    inline size_t GetIndentationLevel() const;
+
     /*!
      * \brief Writes the header of the XML file
      * @param stream Output stream
@@ -265,6 +320,7 @@ public:
 
     /*!
      * \brief Writes data into the stream
+     * Arrays of numbers are formatted by AsciiEncoder, other types are written down through the stream operator.
      * \note Class Data should be compatible with STL library
      * @param data Reference to the data set
      * @param stream Reference to the output stream
@@ -273,15 +329,94 @@ public:
     template<typename Data, typename Stream>
     inline size_t WriteData(Data &data, Stream &stream);
 
+    /*!
+     * \brief Writes data into the stream in the binary (base64) mode
+     * The header (length of the data or the compression header, if a compressor is set) and the data are encoded
+     * separately. 'DataArray' section should be opened with format="binary".
+     * \note Class Data should be compatible with STL library
+     * @param data Reference to the data set
+     * @param stream Output stream
+     * @return Number of written characters, 0 if the data set can't be compressed (nothing is written then)
+     */
+    template<typename Data, typename Stream>
+    inline size_t WriteBinaryData(Data &data, Stream &stream);
+
     /*!
      * \brief Appends data to the end of the file in a raw binary mode
+     * If a compressor is set the data is compressed first.
      * \note Doesn't put any closing statements
      * @param data Reference to the data set
      * @param stream Reference to the output stream
      * @param stream Output stream
+     * @return Number of written Bytes including the header, 0 if the data set can't be compressed (nothing is
+     * appended then, the offsets of the following data sets are invalid)
      */
     template<typename Data, typename Stream>
-    inline void AppendData(Data &data, Stream &stream);
+    inline size_t AppendData(Data &data, Stream &stream);
+
+    /*!
+     * \brief Appends strided data set to the end of the file in a raw binary mode
+     * Values are interleaved on the fly through a bounded buffer, see AppendData() for details.
+     * @param view View of the data set
+     * @param stream Output stream
+     * @return Number of written Bytes including the header
+     */
+    template<typename T, typename Stream>
+    inline size_t AppendData(const StridedView<T> view, Stream &stream);
+
+    /*!
+     * \brief Appends data set stored as a structure of arrays to the end of the file in a raw binary mode
+     * Components are interleaved on the fly through a bounded buffer, see AppendData() for details.
+     * @param view View of the data set
+     * @param stream Output stream
+     * @return Number of written Bytes including the header
+     */
+    template<typename T, typename Stream>
+    inline size_t AppendData(const SoAView<T> view, Stream &stream);
+
+    /*!
+     * \brief Appends data set computed on the fly to the end of the file in a raw binary mode
+     * Values are computed by chunks of a bounded size, see AppendData() for details.
+     * @param view View of the data set
+     * @param stream Output stream
+     * @return Number of written Bytes including the header
+     */
+    template<typename T, typename Stream>
+    inline size_t AppendData(const GeneratedView<T> view, Stream &stream);
+
+    /*!
+     * \brief Starts appending a data set supplied by chunks (see PushData())
+     * The size of the data set is declared in advance, so the offset of the next data set is known before any value
+     * is computed: the data set occupies num_values * sizeof(T) Bytes plus the header, the same as CountOffset()
+     * returns for the whole data set. Chunks are written to the stream as soon as they are pushed, the data set
+     * never exists in memory as a whole. Compressed data sets can't be appended this way, their size is unknown in
+     * advance.
+     * @param num_values Number of values (tuples times components)
+     * @param stream Output stream
+     * @return True if the data set is started
+     */
+    template<typename T, typename Stream>
+    inline bool BeginAppendData(const size_t num_values, Stream &stream);
+
+    /*!
+     * \brief Appends next chunk of the data set started by BeginAppendData()
+     * @param values Pointer to the first value of the chunk
+     * @param count Number of values in the chunk
+     * @param stream Output stream
+     * @return False if no data set is started or the chunk exceeds the declared size
+     */
+    template<typename T, typename Stream>
+    inline bool PushData(const T *values, const size_t count, Stream &stream);
+
+    /*!
+     * \brief Finishes the data set started by BeginAppendData()
+     * If fewer values than declared were pushed the rest is filled with zeros, so the offsets of the following data
+     * sets stay valid.
+     * @param stream Output stream
+     * @return Number of written Bytes including the header
+     */
+    template<typename Stream>
+    inline size_t EndAppendData(Stream &stream);
 
     /*!
      * \brief Counts size of the data set in Bytes
@@ -294,6 +429,17 @@ public:
     template<typename Data>
     inline size_t CountOffset(Data &data);
 
+    /*!
+     * \brief Counts size of the viewed data set in Bytes
+     * @param view View of the data set
+     */
+    template<typename T>
+    inline size_t CountOffset(const StridedView<T> view);
+    template<typename T>
+    inline size_t CountOffset(const SoAView<T> view);
+    template<typename T>
+    inline size_t CountOffset(const GeneratedView<T> view);
+
     /*!
      * \brief Counts size of the grid in Bytes
      * This method is a safe form of the CountOffset() one, since sizeof() for the grid structure
@@ -316,17 +462,152 @@ public:
      */
     inline void SetVTKVersion(const std::string _version);
 
+    /*!
+     * \brief Sets type of integers preceding each data set in the appended section
+     * @param _type Header type, "UInt32" (default) or "UInt64"
+     */
+    inline void SetHeaderType(const std::string _type);
+
+    /*!
+     * \brief Returns type of integers preceding each data set in the appended section
+     */
+    inline const std::string &GetHeaderType() const;
+
+    /*!
+     * \brief Returns size of integers preceding each data set in the appended section in Bytes
+     */
+    inline size_t GetHeaderTypeSize() const;
+
+    /*!
+     * \brief Sets number of values written in one line in the ASCII mode (0 - all values in one line)
+     * @param values_per_line Number of values
+     */
+    inline void SetAsciiValuesPerLine(const size_t values_per_line);
+
+    /*!
+     * \brief Sets compressor of appended data
+     * @param name VTK name of the compressor ("vtkZLibDataCompressor", "vtkLZ4DataCompressor"),
+     * empty string switches compression off
+     * @param level Compression level (-1 - default level of the library)
+     */
+    inline void SetCompressor(const std::string name, const int level = -1);
+
+    /*!
+     * \brief Returns compressor of appended data, NULL if data is not compressed
+     */
+    inline const DataCompressor *GetCompressor() const;
+
+    /*!
+     * \brief Sets size of uncompressed blocks in Bytes
+     * @param block_size Size of blocks
+     */
+    inline void SetCompressionBlockSize(const size_t block_size);
+
+    /*!
+     * \brief Sets number of threads used to encode data (0 - use all available cores)
+     * @param _num_threads Number of threads
+     */
+    inline void SetNumberOfThreads(const size_t _num_threads);
+
+    /*!
+     * \brief Returns pool of threads used to encode data
+     */
+    inline ThreadPool *GetThreadPool();
+
+    /*!
+     * \brief Enables encoding of data sets ahead of writing them
+     * ASCII data sets are formatted by chunks on the pool of threads while formatted chunks are written, compressed
+     * data sets of AppendedFileWriter are compressed a few data sets ahead of the one being written. Offsets of
+     * the compressed data sets are not known before they are written, so the main body of the file is written
+     * last and may contain trailing blanks.
+     * @param _pipelining True to enable pipelining (false by default)
+     */
+    inline void SetPipelining(const bool _pipelining);
+
+    /*!
+     * \brief Returns true if encoding of data sets is pipelined
+     */
+    inline bool GetPipelining() const;
+
+    /*!
+     * \brief Returns statistics of the last written file (empty unless built with XMLW_WITH_STATS)
+     */
+    inline const WriterStats &GetStats() const;
+
+    /*!
+     * \brief Sets all statistics to zero
+     */
+    inline void ResetStats();
+
+    /*!
+     * \brief Sets function called with statistics of every written file (builds with XMLW_WITH_STATS only)
+     * The function is called by the thread which writes the file (see AsyncWriter).
+     * @param callback Function to call, empty function disables reporting
+     */
+    inline void SetStatsCallback(const StatsCallback callback);
+
+protected:
+    /*!
+     * \brief Passes statistics to the callback, if any
+     */
+    inline void ReportStats() const;
+
+    WriterStats stats;                  //!< Statistics of the last written file
+    StatsCallback stats_callback;       //!< Function called with statistics of every written file
+
 private:
+    /*!
+     * \brief Writes unsigned integer without locale-aware formatting of the stream
+     */
+    template<typename Stream>
+    inline void WriteInteger(const size_t value, Stream &stream);
+
     /*!
      * \brief Returns true if system has little-endian byte order (false otherwise)
      */
     inline bool IsLittleEndian();
 
+    /*!
+     * \brief Writes array of numbers in the ASCII mode (see IsAsciiEncodable)
+     */
+    template<typename Data, typename Stream>
+    inline void WriteAscii(Data &data, Stream &stream, std::true_type);
+
+    /*!
+     * \brief Writes array of arbitrary elements in the ASCII mode using the stream operator
+     */
+    template<typename Data, typename Stream>
+    inline void WriteAscii(Data &data, Stream &stream, std::false_type);
+
+    /*!
+     * \brief Writes the leading integer with the size of the data set (uncompressed appended data)
+     */
+    template<typename Stream>
+    inline void AppendHeader(const size_t size, Stream &stream);
+
+    /*!
+     * \brief Appends data set generated on the fly by chunks of a bounded size
+     * @return Number of written Bytes including the header, 0 if the data set can't be compressed
+     */
+    template<typename Stream>
+    inline size_t AppendGenerated(const FillFunction &fill, const size_t size, Stream &stream);
+
 private:
     std::string indentation;
     std::string xml_version;
     std::string vtk_version;
     std::string byte_order;
+    std::string header_type;
+    size_t header_type_size;
+    std::shared_ptr<DataCompressor> compressor;
+    std::shared_ptr<ThreadPool> pool;
+    size_t num_threads;
+    bool pipelining;                //!< Data sets are encoded ahead of writing them
+    size_t push_size;               //!< Declared size of the data set supplied by chunks in Bytes
+    size_t push_written;            //!< Bytes of the data set supplied by chunks written so far
+    size_t push_value_size;         //!< Size of values of the data set supplied by chunks (0 - none started)
+    AsciiEncoder ascii_encoder;
+    Base64Encoder base64_encoder;
 };
 
 } /* namespace xmlw */
@@ -27,6 +27,9 @@
 #ifndef XMLWRITER_INL_
 #define XMLWRITER_INL_
 
+#include <limits>
+#include <algorithm>
+
 namespace xmlw {
 
 inline bool VTK_XML_Writer::IsLittleEndian() {
@@ -36,50 +39,60 @@ inline bool VTK_XML_Writer::IsLittleEndian() {
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenSection(std::string str, Stream &stream) {
-    str = indentation + "<" + str + ">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+inline void VTK_XML_Writer::WriteInteger(const size_t value, Stream &stream) {
+    char digits[32];
+    stream.write(digits, AsciiEncoder::Format(value, digits) - digits);
+}
+
+template<typename Stream>
+inline void VTK_XML_Writer::OpenSection(const std::string &str, Stream &stream) {
+    stream << indentation << "<" << str << ">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OneLineSection(std::string str, Stream &stream) {
-    str = indentation + "<" + str + "/>\n";
-    //indentation.append(2, ' ');
-    stream << str;
+inline void VTK_XML_Writer::OneLineSection(const std::string &str, Stream &stream) {
+    stream << indentation << "<" << str << "/>\n";
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::CloseSection(std::string str, Stream &stream) {
-    //indentation.erase(indentation.length() - 2);
-    str = indentation + "</" + str + ">\n";
-    stream << str;
+inline void VTK_XML_Writer::CloseSection(const std::string &str, Stream &stream) {
+    if (indentation.length() >= 2)
+        indentation.erase(indentation.length() - 2);
+    stream << indentation << "</" << str << ">\n";
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenDataArrSection(const std::string type, const std::string name,
-        const size_t num_of_comp, const std::string format, const size_t offset,
+inline void VTK_XML_Writer::OpenDataArrSection(const std::string &type, const std::string &name,
+        const size_t num_of_comp, const std::string &format, const size_t offset,
         Stream &stream) {
+    OpenDataArrSection(type, name, num_of_comp, format, offset, std::string(), stream);
+}
 
-    std::string str;
-    str = indentation + "<DataArray type=\"" + type + "\" Name=\"" + name
-            + "\" NumberOfComponents=\"" + std::to_string(num_of_comp) + "\" format=\"" + format
-            + "\" offset=\"" + std::to_string(offset) + "\"" + ">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+template<typename Stream>
+inline void VTK_XML_Writer::OpenDataArrSection(const std::string &type, const std::string &name,
+        const size_t num_of_comp, const std::string &format, const size_t offset,
+        const std::string &attributes, Stream &stream) {
+
+    stream << indentation << "<DataArray type=\"" << type << "\" Name=\"" << name << "\" NumberOfComponents=\"";
+    WriteInteger(num_of_comp, stream);
+    stream << "\" format=\"" << format << "\" offset=\"";
+    WriteInteger(offset, stream);
+    stream << "\"" << attributes << ">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenPDataArrSection(const std::string type, const std::string name,
-        const size_t num_of_comp, const std::string format, const size_t offset,
+inline void VTK_XML_Writer::OpenPDataArrSection(const std::string &type, const std::string &name,
+        const size_t num_of_comp, const std::string &format, const size_t offset,
         Stream &stream) {
 
-    std::string str;
-    str = indentation + "<PDataArray type=\"" + type + "\" Name=\"" + name
-            + "\" NumberOfComponents=\"" + std::to_string(num_of_comp) + "\" format=\"" + format
-            + "\" offset=\"" + std::to_string(offset) + "\"" + ">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+    stream << indentation << "<PDataArray type=\"" << type << "\" Name=\"" << name << "\" NumberOfComponents=\"";
+    WriteInteger(num_of_comp, stream);
+    stream << "\" format=\"" << format << "\" offset=\"";
+    WriteInteger(offset, stream);
+    stream << "\">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
@@ -88,15 +101,13 @@ inline void VTK_XML_Writer::ClosePDataArrSection(Stream &stream) {
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenDataArrSection(const std::string type, const std::string name,
-        const size_t num_of_comp, const std::string format, Stream &stream) {
+inline void VTK_XML_Writer::OpenDataArrSection(const std::string &type, const std::string &name,
+        const size_t num_of_comp, const std::string &format, Stream &stream) {
 
-    std::string str;
-    str = indentation + "<DataArray type=\"" + type + "\" Name=\"" + name
-            + "\" NumberOfComponents=\"" + std::to_string(num_of_comp) + "\" format=\"" + format
-            + "\"" + ">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+    stream << indentation << "<DataArray type=\"" << type << "\" Name=\"" << name << "\" NumberOfComponents=\"";
+    WriteInteger(num_of_comp, stream);
+    stream << "\" format=\"" << format << "\">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
@@ -105,12 +116,15 @@ inline void VTK_XML_Writer::CloseDataArrSection(Stream &stream) {
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenVTKSection(const std::string type, Stream &stream) {
-    std::string str;
-    str = indentation + "<VTKFile type=\"" + type + "\" version=\"" + vtk_version
-            + "\" byte_order=\"" + byte_order + "\">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+inline void VTK_XML_Writer::OpenVTKSection(const std::string &type, Stream &stream) {
+    stream << indentation << "<VTKFile type=\"" << type << "\" version=\"" << vtk_version
+            << "\" byte_order=\"" << byte_order << "\"";
+    if (header_type_size != sizeof(uint32_t))
+        stream << " header_type=\"" << header_type << "\"";
+    if (compressor)
+        stream << " compressor=\"" << compressor->GetName() << "\"";
+    stream << ">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
@@ -120,11 +134,12 @@ inline void VTK_XML_Writer::CloseVTKSection(Stream &stream) {
 
 template<typename Stream>
 inline void VTK_XML_Writer::OpenPieceSection(const size_t num_points, const size_t num_cells, Stream &stream) {
-    std::string str;
-    str = indentation + "<Piece NumberOfPoints=\"" + std::to_string(num_points)
-            + "\" NumberOfCells=\"" + std::to_string(num_cells) + "\">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+    stream << indentation << "<Piece NumberOfPoints=\"";
+    WriteInteger(num_points, stream);
+    stream << "\" NumberOfCells=\"";
+    WriteInteger(num_cells, stream);
+    stream << "\">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
@@ -133,11 +148,9 @@ inline void VTK_XML_Writer::ClosePieceSection(Stream &stream) {
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenPointDataSection(const std::string name, Stream &stream) {
-    std::string str;
-    str = indentation + "<PointData Scalars=\"" + name + "\">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+inline void VTK_XML_Writer::OpenPointDataSection(const std::string &name, Stream &stream) {
+    stream << indentation << "<PointData Scalars=\"" << name << "\">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
@@ -146,11 +159,9 @@ inline void VTK_XML_Writer::ClosePointDataSection(Stream &stream) {
 }
 
 template<typename Stream>
-inline void VTK_XML_Writer::OpenPPointDataSection(const std::string name, Stream &stream) {
-    std::string str;
-    str = indentation + "<PPointData Scalars=\"" + name + "\">\n";
-    //indentation.append(2, ' ');
-    stream << str;
+inline void VTK_XML_Writer::OpenPPointDataSection(const std::string &name, Stream &stream) {
+    stream << indentation << "<PPointData Scalars=\"" << name << "\">\n";
+    indentation.append(2, ' ');
 }
 
 template<typename Stream>
@@ -168,6 +179,14 @@ inline void VTK_XML_Writer::CloseCoordinatesSection(Stream &stream) {
     CloseSection("Coordinates", stream);
 }
 
+inline void VTK_XML_Writer::SetIndentationLevel(const size_t level) {
+    indentation.assign(2 * level, ' ');
+}
+
+inline size_t VTK_XML_Writer::GetIndentationLevel() const {
+    return indentation.length() / 2;
+}
+
 template<typename Stream>
 inline void VTK_XML_Writer::Header(Stream &stream) {
     stream << "<?xml version=\"" + xml_version + "\"?>\n";
@@ -175,18 +194,240 @@ inline void VTK_XML_Writer::Header(Stream &stream) {
 
 template<typename Data, typename Stream>
 inline size_t VTK_XML_Writer::WriteData(Data &data, Stream &stream) {
+    typedef typename std::decay<decltype(data[0])>::type value_type;
+    XMLW_STATS(stats.arrays.push_back(ArrayStats()); StatsTimer timer(stats.arrays.back().write_time);)
+    WriteAscii(data, stream, std::integral_constant<bool, IsAsciiEncodable<value_type>::value>());
+    XMLW_STATS(++stats.num_writes;)
+    return CountOffset(data);
+}
+
+template<typename Data, typename Stream>
+inline void VTK_XML_Writer::WriteAscii(Data &data, Stream &stream, std::true_type) {
+    const size_t size = data.size();
+    ascii_encoder.Encode(size != 0 ? &data[0] : NULL, size, stream, pipelining ? GetThreadPool() : NULL);
+}
+
+template<typename Data, typename Stream>
+inline void VTK_XML_Writer::WriteAscii(Data &data, Stream &stream, std::false_type) {
     const size_t size = data.size();
     for(size_t n = 0; n < size; ++n)
         stream << data[n] << " ";
     stream << "\n";
-    return CountOffset(data);
 }
 
 template<typename Data, typename Stream>
-inline void VTK_XML_Writer::AppendData(Data &data, Stream &stream) {
-    uint32_t size = sizeof(data[0]) * data.size();
-    stream.write((char*)&size, sizeof(uint32_t));
-    stream.write((char*)data.data(), size);
+inline size_t VTK_XML_Writer::WriteBinaryData(Data &data, Stream &stream) {
+    const size_t size = sizeof(data[0]) * data.size();
+    const char *ptr = (const char*)data.data();
+    size_t written = 0;
+    XMLW_STATS(stats.arrays.push_back(ArrayStats()); ArrayStats &array_stats = stats.arrays.back();)
+
+    if (compressor) {
+        std::vector<char> buffer;
+        const size_t num_blocks = (size + compressor->GetBlockSize() - 1) / compressor->GetBlockSize();
+        const size_t header_size = (3 + num_blocks) * header_type_size;
+        {
+            XMLW_STATS(StatsTimer timer(array_stats.encode_time);)
+            if (compressor->Compress(ptr, size, header_type_size, buffer, GetThreadPool()) == 0) {
+                std::cerr << "Error! Data set can't be compressed, nothing is written. See "
+                        << __FILE__ << ":" << __LINE__ << "\n";
+                return 0;
+            }
+        }
+        XMLW_STATS(StatsTimer timer(array_stats.write_time);)
+        written += base64_encoder.Write(buffer.data(), header_size, stream);
+        written += base64_encoder.Write(buffer.data() + header_size, buffer.size() - header_size, stream);
+    }
+    else {
+        uint64_t header64 = size;
+        uint32_t header32 = size;
+        const char *header = (header_type_size == sizeof(uint64_t)) ? (const char*)&header64 : (const char*)&header32;
+        XMLW_STATS(StatsTimer timer(array_stats.write_time);)
+        written += base64_encoder.Write(header, header_type_size, stream);
+        written += base64_encoder.Write(ptr, size, stream);
+    }
+    stream << "\n";
+    XMLW_STATS(array_stats.bytes = written; stats.payload_bytes += written; ++stats.num_writes;)
+
+    return written;
+}
+
+template<typename Data, typename Stream>
+inline size_t VTK_XML_Writer::AppendData(Data &data, Stream &stream) {
+    const size_t size = sizeof(data[0]) * data.size();
+    XMLW_STATS(stats.arrays.push_back(ArrayStats()); ArrayStats &array_stats = stats.arrays.back();)
+    if (compressor) {
+        std::vector<char> buffer;
+        {
+            XMLW_STATS(StatsTimer timer(array_stats.encode_time);)
+            if (compressor->Compress((const char*)data.data(), size, header_type_size, buffer,
+                    GetThreadPool()) == 0) {
+                std::cerr << "Error! Data set can't be compressed, nothing is appended. See "
+                        << __FILE__ << ":" << __LINE__ << "\n";
+                return 0;
+            }
+        }
+        {
+            XMLW_STATS(StatsTimer timer(array_stats.write_time);)
+            stream.write(buffer.data(), buffer.size());
+        }
+        XMLW_STATS(array_stats.bytes = buffer.size(); stats.payload_bytes += buffer.size(); ++stats.num_writes;)
+        return buffer.size();
+    }
+    {
+        XMLW_STATS(StatsTimer timer(array_stats.write_time);)
+        AppendHeader(size, stream);
+        stream.write((char*)data.data(), size);
+    }
+    XMLW_STATS(array_stats.bytes = size + header_type_size; stats.payload_bytes += array_stats.bytes;
+            stats.num_writes += 2;)
+    return size + header_type_size;
+}
+
+template<typename T, typename Stream>
+inline size_t VTK_XML_Writer::AppendData(const StridedView<T> view, Stream &stream) {
+    return AppendGenerated([&view](size_t offset, size_t size, char *out) { view.Fill(offset, size, out); },
+            sizeof(T) * view.size(), stream);
+}
+
+template<typename T, typename Stream>
+inline size_t VTK_XML_Writer::AppendData(const SoAView<T> view, Stream &stream) {
+    return AppendGenerated([&view](size_t offset, size_t size, char *out) { view.Fill(offset, size, out); },
+            sizeof(T) * view.size(), stream);
+}
+
+template<typename T, typename Stream>
+inline size_t VTK_XML_Writer::AppendData(const GeneratedView<T> view, Stream &stream) {
+    return AppendGenerated([&view](size_t offset, size_t size, char *out) { view.Fill(offset, size, out); },
+            sizeof(T) * view.size(), stream);
+}
+
+template<typename T, typename Stream>
+inline bool VTK_XML_Writer::BeginAppendData(const size_t num_values, Stream &stream) {
+    if (push_value_size != 0) {
+        std::cerr << "Error! Previous data set supplied by chunks isn't finished, call EndAppendData(). See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    if (compressor) {
+        std::cerr << "Error! Data sets supplied by chunks can't be compressed. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    push_size = sizeof(T) * num_values;
+    push_written = 0;
+    push_value_size = sizeof(T);
+    XMLW_STATS(stats.arrays.push_back(ArrayStats()); StatsTimer timer(stats.arrays.back().write_time);
+            ++stats.num_writes;)
+    AppendHeader(push_size, stream);
+    return true;
+}
+
+template<typename T, typename Stream>
+inline bool VTK_XML_Writer::PushData(const T *values, const size_t count, Stream &stream) {
+    if (push_value_size != sizeof(T)) {
+        std::cerr << "Error! No data set of " << sizeof(T) << "-Byte values is started, call BeginAppendData(). See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+    const size_t size = sizeof(T) * count;
+    if (size > push_size - push_written) {
+        std::cerr << "Error! " << count << " values exceed the declared size of the data set. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return false;
+    }
+
+    XMLW_STATS(
+        if (stats.arrays.empty())
+            stats.arrays.push_back(ArrayStats());
+        StatsTimer timer(stats.arrays.back().write_time);
+        ++stats.num_writes;
+    )
+    stream.write((const char*)values, size);
+    push_written += size;
+    return true;
+}
+
+template<typename Stream>
+inline size_t VTK_XML_Writer::EndAppendData(Stream &stream) {
+    if (push_value_size == 0) {
+        std::cerr << "Error! No data set supplied by chunks is started. See " << __FILE__ << ":" << __LINE__ << "\n";
+        return 0;
+    }
+
+    if (push_written != push_size) {
+        std::cerr << "Error! " << (push_size - push_written) / push_value_size << " values of the data set are "
+                << "missing, zeros are written instead. See " << __FILE__ << ":" << __LINE__ << "\n";
+        const std::vector<char> zeros(std::min<size_t>(push_size - push_written, size_t(1) << 20), 0);
+        for(size_t left = push_size - push_written; left != 0; ) {
+            const size_t n = std::min(left, zeros.size());
+            stream.write(zeros.data(), n);
+            left -= n;
+        }
+    }
+
+    XMLW_STATS(
+        if (!stats.arrays.empty())
+            stats.arrays.back().bytes = push_size + header_type_size;
+        stats.payload_bytes += push_size + header_type_size;
+    )
+    push_value_size = 0;
+    return push_size + header_type_size;
+}
+
+template<typename Stream>
+inline void VTK_XML_Writer::AppendHeader(const size_t size, Stream &stream) {
+    if (header_type_size == sizeof(uint64_t)) {
+        uint64_t header = size;
+        stream.write((char*)&header, sizeof(uint64_t));
+    }
+    else {
+        if (size > std::numeric_limits<uint32_t>::max())
+            std::cerr << "Error! Data set of " << size << " Bytes doesn't fit into UInt32 header, "
+                    << "use SetHeaderType(\"UInt64\"). See " << __FILE__ << ":" << __LINE__ << "\n";
+        uint32_t header = size;
+        stream.write((char*)&header, sizeof(uint32_t));
+    }
+}
+
+template<typename Stream>
+inline size_t VTK_XML_Writer::AppendGenerated(const FillFunction &fill, const size_t size, Stream &stream) {
+    XMLW_STATS(stats.arrays.push_back(ArrayStats()); ArrayStats &array_stats = stats.arrays.back();)
+    if (compressor) {
+        std::vector<char> buffer;
+        {
+            XMLW_STATS(StatsTimer timer(array_stats.encode_time);)
+            if (compressor->Compress(fill, size, header_type_size, buffer, GetThreadPool()) == 0) {
+                std::cerr << "Error! Data set can't be compressed, nothing is appended. See "
+                        << __FILE__ << ":" << __LINE__ << "\n";
+                return 0;
+            }
+        }
+        {
+            XMLW_STATS(StatsTimer timer(array_stats.write_time);)
+            stream.write(buffer.data(), buffer.size());
+        }
+        XMLW_STATS(array_stats.bytes = buffer.size(); stats.payload_bytes += buffer.size(); ++stats.num_writes;)
+        return buffer.size();
+    }
+
+    AppendHeader(size, stream);
+    XMLW_STATS(++stats.num_writes;)
+
+    const size_t max_chunk = size_t(1) << 20;
+    std::unique_ptr<char[]> chunk(new char[size < max_chunk ? size + 1 : max_chunk]);
+    for(size_t pos = 0; pos < size; pos += max_chunk) {
+        const size_t n = (size - pos < max_chunk) ? size - pos : max_chunk;
+        {
+            XMLW_STATS(StatsTimer timer(array_stats.encode_time);)
+            fill(pos, n, chunk.get());
+        }
+        XMLW_STATS(StatsTimer timer(array_stats.write_time); ++stats.num_writes;)
+        stream.write(chunk.get(), n);
+    }
+    XMLW_STATS(array_stats.bytes = size + header_type_size; stats.payload_bytes += array_stats.bytes;)
+    return size + header_type_size;
 }
 
 template<typename Data>
@@ -195,6 +436,21 @@ inline size_t VTK_XML_Writer::CountOffset(Data &data) {
     return sizeof(data.at(0)) * size;
 }
 
+template<typename T>
+inline size_t VTK_XML_Writer::CountOffset(const StridedView<T> view) {
+    return sizeof(T) * view.size();
+}
+
+template<typename T>
+inline size_t VTK_XML_Writer::CountOffset(const SoAView<T> view) {
+    return sizeof(T) * view.size();
+}
+
+template<typename T>
+inline size_t VTK_XML_Writer::CountOffset(const GeneratedView<T> view) {
+    return sizeof(T) * view.size();
+}
+
 template<typename Data>
 inline size_t VTK_XML_Writer::CountOffsetGrid(Data &data) {
     const size_t size = data.size();
@@ -209,51 +465,103 @@ inline void VTK_XML_Writer::SetVTKVersion(const std::string _version) {
     vtk_version = _version;
 }
 
-template <typename T>
-inline std::string VTK_XML_Writer::CheckDataType(const T data) {
-
-    // Types supported by VTK
-    //    Int8, UInt8, Int16, UInt16, Int32,
-    //    UInt32, Int64, UInt64, Float32, Float64
-
-    std::string type;
-
-    if ( typeid(data).name() == typeid(float).name() ) {
-        type = "Float32";
-    }
-    if ( typeid(data).name() == typeid(double).name() ) {
-        type = "Float64";
+inline void VTK_XML_Writer::SetHeaderType(const std::string _type) {
+    if (_type == "UInt32") {
+        header_type_size = sizeof(uint32_t);
     }
-    if ( typeid(data).name() == typeid(int).name() ) {
-        type = "Int32";
+    else if (_type == "UInt64") {
+        header_type_size = sizeof(uint64_t);
     }
-    if ( typeid(data).name() == typeid(uint8_t).name() ) {
-        type = "UInt8";
+    else {
+        std::cerr << "Error! Unsupported header type : " << _type << ". See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        return;
     }
-    if ( typeid(data).name() == typeid(uint16_t).name() ) {
-        type = "UInt16";
-    }
-    if ( typeid(data).name() == typeid(uint32_t).name() ) {
-        type = "UInt32";
-    }
-    if ( typeid(data).name() == typeid(size_t).name() ) {
-        if (sizeof(size_t) == 8)
-            type = "UInt64";
-        if (sizeof(size_t) == 4)
-            type = "UInt32";
+    header_type = _type;
+}
+
+inline const std::string &VTK_XML_Writer::GetHeaderType() const {
+    return header_type;
+}
+
+inline size_t VTK_XML_Writer::GetHeaderTypeSize() const {
+    return header_type_size;
+}
+
+inline void VTK_XML_Writer::SetAsciiValuesPerLine(const size_t values_per_line) {
+    ascii_encoder.SetValuesPerLine(values_per_line);
+}
+
+inline void VTK_XML_Writer::SetCompressor(const std::string name, const int level) {
+    const size_t block_size = compressor ? compressor->GetBlockSize() : 0;
+
+    if (name.empty()) {
+        compressor.reset();
+        return;
     }
-    if ( typeid(data).name() == typeid(long).name() ) {
-        if (sizeof(long) == 8)
-            type = "UInt64";
-        if (sizeof(long) == 4)
-            type = "UInt32";
+    if (!DataCompressor::IsSupported(name)) {
+        std::cerr << "Error! Compressor " << name << " is not supported by this build, data will not be compressed. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+        compressor.reset();
+        return;
     }
+    compressor = std::make_shared<DataCompressor>(name, level);
+    if (block_size != 0)
+        compressor->SetBlockSize(block_size);
+}
+
+inline const DataCompressor *VTK_XML_Writer::GetCompressor() const {
+    return compressor.get();
+}
+
+inline void VTK_XML_Writer::SetCompressionBlockSize(const size_t block_size) {
+    if (compressor)
+        compressor->SetBlockSize(block_size);
+    else
+        std::cerr << "Error! Compressor should be set before the size of blocks. See "
+                << __FILE__ << ":" << __LINE__ << "\n";
+}
+
+inline void VTK_XML_Writer::SetNumberOfThreads(const size_t _num_threads) {
+    if (pool && num_threads != _num_threads)
+        pool.reset();
+    num_threads = _num_threads;
+}
+
+inline ThreadPool *VTK_XML_Writer::GetThreadPool() {
+    if (!pool)
+        pool = std::make_shared<ThreadPool>(num_threads);
+    return pool.get();
+}
+
+inline void VTK_XML_Writer::SetPipelining(const bool _pipelining) {
+    pipelining = _pipelining;
+}
 
-    if (type.empty())
-        std::cerr << "Error! Unknown data type : " << typeid(data).name() << " of size of "
-                << sizeof(data) << " Bytes. See " << __FILE__ << ":" << __LINE__ << "\n";
+inline bool VTK_XML_Writer::GetPipelining() const {
+    return pipelining;
+}
 
-    return type;
+inline const WriterStats &VTK_XML_Writer::GetStats() const {
+    return stats;
+}
+
+inline void VTK_XML_Writer::ResetStats() {
+    stats.Reset();
+}
+
+inline void VTK_XML_Writer::SetStatsCallback(const StatsCallback callback) {
+    stats_callback = callback;
+}
+
+inline void VTK_XML_Writer::ReportStats() const {
+    if (stats_callback)
+        stats_callback(stats);
+}
+
+template <typename T>
+inline std::string VTK_XML_Writer::CheckDataType(const T) {
+    return VTKTypeName<T>();
 }
 
 }
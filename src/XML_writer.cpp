@@ -25,21 +25,48 @@
  ************************************************************************************/
 
 #include "XMLWriter.h"
+#include "XMLReader.h"
+#ifdef XMLW_WITH_MPI
+#include "ParallelWriter.h"
+#endif
 
 using namespace std;
 
-int main() {
+int main(int argc, char **argv) {
 
-    xmlw::VTK_XML_Writer my_xml;
+    int rank = 0;
+    bool status = true;
 
-    my_xml.TestStructuredOutput();
-    // or
-//    my_xml.TestUnstructuredOutput();
+#ifdef XMLW_WITH_MPI
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+#endif
 
-//    long data;
-//    std::cout << "My type: " << my_xml.CheckDataType(data) << "\n";
+    /* Serial tests write the same files, so only one rank runs them */
+    if (rank == 0) {
+        xmlw::VTK_XML_Writer my_xml;
 
-	return 0;
-}
+        my_xml.TestStructuredOutput();
+        // or
+//        my_xml.TestUnstructuredOutput();
+
+//        long data;
+//        std::cout << "My type: " << my_xml.CheckDataType(data) << "\n";
+
+        /* Files of all formats should be read back unchanged */
+        status = xmlw::VTK_XML_Reader::TestRoundTrip();
+        std::cout << (status ? "Round-trip test passed\n" : "Round-trip test failed\n");
+    }
 
+#ifdef XMLW_WITH_MPI
+    /* Pieces written by all ranks should be read back unchanged */
+    const bool parallel_status = xmlw::ParallelWriter::TestParallelOutput();
+    if (rank == 0)
+        std::cout << (parallel_status ? "Parallel test passed\n" : "Parallel test failed\n");
+    status = status && parallel_status;
 
+    MPI_Finalize();
+#endif
+
+	return status ? 0 : 1;
+}